@@ -0,0 +1,105 @@
+/**
+ * Central force with MPI
+ *
+ * This example runs a central force on a ring of test particles around a star with REBOUND's MPI tree code,
+ * where each rank only holds the particles in its part of the domain. The star (the source of the central force)
+ * lives on one rank, and the test particles move between ranks as they orbit, taking their parameters with them.
+ *
+ * Each particle starts on the circular orbit that accounts for the central force, so it should stay at its initial radius
+ * (stored as a particle parameter). Compile and run with, e.g.,
+ *
+ *     make && mpirun -np 2 ./rebound
+ *
+ * The number of ranks must divide the number of root boxes (4 here). Exits with a nonzero status if the check fails.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+
+int main(int argc, char* argv[]){
+    struct reb_simulation* sim = reb_simulation_create();
+    sim->integrator = REB_INTEGRATOR_LEAPFROG;
+    sim->gravity = REB_GRAVITY_TREE;
+    sim->boundary = REB_BOUNDARY_OPEN;
+    sim->opening_angle2 = 0.25;
+    sim->dt = 1.e-3;
+    reb_simulation_configure_box(sim, 10., 2, 2, 1);
+    reb_mpi_init(sim);
+
+    const double A = 1.e-3;     // F = A*r^gamma (repulsive for A > 0)
+    const double gamma = -2.;
+    const int N_ring = 200;
+    const uint32_t star_hash = 1;
+
+    // Add particles on the root rank and send them to the ranks that own their part of the domain
+    if (sim->mpi_id == 0){
+        struct reb_particle star = {0};
+        star.m = 1.;
+        star.hash = star_hash;
+        reb_simulation_add(sim, star);
+        for (int i=0; i<N_ring; i++){
+            const double r = 1. + 3.*i/N_ring;
+            const double phi = 2.*M_PI*i/N_ring;
+            const double v = sqrt(sim->G*star.m/r - A*pow(r, gamma+1.)); // circular velocity including the central force
+            struct reb_particle p = {0};
+            p.x = r*cos(phi);
+            p.y = r*sin(phi);
+            p.vx = -v*sin(phi);
+            p.vy = v*cos(phi);
+            p.hash = star_hash + 1 + i;
+            reb_simulation_add(sim, p);
+        }
+    }
+    reb_communication_mpi_distribute_particles(sim);
+
+    // All ranks attach REBOUNDx and register/load the same things in the same order
+    struct rebx_extras* rebx = rebx_attach(sim);
+    rebx_register_param(rebx, "r0", REBX_TYPE_DOUBLE);
+    struct rebx_force* cf = rebx_load_force(rebx, "central_force");
+    rebx_add_force(rebx, cf);
+
+    // Particle parameters are set on the rank that holds the particle
+    struct reb_particle* const ps = sim->particles;
+    for (int i=0; i<sim->N; i++){
+        if (ps[i].hash == star_hash){
+            rebx_set_param_double(rebx, &ps[i].ap, "Acentral", A);
+            rebx_set_param_double(rebx, &ps[i].ap, "gammacentral", gamma);
+        }
+        else{
+            rebx_set_param_double(rebx, &ps[i].ap, "r0", sqrt(ps[i].x*ps[i].x + ps[i].y*ps[i].y));
+        }
+    }
+
+    reb_simulation_integrate(sim, 20.);
+
+    // Largest relative change in radius and number of test particles that lost their parameters, over all ranks
+    double local[2] = {0., 0.};
+    for (int i=0; i<sim->N; i++){
+        if (sim->particles[i].hash == star_hash){
+            continue;
+        }
+        const double* const r0 = rebx_get_param(rebx, sim->particles[i].ap, "r0");
+        if (r0 == NULL){
+            local[1] += 1.;
+            continue;
+        }
+        const struct reb_particle p = sim->particles[i];
+        const double dr = fabs(sqrt(p.x*p.x + p.y*p.y)/(*r0) - 1.);
+        local[0] = dr > local[0] ? dr : local[0];
+    }
+    double max_dr, N_missing;
+    MPI_Allreduce(&local[0], &max_dr, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    MPI_Allreduce(&local[1], &N_missing, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    const int success = (max_dr < 1.e-4 && N_missing == 0.);
+    if (sim->mpi_id == 0){
+        printf("Ranks: %d  Max relative change in radius: %e  Particles missing parameters: %d\n", sim->mpi_num, max_dr, (int)N_missing);
+        printf(success ? "Success.\n" : "Failed.\n");
+    }
+
+    rebx_free(rebx);
+    reb_mpi_finalize(sim);
+    reb_simulation_free(sim);
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
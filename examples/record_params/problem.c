@@ -0,0 +1,61 @@
+/**
+ * Recording parameter time series
+ *
+ * This example makes the star lose mass with modify_mass, and uses the record_params operator to
+ * record the star's mass and the planet's x coordinate every 100 timesteps into a columnar buffer
+ * that is written to a binary file in blocks. No callbacks or per-step polling are needed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+
+int main(int argc, char* argv[]){
+    struct reb_simulation* sim = reb_simulation_create();
+    sim->G = 4*M_PI*M_PI;               // use units of AU, yr and solar masses
+    sim->integrator = REB_INTEGRATOR_WHFAST;
+    sim->dt = 1.e-2;
+
+    struct reb_particle sun = {0}; 
+    sun.m   = 1.;   
+    reb_simulation_add(sim, sun); 
+    reb_simulation_add(sim, reb_particle_from_orbit(sim->G, sun, 1.e-3, 1., 0., 0., 0., 0., 0.));
+    reb_simulation_move_to_com(sim);
+
+    struct rebx_extras* rebx = rebx_attach(sim);
+    struct rebx_operator* modify_mass = rebx_load_operator(rebx, "modify_mass");
+    rebx_add_operator(rebx, modify_mass);
+    double tmax = 1.e3;
+    rebx_set_param_double(rebx, &sim->particles[0].ap, "tau_mass", -tmax);
+
+    struct rebx_operator* rp = rebx_load_operator(rebx, "record_params");
+    rebx_set_param_int(rebx, &rp->ap, "rp_interval", 100);      // sample every 100 timesteps
+    rebx_set_param_int(rebx, &rp->ap, "rp_capacity", 256);      // rows kept in memory before writing a block
+    rebx_record_params_add_channel(rebx, rp, 0, "m");
+    rebx_record_params_add_channel(rebx, rp, 1, "x");
+    rebx_record_params_set_file(rebx, rp, "params.bin");
+    rebx_add_operator(rebx, rp);
+
+    reb_simulation_integrate(sim, tmax); 
+    rebx_record_params_flush(rebx, rp);
+
+    // Read back the first block: int32 number of channels, then int64 number of rows followed by the time column and one column per channel
+    FILE* f = fopen("params.bin", "rb");
+    int32_t N_channels;
+    int64_t N_rows;
+    fread(&N_channels, sizeof(N_channels), 1, f);
+    fread(&N_rows, sizeof(N_rows), 1, f);
+    double* block = malloc((N_channels+1)*N_rows*sizeof(double));
+    fread(block, sizeof(double), (N_channels+1)*N_rows, f);
+    fclose(f);
+    for (int64_t i=0; i<N_rows; i+=32){
+        printf("t=%f, Sun mass = %f, planet x = %f\n", block[i], block[N_rows + i], block[2*N_rows + i]);
+    }
+
+    free(block);
+    rebx_free(rebx);    // this explicitly frees all the memory allocated by REBOUNDx 
+    reb_simulation_free(sim);
+}
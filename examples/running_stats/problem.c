@@ -0,0 +1,64 @@
+/**
+ * Running statistics of orbital elements.
+ * 
+ * This example integrates two interacting planets and uses the running_stats operator to accumulate the
+ * time-averaged semimajor axes and eccentricities, as well as the range covered by the longitudes of pericenter,
+ * without storing any snapshots.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+
+int main(int argc, char* argv[]){
+    struct reb_simulation* sim = reb_simulation_create();
+    sim->integrator = REB_INTEGRATOR_WHFAST;
+    sim->dt = 1.e-2;
+
+    struct reb_particle star = {0};
+    star.m     = 1.;   
+    reb_simulation_add(sim, star);
+
+    reb_simulation_add(sim, reb_particle_from_orbit(sim->G, star, 1.e-3, 1., 0.05, 0., 0., 0., 0.));
+    reb_simulation_add(sim, reb_particle_from_orbit(sim->G, star, 1.e-3, 1.6, 0.05, 0., 0., 2., 1.));
+    reb_simulation_move_to_com(sim);
+    
+    struct rebx_extras* rebx = rebx_attach(sim);
+    struct rebx_operator* rs = rebx_load_operator(rebx, "running_stats");
+    rebx_running_stats_add(rebx, rs, "a");
+    rebx_running_stats_add(rebx, rs, "e");
+    rebx_running_stats_add(rebx, rs, "pomega");
+    rebx_set_param_int(rebx, &rs->ap, "rs_interval", 10); // Only sample every 10 timesteps
+    rebx_add_operator(rebx, rs);
+
+    double tmax = 1.e4;
+    reb_simulation_integrate(sim, tmax);
+
+    int N = rebx_running_stats_N(rebx, rs);
+    double* mean = malloc(N*sizeof(double));
+    double* var = malloc(N*sizeof(double));
+    double* min = malloc(N*sizeof(double));
+    double* max = malloc(N*sizeof(double));
+
+    rebx_running_stats_get(rebx, rs, "a", NULL, mean, var, NULL, NULL);
+    for (int i=1; i<N; i++){
+        printf("Planet %d: <a> = %f, std(a) = %e\n", i, mean[i], sqrt(var[i]));
+    }
+    rebx_running_stats_get(rebx, rs, "e", NULL, mean, NULL, min, max);
+    for (int i=1; i<N; i++){
+        printf("Planet %d: <e> = %f, e range = [%f, %f]\n", i, mean[i], min[i], max[i]);
+    }
+    rebx_running_stats_get(rebx, rs, "pomega", NULL, NULL, NULL, min, max);
+    for (int i=1; i<N; i++){
+        printf("Planet %d: pomega advanced by %f rad\n", i, max[i] - min[i]);
+    }
+
+    free(mean);
+    free(var);
+    free(min);
+    free(max);
+    rebx_free(rebx);    // this explicitly frees all the memory allocated by REBOUNDx 
+    reb_simulation_free(sim);
+}
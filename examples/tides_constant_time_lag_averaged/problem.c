@@ -0,0 +1,63 @@
+/**
+ * Orbit-averaged constant time lag tides (Hut 1981)
+ *
+ * This follows the tidal spin-down of a hot Jupiter and the resulting orbital expansion and circularization
+ * with WHFast at a timestep spanning many orbits, by evolving the orbital elements and spins with Hut's secular equations.
+ * See the tides_constant_time_lag example for the corresponding direct force, which has to resolve every orbit.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+
+void heartbeat(struct reb_simulation* sim);
+double tmax = 1.e4;
+
+int main(int argc, char* argv[]){
+    struct reb_simulation* sim = reb_simulation_create();
+    sim->G = 4*M_PI*M_PI;           // Units of AU, yr and Msun
+
+    struct reb_particle star = {0};
+    star.m = 1.;
+    reb_simulation_add(sim, star);
+
+    double a = 0.05;                // AU
+    double e = 0.2;
+    double m = 1.e-3;               // roughly a Jupiter mass
+    struct reb_particle planet = reb_particle_from_orbit(sim->G, star, m, a, e, 0., 0., 0., 0.);
+    planet.r = 4.7e-4;              // roughly a Jupiter radius in AU
+    reb_simulation_add(sim, planet);
+    reb_simulation_move_to_com(sim);
+
+    struct reb_orbit o = reb_orbit_from_particle(sim->G, sim->particles[1], sim->particles[0]);
+    sim->integrator = REB_INTEGRATOR_WHFAST;
+    sim->dt = 10.*o.P;              // Timestep spanning 10 orbits. Tidal timescales have to be much longer.
+    sim->heartbeat = heartbeat;
+
+    struct rebx_extras* rebx = rebx_attach(sim);
+    struct rebx_operator* tides = rebx_load_operator(rebx, "tides_constant_time_lag_averaged");
+    rebx_add_operator(rebx, tides);
+
+    // Tides raised on the planet. Bodies need tctl_k2, tctl_tau and a physical radius to contribute.
+    rebx_set_param_double(rebx, &sim->particles[1].ap, "tctl_k2", 0.3);
+    rebx_set_param_double(rebx, &sim->particles[1].ap, "tctl_tau", 1.e-5/(2.*M_PI));   // in yr
+
+    // Setting a moment of inertia lets the spin OmegaMag evolve. Otherwise OmegaMag (default 0) is held fixed.
+    rebx_set_param_double(rebx, &sim->particles[1].ap, "I", 0.25*m*planet.r*planet.r);
+    rebx_set_param_double(rebx, &sim->particles[1].ap, "OmegaMag", 2.*M_PI/(10./24./365.25)); // 10 hour rotation period
+
+    reb_simulation_integrate(sim, tmax);
+    rebx_free(rebx);
+    reb_simulation_free(sim);
+}
+
+void heartbeat(struct reb_simulation* sim){
+    if(reb_simulation_output_check(sim, tmax/20.)){
+        struct rebx_extras* const rebx = sim->extras;
+        struct reb_orbit o = reb_orbit_from_particle(sim->G, sim->particles[1], sim->particles[0]);
+        double* Omega = rebx_get_param(rebx, sim->particles[1].ap, "OmegaMag");
+        printf("t=%e\ta=%.8f\te=%.6f\tOmega/n=%.6f\n", sim->t, o.a, o.e, *Omega/o.n);
+    }
+}
@@ -0,0 +1,71 @@
+/**
+ * Tracking encounters between many test particles and the planets.
+ * 
+ * This example sets up two planets and a ring of test particles crossing their orbits, and uses the
+ * track_encounters operator to record, for every (test particle, planet) pair, the closest approach and
+ * the number of separate encounters within a given radius.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+
+int main(int argc, char* argv[]){
+    struct reb_simulation* sim = reb_simulation_create();
+    sim->integrator = REB_INTEGRATOR_WHFAST;
+    sim->dt = 1.e-2;
+
+    struct reb_particle star = {0};
+    star.m     = 1.;   
+    reb_simulation_add(sim, star);
+
+    // Planets first. These will be the targets
+    reb_simulation_add(sim, reb_particle_from_orbit(sim->G, star, 1.e-3, 1., 0., 0., 0., 0., 0.));
+    reb_simulation_add(sim, reb_particle_from_orbit(sim->G, star, 3.e-4, 1.6, 0., 0., 0., 0., 2.));
+    sim->N_active = sim->N; // Everything added after this is a test particle, and gets tracked against the planets
+
+    int Ntest = 1000;
+    for (int i=0; i<Ntest; i++){
+        double a = 1.3;
+        double e = 0.3;
+        double inc = 0.01*(double)i/Ntest;
+        double f = 2.*M_PI*(double)i/Ntest;
+        reb_simulation_add(sim, reb_particle_from_orbit(sim->G, star, 0., a, e, inc, 0., 0., f));
+    }
+    reb_simulation_move_to_com(sim);
+    
+    struct rebx_extras* rebx = rebx_attach(sim);
+    struct rebx_operator* te = rebx_load_operator(rebx, "track_encounters");
+    rebx_set_param_double(rebx, &te->ap, "te_radius", 0.05); // Record any approach closer than 0.05
+    rebx_add_operator(rebx, te);
+
+    double tmax = 100.;
+    reb_simulation_integrate(sim, tmax);
+
+    // Copy out the tables. Rows are test particles, columns are planets
+    int N_tracked = rebx_track_encounters_N_tracked(rebx, te);
+    int N_targets = rebx_track_encounters_N_targets(rebx, te);
+    double* min_distances = malloc(N_tracked*N_targets*sizeof(double));
+    int* counts = malloc(N_tracked*N_targets*sizeof(int));
+    rebx_track_encounters_min_distances(rebx, te, min_distances);
+    rebx_track_encounters_counts(rebx, te, counts);
+
+    for (int t=0; t<N_targets; t++){
+        int Nencounters = 0;
+        double closest = INFINITY;
+        for (int j=0; j<N_tracked; j++){
+            Nencounters += counts[j*N_targets + t];
+            if (min_distances[j*N_targets + t] < closest){
+                closest = min_distances[j*N_targets + t];
+            }
+        }
+        printf("Planet %d: %d encounters, closest approach = %e\n", t+1, Nencounters, closest);
+    }
+
+    free(min_distances);
+    free(counts);
+    rebx_free(rebx);    // this explicitly frees all the memory allocated by REBOUNDx 
+    reb_simulation_free(sim);
+}
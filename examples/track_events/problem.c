@@ -0,0 +1,59 @@
+/**
+ * Logging pericenter passages and resonant angle crossings.
+ * 
+ * This example places two planets near a 2:1 mean motion resonance and uses the track_events operator
+ * to record the state of the inner planet at each pericenter passage and each time its resonant angle
+ * 2*l_outer - l_inner - pomega_inner crosses zero. The events are written to a binary file, so the output
+ * size is set by the number of events rather than the number of timesteps.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+
+int main(int argc, char* argv[]){
+    struct reb_simulation* sim = reb_simulation_create();
+    sim->integrator = REB_INTEGRATOR_WHFAST;
+    sim->dt = 2.*M_PI/50.;
+
+    struct reb_particle star = {0};
+    star.m     = 1.;   
+    reb_simulation_add(sim, star);
+
+    reb_simulation_add(sim, reb_particle_from_orbit(sim->G, star, 1.e-4, 1., 0.05, 0., 0., 0., 0.));
+    reb_simulation_add(sim, reb_particle_from_orbit(sim->G, star, 1.e-4, pow(2., 2./3.)*1.01, 0.02, 0., 0., 1., 2.));
+    reb_simulation_move_to_com(sim);
+    
+    struct rebx_extras* rebx = rebx_attach(sim);
+    struct rebx_operator* ev = rebx_load_operator(rebx, "track_events");
+    rebx_set_param_int(rebx, &ev->ap, "ev_events", REBX_EVENT_PERICENTER | REBX_EVENT_RESONANCE);
+    rebx_track_events_set_file(rebx, ev, "events.bin");
+    rebx_add_operator(rebx, ev);
+
+    // Resonant angle 2*l_outer - l_inner - pomega_inner (p=1, q=1 are the defaults)
+    rebx_set_param_int(rebx, &sim->particles[1].ap, "ev_res_partner", 2);
+
+    double tmax = 1.e4;
+    reb_simulation_integrate(sim, tmax);
+    rebx_track_events_flush(rebx, ev);
+
+    FILE* f = fopen("events.bin", "rb");
+    struct rebx_event event;
+    int Npericenter = 0;
+    int Nresonance = 0;
+    while (fread(&event, sizeof(event), 1, f) == 1){
+        if (event.index == 1 && event.type == REBX_EVENT_PERICENTER){
+            Npericenter++;
+        }
+        if (event.type == REBX_EVENT_RESONANCE){
+            Nresonance++;
+        }
+    }
+    fclose(f);
+    printf("Inner planet: %d pericenter passages, %d resonant angle crossings\n", Npericenter, Nresonance);
+
+    rebx_free(rebx);    // this explicitly frees all the memory allocated by REBOUNDx 
+    reb_simulation_free(sim);
+}
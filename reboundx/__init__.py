@@ -44,7 +44,7 @@ rebound.Particle.params = params
 
 from .extras import Extras, Param, Node, Force, Operator, integrators, Interpolator
 from .simulationarchive import Simulationarchive
-from .tools import coordinates, install_test
+from .tools import coordinates, events, diagnostics, event_dtype, read_record_params, work_precision, install_test
 from .params import Params
 
 __all__ = ["__version__", "__build__", "__githash__", "Extras", "Simulationarchive", "Param", "Interpolator", "Params", "coordinates", "integrators"]
@@ -0,0 +1,408 @@
+/**
+ * @file    _params.c
+ * @brief   Compiled CPython accessors for REBOUNDx parameters.
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Accessing a parameter through ctypes costs a type lookup, setting a restype and a cast on every access.
+ * This module provides typed parameter handles that resolve the type once, and then get and set values
+ * (one at a time, or in bulk across a particle array through the buffer protocol) and expose zero-copy views.
+ * It calls into libreboundx through function pointers passed in by reboundx/params.py at import, so it does
+ * not link against libreboundx. reboundx/params.py falls back to ctypes if this module is not available.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "reboundx.h"
+
+static struct {
+    enum rebx_param_type (*get_type)(struct rebx_extras* rebx, const char* name);
+    void* (*get_param)(struct rebx_extras* const rebx, struct rebx_node* ap, const char* const param_name);
+    void (*set_double)(struct rebx_extras* const rebx, struct rebx_node** apptr, const char* const param_name, double val);
+    void (*set_int)(struct rebx_extras* const rebx, struct rebx_node** apptr, const char* const param_name, int val);
+    void (*set_uint32)(struct rebx_extras* const rebx, struct rebx_node** apptr, const char* const param_name, uint32_t val);
+} rebx_lib = {0};
+
+static PyObject* params_init(PyObject* self, PyObject* args){
+    unsigned long long get_type, get_param, set_double, set_int, set_uint32;
+    if (!PyArg_ParseTuple(args, "KKKKK", &get_type, &get_param, &set_double, &set_int, &set_uint32)){
+        return NULL;
+    }
+    rebx_lib.get_type = (enum rebx_param_type (*)(struct rebx_extras*, const char*))(uintptr_t)get_type;
+    rebx_lib.get_param = (void* (*)(struct rebx_extras* const, struct rebx_node*, const char* const))(uintptr_t)get_param;
+    rebx_lib.set_double = (void (*)(struct rebx_extras* const, struct rebx_node**, const char* const, double))(uintptr_t)set_double;
+    rebx_lib.set_int = (void (*)(struct rebx_extras* const, struct rebx_node**, const char* const, int))(uintptr_t)set_int;
+    rebx_lib.set_uint32 = (void (*)(struct rebx_extras* const, struct rebx_node**, const char* const, uint32_t))(uintptr_t)set_uint32;
+    Py_RETURN_NONE;
+}
+
+typedef struct {
+    PyObject_HEAD
+    struct rebx_extras* rebx;
+    char* name;
+    enum rebx_param_type type;
+} ParamHandle;
+
+static void ParamHandle_dealloc(ParamHandle* self){
+    PyMem_Free(self->name);
+    Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static int ParamHandle_init(ParamHandle* self, PyObject* args, PyObject* kwds){
+    unsigned long long rebx;
+    const char* name;
+    if (!PyArg_ParseTuple(args, "Ks", &rebx, &name)){
+        return -1;
+    }
+    if (rebx_lib.get_type == NULL){
+        PyErr_SetString(PyExc_RuntimeError, "REBOUNDx Error: _params module was not initialized.");
+        return -1;
+    }
+    self->rebx = (struct rebx_extras*)(uintptr_t)rebx;
+    self->type = rebx_lib.get_type(self->rebx, name);
+    switch (self->type){
+        case REBX_TYPE_DOUBLE:
+        case REBX_TYPE_INT:
+        case REBX_TYPE_UINT32:
+        case REBX_TYPE_VEC3D:
+            break;
+        case REBX_TYPE_NONE:
+            PyErr_Format(PyExc_AttributeError, "REBOUNDx Error: Parameter '%s' not found in REBOUNDx. Need to register it first.", name);
+            return -1;
+        default:
+            PyErr_Format(PyExc_TypeError, "REBOUNDx Error: Parameter '%s' is not a double, int, uint32 or vec3d parameter and can't be accessed through a handle.", name);
+            return -1;
+    }
+    PyMem_Free(self->name);
+    self->name = PyMem_Malloc(strlen(name)+1);
+    if (self->name == NULL){
+        PyErr_NoMemory();
+        return -1;
+    }
+    strcpy(self->name, name);
+    return 0;
+}
+
+static void* ParamHandle_value(ParamHandle* self, unsigned long long apptr){
+    struct rebx_node* const ap = *(struct rebx_node**)(uintptr_t)apptr;
+    return rebx_lib.get_param(self->rebx, ap, self->name);
+}
+
+static PyObject* ParamHandle_get(ParamHandle* self, PyObject* args){
+    unsigned long long apptr;
+    if (!PyArg_ParseTuple(args, "K", &apptr)){
+        return NULL;
+    }
+    void* const value = ParamHandle_value(self, apptr);
+    if (value == NULL){
+        PyErr_Format(PyExc_AttributeError, "REBOUNDx Error: Parameter '%s' not found on object.", self->name);
+        return NULL;
+    }
+    switch (self->type){
+        case REBX_TYPE_DOUBLE:
+            return PyFloat_FromDouble(*(double*)value);
+        case REBX_TYPE_INT:
+            return PyLong_FromLong(*(int*)value);
+        case REBX_TYPE_UINT32:
+            return PyLong_FromUnsignedLong(*(uint32_t*)value);
+        default:
+        {
+            const struct reb_vec3d v = *(struct reb_vec3d*)value;
+            return Py_BuildValue("(ddd)", v.x, v.y, v.z);
+        }
+    }
+}
+
+static int ParamHandle_set_value(ParamHandle* self, struct rebx_node** apptr, PyObject* value){
+    switch (self->type){
+        case REBX_TYPE_DOUBLE:
+        {
+            const double val = PyFloat_AsDouble(value);
+            if (val == -1. && PyErr_Occurred()) return -1;
+            rebx_lib.set_double(self->rebx, apptr, self->name, val);
+            return 0;
+        }
+        case REBX_TYPE_INT:
+        {
+            const long val = PyLong_AsLong(value);
+            if (val == -1 && PyErr_Occurred()) return -1;
+            rebx_lib.set_int(self->rebx, apptr, self->name, (int)val);
+            return 0;
+        }
+        case REBX_TYPE_UINT32:
+        {
+            const unsigned long val = PyLong_AsUnsignedLong(value);
+            if (val == (unsigned long)-1 && PyErr_Occurred()) return -1;
+            rebx_lib.set_uint32(self->rebx, apptr, self->name, (uint32_t)val);
+            return 0;
+        }
+        default:
+            PyErr_Format(PyExc_TypeError, "REBOUNDx Error: Set vec3d parameter '%s' through Params, or write to its view.", self->name);
+            return -1;
+    }
+}
+
+static PyObject* ParamHandle_set(ParamHandle* self, PyObject* args){
+    unsigned long long apptr;
+    PyObject* value;
+    if (!PyArg_ParseTuple(args, "KO", &apptr, &value)){
+        return NULL;
+    }
+    if (ParamHandle_set_value(self, (struct rebx_node**)(uintptr_t)apptr, value)){
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static Py_ssize_t shape1[1] = {1};
+static Py_ssize_t shape3[1] = {3};
+
+// Zero-copy view onto the parameter's value. Only valid as long as the parameter (and the object it's attached to) exists.
+static PyObject* ParamHandle_view(ParamHandle* self, PyObject* args){
+    unsigned long long apptr;
+    if (!PyArg_ParseTuple(args, "K", &apptr)){
+        return NULL;
+    }
+    void* const value = ParamHandle_value(self, apptr);
+    if (value == NULL){
+        PyErr_Format(PyExc_AttributeError, "REBOUNDx Error: Parameter '%s' not found on object.", self->name);
+        return NULL;
+    }
+    Py_buffer view = {0};
+    view.buf = value;
+    view.readonly = 0;
+    view.ndim = 1;
+    switch (self->type){
+        case REBX_TYPE_DOUBLE:
+            view.itemsize = sizeof(double);
+            view.format = "d";
+            view.shape = shape1;
+            break;
+        case REBX_TYPE_INT:
+            view.itemsize = sizeof(int);
+            view.format = "i";
+            view.shape = shape1;
+            break;
+        case REBX_TYPE_UINT32:
+            view.itemsize = sizeof(uint32_t);
+            view.format = "I";
+            view.shape = shape1;
+            break;
+        default:
+            view.itemsize = sizeof(double);
+            view.format = "d";
+            view.shape = shape3;
+            break;
+    }
+    view.len = view.shape[0]*view.itemsize;
+    return PyMemoryView_FromBuffer(&view);
+}
+
+// Checks that a buffer is a contiguous 1D array of N items matching the handle's scalar type
+static int ParamHandle_check_buffer(ParamHandle* self, Py_buffer* buf, const Py_ssize_t N){
+    const char* format = buf->format ? buf->format : "B";
+    if (*format == '@' || *format == '=' || *format == '<'){
+        format++;
+    }
+    int ok;
+    switch (self->type){
+        case REBX_TYPE_DOUBLE:
+            ok = (buf->itemsize == sizeof(double) && *format == 'd');
+            break;
+        case REBX_TYPE_INT:
+            ok = (buf->itemsize == sizeof(int) && (*format == 'i' || *format == 'l'));
+            break;
+        case REBX_TYPE_UINT32:
+            ok = (buf->itemsize == sizeof(uint32_t) && (*format == 'I' || *format == 'L'));
+            break;
+        default:
+            PyErr_Format(PyExc_TypeError, "REBOUNDx Error: Bulk access is only supported for double, int and uint32 parameters ('%s').", self->name);
+            return -1;
+    }
+    if (!ok){
+        PyErr_Format(PyExc_TypeError, "REBOUNDx Error: Buffer for parameter '%s' has the wrong item type (format '%s').", self->name, buf->format ? buf->format : "B");
+        return -1;
+    }
+    if (buf->len/buf->itemsize < N){
+        PyErr_Format(PyExc_ValueError, "REBOUNDx Error: Buffer for parameter '%s' holds %zd items, but %zd are needed.", self->name, buf->len/buf->itemsize, N);
+        return -1;
+    }
+    return 0;
+}
+
+// Reads the parameter from N objects laid out every stride bytes from base (e.g. a particle array), whose ap pointer is at ap_offset.
+// Objects without the parameter get the fill value. Returns the number of objects that had the parameter.
+static PyObject* ParamHandle_get_many(ParamHandle* self, PyObject* args){
+    unsigned long long base;
+    Py_ssize_t stride, ap_offset, N;
+    PyObject* outobj;
+    PyObject* fill = NULL;
+    if (!PyArg_ParseTuple(args, "KnnnO|O", &base, &stride, &ap_offset, &N, &outobj, &fill)){
+        return NULL;
+    }
+    Py_buffer out;
+    if (PyObject_GetBuffer(outobj, &out, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | PyBUF_WRITABLE)){
+        return NULL;
+    }
+    if (ParamHandle_check_buffer(self, &out, N)){
+        PyBuffer_Release(&out);
+        return NULL;
+    }
+    double fill_double = NAN;
+    long fill_long = 0;
+    if (fill != NULL && fill != Py_None){
+        if (self->type == REBX_TYPE_DOUBLE){
+            fill_double = PyFloat_AsDouble(fill);
+        }
+        else{
+            fill_long = PyLong_AsLong(fill);
+        }
+        if (PyErr_Occurred()){
+            PyBuffer_Release(&out);
+            return NULL;
+        }
+    }
+
+    Py_ssize_t N_found = 0;
+    char* const obj = (char*)(uintptr_t)base;
+    for (Py_ssize_t i=0; i<N; i++){
+        struct rebx_node* const ap = *(struct rebx_node**)(obj + i*stride + ap_offset);
+        void* const value = rebx_lib.get_param(self->rebx, ap, self->name);
+        N_found += (value != NULL);
+        switch (self->type){
+            case REBX_TYPE_DOUBLE:
+                ((double*)out.buf)[i] = value ? *(double*)value : fill_double;
+                break;
+            case REBX_TYPE_INT:
+                ((int*)out.buf)[i] = value ? *(int*)value : (int)fill_long;
+                break;
+            default:
+                ((uint32_t*)out.buf)[i] = value ? *(uint32_t*)value : (uint32_t)fill_long;
+                break;
+        }
+    }
+    PyBuffer_Release(&out);
+    return PyLong_FromSsize_t(N_found);
+}
+
+// Sets the parameter on N objects laid out every stride bytes from base, adding it where it doesn't exist yet.
+static PyObject* ParamHandle_set_many(ParamHandle* self, PyObject* args){
+    unsigned long long base;
+    Py_ssize_t stride, ap_offset, N;
+    PyObject* valuesobj;
+    if (!PyArg_ParseTuple(args, "KnnnO", &base, &stride, &ap_offset, &N, &valuesobj)){
+        return NULL;
+    }
+    Py_buffer values;
+    if (PyObject_GetBuffer(valuesobj, &values, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT)){
+        return NULL;
+    }
+    if (ParamHandle_check_buffer(self, &values, N)){
+        PyBuffer_Release(&values);
+        return NULL;
+    }
+    char* const obj = (char*)(uintptr_t)base;
+    for (Py_ssize_t i=0; i<N; i++){
+        struct rebx_node** const apptr = (struct rebx_node**)(obj + i*stride + ap_offset);
+        switch (self->type){
+            case REBX_TYPE_DOUBLE:
+                rebx_lib.set_double(self->rebx, apptr, self->name, ((double*)values.buf)[i]);
+                break;
+            case REBX_TYPE_INT:
+                rebx_lib.set_int(self->rebx, apptr, self->name, ((int*)values.buf)[i]);
+                break;
+            default:
+                rebx_lib.set_uint32(self->rebx, apptr, self->name, ((uint32_t*)values.buf)[i]);
+                break;
+        }
+    }
+    PyBuffer_Release(&values);
+    Py_RETURN_NONE;
+}
+
+static PyObject* ParamHandle_get_type(ParamHandle* self, void* closure){
+    return PyLong_FromLong(self->type);
+}
+
+static PyObject* ParamHandle_get_name(ParamHandle* self, void* closure){
+    return PyUnicode_FromString(self->name);
+}
+
+static PyMethodDef ParamHandle_methods[] = {
+    {"get", (PyCFunction)ParamHandle_get, METH_VARARGS, "get(apptr): Value of the parameter on the object whose ap pointer is at address apptr."},
+    {"set", (PyCFunction)ParamHandle_set, METH_VARARGS, "set(apptr, value): Sets the parameter on the object whose ap pointer is at address apptr."},
+    {"view", (PyCFunction)ParamHandle_view, METH_VARARGS, "view(apptr): Writable zero-copy memoryview onto the parameter's value."},
+    {"get_many", (PyCFunction)ParamHandle_get_many, METH_VARARGS, "get_many(base, stride, ap_offset, N, out[, fill]): Reads the parameter from N objects into out. Returns number of objects with the parameter set."},
+    {"set_many", (PyCFunction)ParamHandle_set_many, METH_VARARGS, "set_many(base, stride, ap_offset, N, values): Sets the parameter on N objects from values."},
+    {NULL}
+};
+
+static PyGetSetDef ParamHandle_getset[] = {
+    {"type", (getter)ParamHandle_get_type, NULL, "rebx_param_type enum value", NULL},
+    {"name", (getter)ParamHandle_get_name, NULL, "Parameter name", NULL},
+    {NULL}
+};
+
+static PyTypeObject ParamHandleType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "reboundx._params.ParamHandle",
+    .tp_basicsize = sizeof(ParamHandle),
+    .tp_itemsize = 0,
+    .tp_dealloc = (destructor)ParamHandle_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Handle to a REBOUNDx parameter with its type resolved once.",
+    .tp_methods = ParamHandle_methods,
+    .tp_getset = ParamHandle_getset,
+    .tp_init = (initproc)ParamHandle_init,
+    .tp_new = PyType_GenericNew,
+};
+
+static PyMethodDef params_methods[] = {
+    {"init", params_init, METH_VARARGS, "init(get_type, get_param, set_double, set_int, set_uint32): Addresses of the libreboundx functions to call."},
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef params_module = {
+    PyModuleDef_HEAD_INIT,
+    "_params",
+    "Compiled accessors for REBOUNDx parameters.",
+    -1,
+    params_methods
+};
+
+PyMODINIT_FUNC PyInit__params(void){
+    if (PyType_Ready(&ParamHandleType) < 0){
+        return NULL;
+    }
+    PyObject* m = PyModule_Create(&params_module);
+    if (m == NULL){
+        return NULL;
+    }
+    Py_INCREF(&ParamHandleType);
+    if (PyModule_AddObject(m, "ParamHandle", (PyObject*)&ParamHandleType) < 0){
+        Py_DECREF(&ParamHandleType);
+        Py_DECREF(m);
+        return NULL;
+    }
+    return m;
+}
@@ -1,8 +1,10 @@
 from . import clibreboundx
-from ctypes import Structure, c_double, POINTER, c_int, c_uint, c_long, c_ulong, c_void_p, c_char_p, CFUNCTYPE, byref, c_uint32, c_uint, cast, c_char, pointer
+from ctypes import Structure, c_double, POINTER, c_int, c_uint, c_long, c_longlong, c_ulong, c_void_p, c_char_p, CFUNCTYPE, byref, c_uint32, c_uint, cast, c_char, pointer, c_size_t, string_at
 import rebound
 import reboundx
 import warnings
+import weakref
+from .tools import diagnostics as REBX_DIAGNOSTICS
 
 integrators = {"implicit_midpoint": 0, "rk4":1, "euler": 2, "rk2": 3, "none": -1}
 
@@ -41,7 +43,12 @@ class Extras(Structure):
         return rebx
 
     def __init__(self, sim, filename=None):
+        """
+        Attaches REBOUNDx to sim. If filename is passed, loads all effects and parameters from a binary saved with save(),
+        or from the bytes returned by save_to_bytes() if filename is a bytes object.
+        """
         sim._extras_ref = self # add a reference to this instance in sim to make sure it's not garbage collected_
+        self._sim_weakref = weakref.ref(sim) # to pickle sim along with this instance
         clibreboundx.rebx_initialize(byref(sim), byref(self))
         # Create simulation
         if filename==None:
@@ -51,7 +58,10 @@ class Extras(Structure):
             # Recreate existing simulation.
             # Load registered parameters from binary
             w = c_int(0)
-            clibreboundx.rebx_init_extras_from_binary(byref(self), c_char_p(filename.encode('ascii')), byref(w))
+            if isinstance(filename, bytes):
+                clibreboundx.rebx_init_extras_from_stream(byref(self), c_char_p(filename), c_size_t(len(filename)), byref(w))
+            else:
+                clibreboundx.rebx_init_extras_from_binary(byref(self), c_char_p(filename.encode('ascii')), byref(w))
             for majorerror, value, message in REBX_BINARY_WARNINGS:
                 if w.value & value:
                     if majorerror:
@@ -60,6 +70,22 @@ class Extras(Structure):
                         warnings.warn(message, RuntimeWarning)
         self.process_messages()
 
+    def __reduce__(self):
+        # Pickles the simulation along with the effects and parameters, so that (sim, rebx) pickled together unpickle to
+        # a rebx attached to the unpickled sim
+        sim = self._sim_weakref()
+        if sim is None:
+            self.process_messages() # raises an error if the simulation no longer exists
+            sim = self._sim.contents
+        tuning = (self.tuning.omp_threshold, self.tuning.omp_chunk, self.tuning.simd)
+        return (Extras, (sim, self.save_to_bytes()), (sim, tuning))
+
+    def __setstate__(self, state):
+        sim, tuning = state
+        # Nothing else may hold on to a simulation unpickled with this instance, so keep it from being garbage collected
+        self._sim_ref = sim
+        self.tuning.omp_threshold, self.tuning.omp_chunk, self.tuning.simd = tuning
+
     def __del__(self):
         if self._b_needsfree_ == 1:
             clibreboundx.rebx_free_pointers(byref(self))
@@ -77,6 +103,16 @@ class Extras(Structure):
         clibreboundx.rebx_register_param(byref(self), c_char_p(name.encode('ascii')), c_int(type_enum))
         self.process_messages()
 
+    def param_handle(self, name):
+        """
+        Returns a :class:`reboundx.params.ParamHandle` for a registered double, int, uint32 or vec3d parameter.
+        The handle looks up the parameter's type once, and then gets and sets values on particles, forces and operators
+        without the per-access overhead of the params dictionaries. It also supports bulk access across all particles
+        (get_all/set_all) and zero-copy views of individual values.
+        """
+        from .params import ParamHandle
+        return ParamHandle(self, name)
+
     def load_force(self, name):
         clibreboundx.rebx_load_force.restype = POINTER(Force)
         ptr = clibreboundx.rebx_load_force(byref(self), c_char_p(name.encode('ascii')))
@@ -158,6 +194,18 @@ class Extras(Structure):
         clibreboundx.rebx_output_binary(byref(self), c_char_p(filename.encode("ascii")))
         self.process_messages()
 
+    def save_to_bytes(self):
+        """
+        Returns the same binary as save() in a bytes object, without going through a file. Load it with reboundx.Extras(sim, bytes).
+        """
+        buf = c_void_p()
+        size = c_size_t()
+        clibreboundx.rebx_output_binary_to_stream(byref(self), byref(buf), byref(size))
+        self.process_messages()
+        data = string_at(buf, size.value)
+        clibreboundx.rebx_free_stream(buf)
+        return data
+
     #######################################
     # Effect Specific Functions
     #######################################
@@ -210,6 +258,237 @@ class Extras(Structure):
         clibreboundx.rebx_gravitational_harmonics_potential.restype = c_double
         return clibreboundx.rebx_gravitational_harmonics_potential(byref(self))
 
+    # Functions for reading out operator tables
+    def track_encounters_min_distances(self, operator):
+        """
+        Returns a numpy array of shape (N_tracked, N_targets) with the minimum separation recorded for each pair by the
+        track_encounters operator. Pairs that never came within te_radius are inf.
+        """
+        import numpy as np
+        clibreboundx.rebx_track_encounters_N_tracked.restype = c_int
+        clibreboundx.rebx_track_encounters_N_targets.restype = c_int
+        N_tracked = clibreboundx.rebx_track_encounters_N_tracked(byref(self), byref(operator))
+        N_targets = clibreboundx.rebx_track_encounters_N_targets(byref(self), byref(operator))
+        min_distances = np.empty((N_tracked, N_targets), dtype=np.float64)
+        clibreboundx.rebx_track_encounters_min_distances(byref(self), byref(operator), min_distances.ctypes.data_as(POINTER(c_double)))
+        self.process_messages()
+        return min_distances
+
+    def track_encounters_counts(self, operator):
+        """
+        Returns a numpy array of shape (N_tracked, N_targets) with the number of encounters recorded for each pair by the
+        track_encounters operator.
+        """
+        import numpy as np
+        clibreboundx.rebx_track_encounters_N_tracked.restype = c_int
+        clibreboundx.rebx_track_encounters_N_targets.restype = c_int
+        N_tracked = clibreboundx.rebx_track_encounters_N_tracked(byref(self), byref(operator))
+        N_targets = clibreboundx.rebx_track_encounters_N_targets(byref(self), byref(operator))
+        counts = np.empty((N_tracked, N_targets), dtype=np.intc)
+        clibreboundx.rebx_track_encounters_counts(byref(self), byref(operator), counts.ctypes.data_as(POINTER(c_int)))
+        self.process_messages()
+        return counts
+
+    def track_encounters_indices(self, operator):
+        """
+        Returns a tuple (tracked, targets) of numpy arrays with the particle indices of the rows and columns of the
+        track_encounters tables.
+        """
+        import numpy as np
+        clibreboundx.rebx_track_encounters_N_tracked.restype = c_int
+        clibreboundx.rebx_track_encounters_N_targets.restype = c_int
+        N_tracked = clibreboundx.rebx_track_encounters_N_tracked(byref(self), byref(operator))
+        N_targets = clibreboundx.rebx_track_encounters_N_targets(byref(self), byref(operator))
+        tracked = np.empty(N_tracked, dtype=np.intc)
+        targets = np.empty(N_targets, dtype=np.intc)
+        clibreboundx.rebx_track_encounters_indices(byref(self), byref(operator), tracked.ctypes.data_as(POINTER(c_int)), targets.ctypes.data_as(POINTER(c_int)))
+        self.process_messages()
+        return tracked, targets
+
+    def running_stats_add(self, operator, name):
+        """
+        Adds a quantity to accumulate statistics for in the running_stats operator. Can be a heliocentric orbital element
+        (a, e, inc, Omega, omega, pomega, f, M, l, P) or the name of a particle parameter of type double.
+        """
+        clibreboundx.rebx_running_stats_add.restype = c_int
+        clibreboundx.rebx_running_stats_add(byref(self), byref(operator), c_char_p(name.encode('ascii')))
+        self.process_messages()
+
+    def running_stats(self, operator, name):
+        """
+        Returns a dictionary with numpy arrays (one entry per particle) of the number of samples 'n', 'mean', population
+        variance 'var', 'min' and 'max' of the quantity name accumulated by the running_stats operator. Particles without
+        samples have nan statistics.
+        """
+        import numpy as np
+        clibreboundx.rebx_running_stats_N.restype = c_int
+        N = clibreboundx.rebx_running_stats_N(byref(self), byref(operator))
+        stats = {"n":np.zeros(N, dtype=np.int64)}
+        for key in ["mean", "var", "min", "max"]:
+            stats[key] = np.full(N, np.nan, dtype=np.float64)
+        clibreboundx.rebx_running_stats_get(byref(self), byref(operator), c_char_p(name.encode('ascii')), stats["n"].ctypes.data_as(POINTER(c_longlong)), *[stats[key].ctypes.data_as(POINTER(c_double)) for key in ["mean", "var", "min", "max"]])
+        self.process_messages()
+        return stats
+
+    def running_stats_reset(self, operator):
+        """
+        Resets all statistics accumulated by the running_stats operator and removes the corresponding particle parameters.
+        """
+        clibreboundx.rebx_running_stats_reset(byref(self), byref(operator))
+        self.process_messages()
+
+    def track_events(self, operator):
+        """
+        Returns a numpy structured array (dtype reboundx.event_dtype) of the events logged in memory by the track_events operator.
+        """
+        import numpy as np
+        from .tools import event_dtype
+        clibreboundx.rebx_track_events_N.restype = c_int
+        N = clibreboundx.rebx_track_events_N(byref(self), byref(operator))
+        events = np.zeros(N, dtype=event_dtype)
+        clibreboundx.rebx_track_events_get(byref(self), byref(operator), events.ctypes.data_as(c_void_p))
+        self.process_messages()
+        return events
+
+    def track_events_set_file(self, operator, filename):
+        """
+        Appends events logged by the track_events operator to a binary file instead of keeping them in memory.
+        Load it with numpy.fromfile(filename, dtype=reboundx.event_dtype) after calling track_events_flush.
+        """
+        clibreboundx.rebx_track_events_set_file(byref(self), byref(operator), c_char_p(filename.encode('ascii')))
+        self.process_messages()
+
+    def track_events_flush(self, operator):
+        """
+        Writes any buffered track_events records to the file set with track_events_set_file.
+        """
+        clibreboundx.rebx_track_events_flush(byref(self), byref(operator))
+        self.process_messages()
+
+    def record_params_add_channel(self, operator, index, name):
+        """
+        Adds a channel recording the parameter (or particle field m, r, x, y, z, vx, vy, vz) name of particle index to the
+        record_params operator. Components of vector parameters are selected with a .x, .y or .z suffix, e.g. "Omega.z".
+        """
+        clibreboundx.rebx_record_params_add_channel.restype = c_int
+        clibreboundx.rebx_record_params_add_channel(byref(self), byref(operator), c_int(index), c_char_p(name.encode('ascii')))
+        self.process_messages()
+
+    def record_params(self, operator):
+        """
+        Returns the samples in the record_params buffer as a tuple (t, values), with t a numpy array of times and values a numpy array
+        of shape (N_channels, N_rows), in time order. These are copies, so they stay valid after later samples, after adding
+        channels (which reallocates the buffer) and after the operator is freed.
+        """
+        import numpy as np
+        N_channels, capacity, N_rows, head = c_int(), c_int(), c_int(), c_int()
+        clibreboundx.rebx_record_params_buffer.restype = POINTER(c_double)
+        data = clibreboundx.rebx_record_params_buffer(byref(self), byref(operator), byref(N_channels), byref(capacity), byref(N_rows), byref(head))
+        if N_channels.value == 0:
+            return np.zeros(0), np.zeros((0, 0))
+        columns = np.ctypeslib.as_array(data, shape=(N_channels.value+1, capacity.value))
+        start = head.value - N_rows.value
+        if start >= 0:
+            columns = columns[:, start:head.value].copy()
+        else:
+            columns = np.concatenate((columns[:, start:], columns[:, :head.value]), axis=1)
+        return columns[0], columns[1:]
+
+    def record_params_set_file(self, operator, filename):
+        """
+        Makes the record_params operator write its buffer to a binary column file whenever it fills up, rather than overwriting
+        old samples. Read it back with reboundx.read_record_params after calling record_params_flush.
+        """
+        clibreboundx.rebx_record_params_set_file(byref(self), byref(operator), c_char_p(filename.encode('ascii')))
+        self.process_messages()
+
+    def record_params_flush(self, operator):
+        """
+        Writes the samples in the record_params buffer to the file set with record_params_set_file.
+        """
+        clibreboundx.rebx_record_params_flush(byref(self), byref(operator))
+        self.process_messages()
+
+    def flyby_add(self, operator, t, m, b, v):
+        """
+        Schedules a passing star of mass m for the flyby operator, with closest approach at time t. The impact vector b (the star's
+        position at closest approach) and its velocity v are relative to the simulation's center of mass, and can be lists or rebound.Vec3d.
+        Returns the index of the encounter in the time-sorted schedule.
+        """
+        clibreboundx.rebx_flyby_add.restype = c_int
+        index = clibreboundx.rebx_flyby_add(byref(self), byref(operator), c_double(t), c_double(m), rebound.Vec3d(b)._vec3d, rebound.Vec3d(v)._vec3d)
+        self.process_messages()
+        return index
+
+    def flyby_N_applied(self, operator):
+        """
+        Returns the number of scheduled encounters the flyby operator has applied so far.
+        """
+        clibreboundx.rebx_flyby_N_applied.restype = c_int
+        return clibreboundx.rebx_flyby_N_applied(byref(self), byref(operator))
+
+    # Diagnostics
+
+    def diagnostic_count(self, code):
+        """
+        Returns the number of times the condition code (a key in reboundx.diagnostics, e.g. "GR_NOT_CONVERGED") has occurred.
+        Conditions are counted every time, but only raise a warning on their 1st, 10th, 100th... occurrence.
+        """
+        clibreboundx.rebx_diagnostic_count.restype = c_ulong
+        return clibreboundx.rebx_diagnostic_count(byref(self), c_int(REBX_DIAGNOSTICS[code.upper()]))
+
+    def diagnostics(self):
+        """
+        Returns a dictionary with the counts of all conditions that have occurred, with keys from reboundx.diagnostics.
+        """
+        counts = {code: self.diagnostic_count(code) for code in REBX_DIAGNOSTICS}
+        return {code: count for code, count in counts.items() if count > 0}
+
+    def diagnostics_reset(self):
+        """
+        Sets all diagnostic counts to zero, so that each condition raises a warning again on its next occurrence.
+        """
+        clibreboundx.rebx_diagnostics_reset(byref(self))
+
+    # Autotuning
+
+    def autotune(self, filename=None):
+        """
+        Measures the fastest settings for the particle loops in the stepper kernels (drift, kick and kick_forces) on this machine,
+        and stores them in rebx.tuning. If filename is passed, the settings are cached in that file (keyed by CPU model and number
+        of OpenMP threads) and loaded from it instead of recalibrating on later calls. Returns True if loaded from the cache.
+        """
+        clibreboundx.rebx_autotune.restype = c_int
+        ret = clibreboundx.rebx_autotune(byref(self), None if filename is None else c_char_p(filename.encode('ascii')))
+        self.process_messages()
+        return ret == 1
+
+    # Parameter observers
+
+    def add_param_observer(self, name, callback):
+        """
+        Calls callback(param_name) whenever the parameter name (or any parameter if name is None) is set or removed on any particle,
+        force or operator, e.g., to only recompute quantities derived from parameters when they change. Changes made by writing
+        to a ParamHandle view are not detected. Returns an observer to pass to remove_param_observer.
+        """
+        def _callback(rebx, apptr, param_name, data):
+            callback(param_name.decode('ascii'))
+        cb = PARAMOBSERVERFUNCPTR(_callback)
+        clibreboundx.rebx_add_param_observer.restype = c_void_p
+        observer = clibreboundx.rebx_add_param_observer(byref(self), None if name is None else c_char_p(name.encode('ascii')), cb, None, None)
+        self.process_messages()
+        if not hasattr(self, '_param_observer_refs'):
+            self._param_observer_refs = {}
+        self._param_observer_refs[observer] = cb # keep a reference to the callback so it doesn't get garbage collected
+        return observer
+
+    def remove_param_observer(self, observer):
+        """
+        Stops an observer returned by add_param_observer from being notified.
+        """
+        clibreboundx.rebx_remove_param_observer(byref(self), c_void_p(observer))
+        getattr(self, '_param_observer_refs', {}).pop(observer, None)
+
     # Functions to help with rotations
 
     def rotate_simulation(self, q):
@@ -252,6 +531,17 @@ class Node(Structure): # need to define fields afterward because of circular ref
 Node._fields_ =  [  ("object", c_void_p),
                     ("next", POINTER(Node))]
 
+class Tuning(Structure):
+    """
+    Settings for the particle loops in the stepper kernels, set by Extras.autotune. The parallel force loops (gas_dynamical_friction,
+    disk_self_gravity) also use omp_threshold and omp_chunk.
+    omp_threshold is the minimum number of particles for loops to run in parallel with OpenMP, omp_chunk the chunk size for
+    OpenMP's guided schedule, and simd is 1 to use the explicitly vectorized loops.
+    """
+    _fields_ = [("omp_threshold", c_int),
+                ("omp_chunk", c_int),
+                ("simd", c_int)]
+
 class Operator(Structure):
     @property
     def operator_type(self):
@@ -278,6 +568,7 @@ class Operator(Structure):
         params = Params(self)
         return params
 
+PARAMOBSERVERFUNCPTR = CFUNCTYPE(None, c_void_p, c_void_p, c_char_p, c_void_p)
 STEPFUNCPTR = CFUNCTYPE(None, POINTER(rebound.Simulation), POINTER(Operator), c_double)
 
 Operator._fields_ = [   ("name", c_char_p),
@@ -314,7 +605,8 @@ Force._fields_ = [  ("name", c_char_p),
                     ("ap", POINTER(Node)),
                     ("_sim", POINTER(rebound.Simulation)),
                     ("_force_type", c_int),
-                    ("_update_accelerations", FORCEFUNCPTR)]
+                    ("_update_accelerations", FORCEFUNCPTR),
+                    ("_update_accelerations_testparticles", c_void_p)]
 
 # Need to put fields after class definition because of self-referencing
 Extras._fields_ =  [("_sim", POINTER(rebound.Simulation)),
@@ -323,7 +615,18 @@ Extras._fields_ =  [("_sim", POINTER(rebound.Simulation)),
                     ("_post_timestep_modifications", POINTER(Node)),
                     ("_registered_params", POINTER(Node)),
                     ("_allocated_forces", POINTER(Node)),
-                    ("_allocated_operators", POINTER(Node))]
+                    ("_allocated_operators", POINTER(Node)),
+                    ("_orbits", c_void_p),
+                    ("_orbits_N", c_int),
+                    ("_orbits_valid", c_int),
+                    ("_set_velocity_dependent", c_int),
+                    ("_jacobi", c_void_p),
+                    ("force_evaluations", c_ulong),
+                    ("_diagnostic_counts", c_ulong*len(REBX_DIAGNOSTICS)),
+                    ("_diagnostic_next_report", c_ulong*len(REBX_DIAGNOSTICS)),
+                    ("_param_observers", POINTER(Node)),
+                    ("tuning", Tuning),
+                    ("_mpi_params", c_void_p)]
 
 class Interpolator(Structure):
     def __new__(cls, rebx, times, values, interpolation):
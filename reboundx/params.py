@@ -10,6 +10,165 @@ from ctypes import byref, c_double, c_int, c_int32, c_int64, c_uint, c_uint32, c
 from ctypes import c_void_p, memmove, sizeof, addressof
 from rebound import hash as rebhash
 
+REBX_TYPE_NONE, REBX_TYPE_DOUBLE, REBX_TYPE_INT, REBX_TYPE_UINT32, REBX_TYPE_VEC3D = 0, 1, 2, 5, 8
+_handle_types = (REBX_TYPE_DOUBLE, REBX_TYPE_INT, REBX_TYPE_UINT32, REBX_TYPE_VEC3D)
+
+# Compiled accessors (reboundx/_params.c). Fall back to ctypes if the extension wasn't built.
+try:
+    from . import _params as _cparams
+    _cparams.init(*[cast(f, c_void_p).value for f in (clibreboundx.rebx_get_type, clibreboundx.rebx_get_param, clibreboundx.rebx_set_param_double, clibreboundx.rebx_set_param_int, clibreboundx.rebx_set_param_uint32)])
+except ImportError:
+    _cparams = None
+
+clibreboundx.rebx_get_param.restype = c_void_p
+
+class _CtypesParamHandle(object):
+    # Same interface as _params.ParamHandle, through ctypes
+    def __init__(self, rebx, name):
+        self.name = name
+        self._rebx = c_void_p(rebx)
+        self._key = c_char_p(name.encode('ascii'))
+        self.type = clibreboundx.rebx_get_type(self._rebx, self._key)
+        if self.type == REBX_TYPE_NONE:
+            raise AttributeError("REBOUNDx Error: Parameter '{0}' not found in REBOUNDx. Need to register it first.".format(name))
+        if self.type not in _handle_types:
+            raise TypeError("REBOUNDx Error: Parameter '{0}' is not a double, int, uint32 or vec3d parameter and can't be accessed through a handle.".format(name))
+        self._ctype = REBX_CTYPES[self.type]
+        self._n = 1
+        if self.type == REBX_TYPE_VEC3D:
+            self._ctype = c_double
+            self._n = 3
+
+    def _value(self, apptr):
+        ap = c_void_p.from_address(apptr)
+        valptr = clibreboundx.rebx_get_param(self._rebx, ap, self._key)
+        if valptr is None:
+            raise AttributeError("REBOUNDx Error: Parameter '{0}' not found on object.".format(self.name))
+        return (self._ctype*self._n).from_address(valptr)
+
+    def get(self, apptr):
+        val = self._value(apptr)
+        if self._n == 3:
+            return tuple(val)
+        return val[0]
+
+    def set(self, apptr, value):
+        if self.type == REBX_TYPE_DOUBLE:
+            clibreboundx.rebx_set_param_double(self._rebx, c_void_p(apptr), self._key, c_double(value))
+        elif self.type == REBX_TYPE_INT:
+            clibreboundx.rebx_set_param_int(self._rebx, c_void_p(apptr), self._key, c_int(value))
+        elif self.type == REBX_TYPE_UINT32:
+            clibreboundx.rebx_set_param_uint32(self._rebx, c_void_p(apptr), self._key, c_uint32(value))
+        else:
+            raise TypeError("REBOUNDx Error: Set vec3d parameter '{0}' through Params, or write to its view.".format(self.name))
+
+    def view(self, apptr):
+        return memoryview(self._value(apptr)).cast('B').cast({c_double:'d', c_int:'i', c_uint32:'I'}[self._ctype])
+
+    def get_many(self, base, stride, ap_offset, N, out, fill=None):
+        if self._n == 3:
+            raise TypeError("REBOUNDx Error: Bulk access is only supported for double, int and uint32 parameters ('{0}').".format(self.name))
+        if fill is None:
+            fill = float('nan') if self.type == REBX_TYPE_DOUBLE else 0
+        N_found = 0
+        for i in range(N):
+            try:
+                out[i] = self.get(base + i*stride + ap_offset)
+                N_found += 1
+            except AttributeError:
+                out[i] = fill
+        return N_found
+
+    def set_many(self, base, stride, ap_offset, N, values):
+        for i in range(N):
+            self.set(base + i*stride + ap_offset, values[i])
+
+# Handles are not cached across calls: a handle holds the address of the rebx_extras it was made for, which can be freed (and reused)
+# from C without Python noticing. Params makes a new one per access, which costs the same single type lookup the ctypes path does.
+def _make_handle(rebx, name):
+    # Returns None for parameter types handles don't support (pointers, forces, orbits, ODEs)
+    try:
+        if _cparams is not None:
+            return _cparams.ParamHandle(rebx, name)
+        return _CtypesParamHandle(rebx, name)
+    except TypeError:
+        return None
+
+class ParamHandle(object):
+    """
+    Handle to a REBOUNDx parameter whose type is looked up once, for fast repeated access across many objects
+    (particles, forces or operators), and bulk access across all particles in the simulation.
+    Uses the compiled reboundx._params extension if available, and ctypes otherwise.
+    Get one with rebx.param_handle(name).
+    """
+    def __init__(self, rebx, name):
+        self._rebxref = rebx # keep Extras alive while handle exists
+        self._handle = _make_handle(addressof(rebx), name)
+        if self._handle is None:
+            raise TypeError("REBOUNDx Error: Parameter '{0}' is not a double, int, uint32 or vec3d parameter and can't be accessed through a handle.".format(name))
+        self.name = name
+
+    @staticmethod
+    def _apptr(obj):
+        return addressof(obj) + type(obj).ap.offset
+
+    def get(self, obj):
+        """
+        Returns the parameter's value on obj (a particle, force or operator).
+        """
+        val = self._handle.get(self._apptr(obj))
+        if self._handle.type == REBX_TYPE_VEC3D:
+            return rebound.Vec3d(rebound.Vec3dBasic(*val))
+        return val
+
+    def set(self, obj, value):
+        """
+        Sets the parameter's value on obj (a particle, force or operator), adding it if it doesn't exist.
+        """
+        if self._handle.type == REBX_TYPE_VEC3D:
+            clibreboundx.rebx_set_param_vec3d(byref(self._rebxref), c_void_p(self._apptr(obj)), c_char_p(self.name.encode('ascii')), rebound.Vec3d(value)._vec3d)
+        else:
+            self._handle.set(self._apptr(obj), value)
+
+    def view(self, obj):
+        """
+        Returns a numpy array that is a writable zero-copy view onto the parameter's value on obj (length 1, or 3 for vec3d parameters).
+        The view must not be used after obj or its parameters are freed.
+        """
+        import numpy as np
+        return np.asarray(self._handle.view(self._apptr(obj)))
+
+    def _particles(self):
+        sim = self._rebxref._sim.contents
+        return cast(sim._particles, c_void_p).value, sizeof(rebound.Particle), rebound.Particle.ap.offset, sim.N - sim.N_var
+
+    def get_all(self, out=None, fill=None):
+        """
+        Returns a numpy array with the parameter's value for all the simulation's (real) particles.
+        Particles without the parameter get fill (NaN for doubles, 0 for integer types).
+        """
+        import numpy as np
+        base, stride, ap_offset, N = self._particles()
+        dtype = {REBX_TYPE_DOUBLE:np.float64, REBX_TYPE_INT:np.intc, REBX_TYPE_UINT32:np.uint32}.get(self._handle.type, np.float64)
+        if out is None:
+            out = np.empty(N, dtype=dtype)
+        if N > 0:
+            self._handle.get_many(base, stride, ap_offset, N, out, fill)
+        return out
+
+    def set_all(self, values):
+        """
+        Sets the parameter on all the simulation's (real) particles from an array of length N.
+        """
+        import numpy as np
+        base, stride, ap_offset, N = self._particles()
+        dtype = {REBX_TYPE_DOUBLE:np.float64, REBX_TYPE_INT:np.intc, REBX_TYPE_UINT32:np.uint32}.get(self._handle.type, np.float64)
+        values = np.ascontiguousarray(values, dtype=dtype)
+        if len(values) != N:
+            raise ValueError("REBOUNDx Error: Need {0} values to set '{1}' on all particles, got {2}.".format(N, self.name, len(values)))
+        if N > 0:
+            self._handle.set_many(base, stride, ap_offset, N, values)
+
 class Params(MutableMapping):
     def __init__(self, parent):
         self.verbose = 0        # set to 1 to diagnose problems
@@ -26,13 +185,23 @@ class Params(MutableMapping):
         else:
             self.rebx = cast(extrasvp, POINTER(Extras))
 
+    def _handle(self, key):
+        # Handle for double, int and uint32 params, None for other types
+        handle = _make_handle(cast(self.rebx, c_void_p).value, key)
+        if handle is None or handle.type == REBX_TYPE_VEC3D:
+            return None
+        return handle
+
     def __getitem__(self, key):
+        handle = self._handle(key)
+        if handle is not None:
+            return handle.get(addressof(self.ap))
+
         param_type = clibreboundx.rebx_get_type(self.rebx, c_char_p(key.encode('ascii')))
         ctype = REBX_CTYPES[param_type]
         if ctype == None:
             raise AttributeError("REBOUNDx Error: Parameter '{0}' not found in REBOUNDx. Need to register it first.".format(key))
 
-        clibreboundx.rebx_get_param.restype = c_void_p
         valptr = clibreboundx.rebx_get_param(self.rebx, self.ap, c_char_p(key.encode('ascii')))
 
         if ctype == c_void_p: # Don't know how to cast it, so return for user to cast
@@ -57,6 +226,11 @@ class Params(MutableMapping):
         return val
 
     def __setitem__(self, key, value):
+        handle = self._handle(key)
+        if handle is not None:
+            handle.set(addressof(self.ap), value)
+            return
+
         param_type = clibreboundx.rebx_get_type(self.rebx, c_char_p(key.encode('ascii')))
         ctype = REBX_CTYPES[param_type]
         if ctype == None:
@@ -85,7 +259,8 @@ class Params(MutableMapping):
             clibreboundx.rebx_set_param_pointer(self.rebx, byref(self.ap), c_char_p(key.encode('ascii')), byref(value))
 
     def __delitem__(self, key):
-        raise AttributeError("REBOUNDx Error: Removing particle params not implemented.")
+        if not clibreboundx.rebx_remove_param(self.rebx, byref(self.ap), c_char_p(key.encode('ascii'))):
+            raise AttributeError("REBOUNDx Error: Parameter '{0}' not found on object.".format(key))
 
     def __iter__(self):
         raise AttributeError("REBOUNDx Error: Iterator for params not implemented.")
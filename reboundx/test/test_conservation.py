@@ -64,6 +64,71 @@ class TestConservation(unittest.TestCase):
         H = sim.energy() + rebx.central_force_potential()
         self.assertLess(abs((H-H0)/H0), 1.e-12)
 
+    def test_central_force_kernels(self):
+        for gamma in [-3, -2.5, -2, -1.5, -1.2, 0, 1]:
+            sim = rebound.Simulation(binary)
+            sim.integrator = "ias15"
+            rebx = reboundx.Extras(sim)
+            force = rebx.load_force('central_force')
+            rebx.add_force(force)
+            ps = sim.particles
+            ps[0].params['Acentral'] = 1.e-4
+            ps[0].params['gammacentral'] = gamma
+            ps[1].params['Acentral'] = 1.e-8    # second source
+            ps[1].params['gammacentral'] = -2
+            H0 = sim.energy() + rebx.central_force_potential()
+            sim.integrate(1.e3)
+            H = sim.energy() + rebx.central_force_potential()
+            self.assertLess(abs((H-H0)/H0), 1.e-12, msg="gamma = {0}".format(gamma))
+
+    def test_central_force_change_gamma(self):
+        sim = rebound.Simulation(binary)
+        sim.integrator = "ias15"
+        rebx = reboundx.Extras(sim)
+        force = rebx.load_force('central_force')
+        rebx.add_force(force)
+        ps = sim.particles
+        ps[0].params['Acentral'] = 1.e-4
+        ps[0].params['gammacentral'] = -2
+        sim.integrate(1.e2)
+        ps[0].params['gammacentral'] = -1.5 # changed in place after the sources were cached
+        H0 = sim.energy() + rebx.central_force_potential()
+        sim.integrate(1.e3)
+        H = sim.energy() + rebx.central_force_potential()
+        self.assertLess(abs((H-H0)/H0), 1.e-12)
+
+    def test_central_force_write_through_view(self):
+        sim = rebound.Simulation(binary)
+        sim.integrator = "ias15"
+        rebx = reboundx.Extras(sim)
+        force = rebx.load_force('central_force')
+        rebx.add_force(force)
+        ps = sim.particles
+        ps[0].params['Acentral'] = 1.e-4
+        ps[0].params['gammacentral'] = -2
+        sim.integrate(1.e2)
+        rebx.param_handle('gammacentral').view(ps[0])[0] = -1.5 # no observer fires, but the cached sources point at the value
+        H0 = sim.energy() + rebx.central_force_potential()
+        sim.integrate(1.e3)
+        H = sim.energy() + rebx.central_force_potential()
+        self.assertLess(abs((H-H0)/H0), 1.e-12)
+
+    def test_central_force_del_param(self):
+        sim = rebound.Simulation(binary)
+        sim.integrator = "ias15"
+        rebx = reboundx.Extras(sim)
+        force = rebx.load_force('central_force')
+        rebx.add_force(force)
+        ps = sim.particles
+        ps[0].params['gammacentral'] = -2
+        ps[0].params['Acentral'] = 1.e-4 # now at the head of the parameter list, ahead of gammacentral
+        sim.integrate(1.e2)
+        del ps[0].params['gammacentral'] # no longer a source
+        E0 = sim.energy()
+        sim.integrate(1.e3)
+        self.assertEqual(rebx.central_force_potential(), 0.)
+        self.assertLess(abs((sim.energy()-E0)/E0), 1.e-12)
+
     def test_gravitational_harmonics(self):
         name = 'gravitational_harmonics'
         sim = rebound.Simulation(binary)
@@ -1,6 +1,7 @@
 import rebound
 import reboundx
 import unittest
+import math
 
 class TestForces(unittest.TestCase):
     def setUp(self):
@@ -62,6 +63,128 @@ class TestForces(unittest.TestCase):
         self.rebx.add_force(gr)
         self.rebx.remove_force(gr)
     
+    def test_velocitydependence(self):
+        self.assertEqual(self.sim.force_is_velocity_dependent, 0)
+        gr = self.rebx.load_force('gr')
+        self.rebx.add_force(gr)
+        self.assertEqual(self.sim.force_is_velocity_dependent, 1)
+        self.rebx.remove_force(gr)
+        self.assertEqual(self.sim.force_is_velocity_dependent, 0)
+
+    def test_velocitydependenceuserflag(self):
+        self.sim.force_is_velocity_dependent = 1
+        gr = self.rebx.load_force('gr')
+        self.rebx.add_force(gr)
+        self.rebx.remove_force(gr)
+        self.assertEqual(self.sim.force_is_velocity_dependent, 1)
+
+    def test_jacobicachestatechange(self):
+        # shared Jacobi coordinates must be recomputed when particles change without the time changing
+        self.sim.add(m=1.e-3, a=2., e=0.1)
+        gr = self.rebx.load_force('gr')
+        self.rebx.add_force(gr)
+        gr.params['c'] = 1.e2
+        H1 = self.rebx.gr_hamiltonian(gr)
+        self.sim.particles[2].vx *= 1.1
+        H2 = self.rebx.gr_hamiltonian(gr)
+        self.assertNotEqual(H1, H2)
+
+        sim = rebound.Simulation()
+        for p in self.sim.particles:
+            sim.add(m=p.m, x=p.x, y=p.y, z=p.z, vx=p.vx, vy=p.vy, vz=p.vz)
+        rebx = reboundx.Extras(sim)
+        gr2 = rebx.load_force('gr')
+        gr2.params['c'] = 1.e2
+        self.assertEqual(H2, rebx.gr_hamiltonian(gr2))
+
+    def test_testparticlekernels(self):
+        # forces with test particle kernels should give the same result with N_active set
+        def run(N_active, massive_testparticle=False):
+            sim = rebound.Simulation()
+            sim.add(m=1.)
+            sim.add(m=1.e-3, a=1., e=0.1)
+            for i in range(5):
+                sim.add(a=1.5+0.2*i, e=0.05*i, inc=0.1, f=i)
+            if massive_testparticle:
+                # REBOUND's own gravity would differ with N_active, so only compare the REBOUNDx forces
+                sim.gravity = "none"
+                sim.particles[2].m = 1.e-4
+                sim.particles[2].r = 0.01
+            sim.move_to_com()
+            sim.N_active = N_active
+            rebx = reboundx.Extras(sim)
+            for name in ['central_force', 'gravitational_harmonics', 'modify_orbits_forces', 'tides_constant_time_lag']:
+                rebx.add_force(rebx.load_force(name))
+            ps = sim.particles
+            ps[0].params['Acentral'] = 1.e-4
+            ps[0].params['gammacentral'] = -2.5
+            ps[0].params['J2'] = 1.e-3
+            ps[0].params['R_eq'] = 0.1
+            ps[0].params['tctl_k2'] = 0.1
+            ps[0].r = 0.01
+            for p in ps[2:]:
+                p.params['tau_a'] = -1.e3
+            if massive_testparticle:
+                # a massive particle beyond N_active is still a central force source and raises tides
+                ps[2].params['Acentral'] = 1.e-5
+                ps[2].params['gammacentral'] = -2.5
+                ps[2].params['tctl_k2'] = 0.1
+            sim.integrate(10.)
+            return sim
+        for massive_testparticle in [False, True]:
+            sim, simtp = run(-1, massive_testparticle), run(2, massive_testparticle)
+            for p, ptp in zip(sim.particles, simtp.particles):
+                self.assertAlmostEqual(p.x, ptp.x, delta=1.e-12)
+                self.assertAlmostEqual(p.vy, ptp.vy, delta=1.e-12)
+
+    def test_grfulltree(self):
+        # tree approximation should converge to the exact sums as the opening angle shrinks
+        def run(opening_angle):
+            sim = rebound.Simulation()
+            sim.integrator = "ias15"
+            sim.add(m=1.)
+            for i in range(30):
+                sim.add(m=1.e-3, a=0.5+0.1*i, e=0.1, inc=0.2*(i%5), Omega=i, f=2.*i)
+            sim.move_to_com()
+            rebx = reboundx.Extras(sim)
+            gr = rebx.load_force('gr_full')
+            rebx.add_force(gr)
+            gr.params['c'] = 100.
+            if opening_angle is not None:
+                gr.params['opening_angle'] = opening_angle
+            sim.integrate(1.)
+            return sim
+        sim, simtree, simtight = run(None), run(0.5), run(1.e-3)
+        for p, ptree, ptight in zip(sim.particles, simtree.particles, simtight.particles):
+            self.assertAlmostEqual(p.x, ptight.x, delta=1.e-12)
+            self.assertAlmostEqual(p.vy, ptight.vy, delta=1.e-12)
+            self.assertAlmostEqual(p.x, ptree.x, delta=1.e-6)
+            self.assertAlmostEqual(p.vy, ptree.vy, delta=1.e-6)
+
+    def test_diskselfgravity(self):
+        # on the axis of a uniform disk, a_z = -2 pi G sigma (1 - z/sqrt(z^2 + rout^2))
+        sim = rebound.Simulation()
+        sim.add(m=1.)
+        sim.add(z=0.5)
+        rebx = reboundx.Extras(sim)
+        dsg = rebx.load_force('disk_self_gravity')
+        dsg.params['dsg_sigma0'] = 1.e-3
+        dsg.params['dsg_rin'] = 0.
+        dsg.params['dsg_rout'] = 1.
+        dsg.params['dsg_Nr'] = 128
+        dsg.params['dsg_Nz'] = 64
+        kf = rebx.load_operator('kick_forces')
+        kf.params['force'] = dsg
+        dt = 1.e-3
+        kf.step(sim, dt)
+        az = sim.particles[1].vz/dt
+        self.assertAlmostEqual(az/(-2.*math.pi*1.e-3*(1.-0.5/math.sqrt(1.25))), 1., delta=3.e-3)
+        # table scales with sigma0 without being rebuilt
+        dsg.params['dsg_sigma0'] = 2.e-3
+        sim.particles[1].vz = 0.
+        kf.step(sim, dt)
+        self.assertAlmostEqual(sim.particles[1].vz/dt, 2.*az, delta=1.e-15)
+
     def test_removeforcenotfirst(self):
         gr = self.rebx.load_force('gr')
         self.rebx.add_force(gr)
@@ -137,6 +260,199 @@ class TestOperators(unittest.TestCase):
         with self.assertRaises(AttributeError):
             mm = self.rebx.get_operator('modify_mass')
     
+    def test_modifymassexponential(self):
+        import math
+        self.sim.integrator = "whfast"
+        self.sim.dt = 0.1
+        self.sim.particles[1].m = 1.e-3
+        mm = self.rebx.load_operator('modify_mass')
+        self.rebx.add_operator(mm)
+        self.sim.particles[0].params['tau_mass'] = -1.
+        for i in range(20):
+            self.sim.step()
+        self.assertAlmostEqual(self.sim.particles[0].m, math.exp(-2.), delta=1.e-14)
+        com = self.sim.com()
+        self.assertAlmostEqual(com.x, 0., delta=1.e-14)
+        self.assertAlmostEqual(com.vy, 0., delta=1.e-14)
+
+    def test_modifymasscom(self):
+        # modify_mass re-centres on the center of mass every step, even if no particle has tau_mass, also with safe_mode=0
+        for integrator in ["whfast", "saba"]:
+            sim = rebound.Simulation()
+            sim.add(m=1.)
+            sim.add(m=1.e-3, a=1., e=0.2)
+            sim.integrator = integrator
+            if integrator == "whfast":
+                sim.ri_whfast.safe_mode = 0
+            else:
+                sim.ri_saba.safe_mode = 0
+            sim.dt = 0.1
+            rebx = reboundx.Extras(sim)
+            mm = rebx.load_operator('modify_mass')
+            rebx.add_operator(mm)
+            self.assertGreater(abs(sim.com().vy), 1.e-4)
+            for i in range(3):
+                sim.step()
+            sim.synchronize()
+            com = sim.com()
+            self.assertAlmostEqual(com.x, 0., delta=1.e-14)
+            self.assertAlmostEqual(com.vy, 0., delta=1.e-14)
+            self.assertAlmostEqual(sim.particles[1].a, 1., delta=1.e-3)
+
+    def check_centralkick(self, kf):
+        ps = self.sim.particles
+        ps[0].params['Acentral'] = 1.e-3
+        ps[0].params['gammacentral'] = -2.
+        ps[1].params['tau_a'] = -1.e2
+        p = ps[1].copy()
+        dt = 0.1
+        kf.step(self.sim, dt)
+        dx, dy = p.x - ps[0].x, p.y - ps[0].y
+        r = (dx*dx + dy*dy)**0.5
+        self.assertEqual(ps[1].x, p.x)
+        self.assertEqual(ps[1].y, p.y)
+        self.assertAlmostEqual(ps[1].vx - p.vx, dt*1.e-3*r**-2*dx/r, delta=1.e-15)
+        self.assertAlmostEqual(ps[1].vy - p.vy, dt*1.e-3*r**-2*dy/r, delta=1.e-15)
+
+    def test_kickforcesall(self):
+        cf = self.rebx.load_force('central_force')
+        self.rebx.add_force(cf)
+        mof = self.rebx.load_force('modify_orbits_forces') # loaded but not added, so shouldn't kick
+        kf = self.rebx.load_operator('kick_forces')
+        self.check_centralkick(kf)
+
+    def test_kickforcesparam(self):
+        cf = self.rebx.load_force('central_force')
+        mof = self.rebx.load_force('modify_orbits_forces')
+        self.rebx.add_force(mof) # added, but operator should only use the force it's passed
+        kf = self.rebx.load_operator('kick_forces')
+        kf.params['force'] = cf
+        self.check_centralkick(kf)
+
+    def test_ias15group(self):
+        def setup():
+            sim = rebound.Simulation()
+            sim.add(m=1.)
+            sim.add(m=1.e-3, a=1., e=0.1)
+            sim.add(m=1.e-9, a=1.01, e=0.05, f=0.1) # close to the planet
+            sim.add(m=3.e-4, a=5., f=2.)
+            sim.move_to_com()
+            return sim
+        dt = 0.3
+        sim = setup()
+        rebx = reboundx.Extras(sim)
+        ias = rebx.load_operator('ias15')
+        ias.step(sim, dt)
+
+        simg = setup()
+        rebxg = reboundx.Extras(simg)
+        for i in range(3):
+            simg.particles[i].params['ias15_group'] = 1
+        outer = simg.particles[3].copy()
+        ias15g = rebxg.load_operator('ias15_group')
+        ias15g.step(simg, dt)
+        self.assertEqual(simg.particles[3].x, outer.x) # not in the group
+        for i in range(3):
+            p, pg = sim.particles[i], simg.particles[i]
+            self.assertAlmostEqual(pg.x, p.x, delta=1.e-9)
+            self.assertAlmostEqual(pg.y, p.y, delta=1.e-9)
+            self.assertAlmostEqual(pg.vx, p.vx, delta=1.e-9)
+            self.assertAlmostEqual(pg.vy, p.vy, delta=1.e-9)
+
+    def setup_gasdrag(self, effect, ts):
+        # pebble in the midplane on the x axis with Epstein stopping time ts
+        rhog, alpha_rhog, cs, alpha_cs, s = 1.e-3, -2.25, 0.05, -0.25, 0.01
+        effect.params['gd_rhog'] = rhog
+        effect.params['gd_alpha_rhog'] = alpha_rhog
+        effect.params['gd_cs'] = cs
+        effect.params['gd_alpha_cs'] = alpha_cs
+        p = self.sim.particles[1]
+        p.vx = 0.1
+        r = p.x
+        rhog_loc, cs_loc = rhog*r**alpha_rhog, cs*r**alpha_cs
+        p.params['gd_s'] = s
+        p.params['gd_rho_s'] = ts*rhog_loc*math.sqrt(8./math.pi)*cs_loc/s
+        vgas = math.sqrt(self.sim.G*self.sim.particles[0].m/r + (alpha_rhog + 2.*alpha_cs)*cs_loc**2)
+        return p.x, p.vx, p.vy, vgas
+
+    def test_gasdragexact(self):
+        gde = self.rebx.load_operator('gas_drag_exact')
+        ts, dt = 0.1, 0.3
+        x, vx, vy, vgas = self.setup_gasdrag(gde, ts)
+        gde.step(self.sim, dt)
+        p = self.sim.particles[1]
+        self.assertEqual(p.x, x)
+        self.assertAlmostEqual(p.vx, vx*math.exp(-dt/ts), delta=1.e-15)
+        self.assertAlmostEqual(p.vy, vgas + (vy-vgas)*math.exp(-dt/ts), delta=1.e-15)
+
+    def test_gasdragforce(self):
+        gd = self.rebx.load_force('gas_drag')
+        ts, dt = 0.1, 1.e-3
+        x, vx, vy, vgas = self.setup_gasdrag(gd, ts)
+        kf = self.rebx.load_operator('kick_forces')
+        kf.params['force'] = gd
+        kf.step(self.sim, dt)
+        p = self.sim.particles[1]
+        self.assertAlmostEqual(p.vx, vx - dt*vx/ts, delta=1.e-15)
+        self.assertAlmostEqual(p.vy, vy - dt*(vy-vgas)/ts, delta=1.e-15)
+
+    def test_flyby(self):
+        fb = self.rebx.load_operator('flyby')
+        m, b, V = 0.5, 10., 3.
+        self.assertEqual(self.rebx.flyby_add(fb, 0.1, m, [b, 0., 0.], [0., V, 0.]), 0)
+        vx = [p.vx for p in self.sim.particles]
+        fb.step(self.sim, 0.01) # before closest approach
+        self.assertEqual(self.rebx.flyby_N_applied(fb), 0)
+        self.sim.t = 0.1
+        fb.step(self.sim, 0.01)
+        fb.step(self.sim, 0.01) # only applied once
+        self.assertEqual(self.rebx.flyby_N_applied(fb), 1)
+        for p, vx0 in zip(self.sim.particles, vx):
+            d = b - p.x
+            x = m/(d*V*V)
+            self.assertAlmostEqual(p.vx - vx0, 2.*m/(V*d)/(1.+x*x), delta=1.e-15)
+
+    def test_flybytidal(self):
+        fb = self.rebx.load_operator('flyby')
+        fb.params['flyby_tidal'] = 1
+        m, b, V = 0.5, 10., 3.
+        self.rebx.flyby_add(fb, 0., m, [b, 0., 0.], [0., V, 0.])
+        ps = self.sim.particles
+        vx, vy = [p.vx for p in ps], [p.vy for p in ps]
+        fb.step(self.sim, 0.01)
+        self.assertEqual(ps[0].vx, vx[0]) # star is at the center of mass
+        self.assertAlmostEqual(ps[1].vx - vx[1], 2.*m/(V*b*b)*ps[1].x, delta=1.e-15)
+        self.assertEqual(ps[1].vy, vy[1])
+        with self.assertRaises(RuntimeError):
+            self.sim.t = 1.
+            self.rebx.flyby_add(fb, 0.5, m, [b, 0., 0.], [0., V, 0.])
+
+    def test_collisionaldamping(self):
+        cd = self.rebx.load_operator('collisional_damping')
+        rho_s, rmin, rmax, loss = 1., 0.5, 2., 0.1
+        cd.params['cd_rho_s'] = rho_s
+        cd.params['cd_rmin'] = rmin
+        cd.params['cd_rmax'] = rmax
+        cd.params['cd_Nr'] = 1
+        cd.params['cd_every'] = 2
+        cd.params['cd_loss'] = loss
+        # two tracers on opposite sides of the same annulus, +-dv off the circular velocity
+        m, s, h, dv, dt = 1.e-6, 1.e-3, 0.01, 0.05, 0.3
+        self.sim.add(x=1., z=h, vy=1.+dv)
+        self.sim.add(x=-1., z=-h, vy=-(1.-dv))
+        for p in self.sim.particles[2:]:
+            p.params['cd_m'] = m
+            p.params['cd_s'] = s
+        cd.step(self.sim, dt)
+        self.assertEqual(self.sim.particles[2].vy, 1.+dv) # waits for cd_every steps
+        cd.step(self.sim, dt)
+        n = m/(4./3.*math.pi*rho_s*s**3)
+        area = math.pi*(rmax**2 - rmin**2)
+        Gamma = math.pi*(2.*s)**2*2.*n/(2.*math.sqrt(math.pi)*h*area)*math.sqrt(2.)*dv
+        self.assertAlmostEqual(self.sim.particles[2].vy, 1.+dv*math.exp(-Gamma*dt), delta=1.e-15)
+        self.assertAlmostEqual(self.sim.particles[3].vy, -(1.-dv*math.exp(-Gamma*dt)), delta=1.e-15)
+        self.assertAlmostEqual(self.sim.particles[2].params['cd_m'], m*math.exp(-loss*Gamma*2.*dt), delta=1.e-20)
+
     def test_removeoperator(self):
         mm = self.rebx.load_operator('modify_mass')
         self.rebx.add_operator(mm)
@@ -199,5 +199,128 @@ class TestParams(unittest.TestCase):
         with self.assertRaises(AttributeError):
             del self.gr.params["b"]
 
+    def test_delparam(self):
+        self.p.params['tau_mass'] = 3.
+        self.p.params['c'] = 2.
+        del self.p.params['tau_mass']
+        with self.assertRaises(AttributeError):
+            self.p.params['tau_mass']
+        self.assertEqual(self.p.params['c'], 2.)
+        self.assertEqual(len(self.p.params), 1)
+
+    def test_paramobserver(self):
+        changes = []
+        observer = self.rebx.add_param_observer('tau_mass', changes.append)
+        self.p.params['tau_mass'] = 3.
+        self.gr.params['c'] = 1. # not observed
+        self.mm.params['tau_mass'] = 2.
+        del self.p.params['tau_mass']
+        self.assertEqual(changes, ['tau_mass']*3)
+        self.rebx.remove_param_observer(observer)
+        self.p.params['tau_mass'] = 1.
+        self.assertEqual(len(changes), 3)
+
+    def test_paramobserverall(self):
+        changes = []
+        self.rebx.add_param_observer(None, changes.append)
+        self.p.params['tau_mass'] = 3.
+        self.gr.params['c'] = 1.
+        self.assertEqual(changes, ['tau_mass', 'c'])
+
+    def test_paramobservernotregistered(self):
+        with self.assertRaises(RuntimeError):
+            self.rebx.add_param_observer('b', print)
+
+class TestParamHandle(unittest.TestCase):
+    def setUp(self):
+        self.sim = rebound.Simulation()
+        self.sim.add(m=1.)
+        for i in range(5):
+            self.sim.add(a=1.+i)
+        self.rebx = reboundx.Extras(self.sim)
+        self.gr = self.rebx.load_force("gr")
+
+    def test_getset(self):
+        h = self.rebx.param_handle('tau_a')
+        ps = self.sim.particles
+        h.set(ps[1], 3.5)
+        self.assertEqual(h.get(ps[1]), 3.5)
+        self.assertEqual(ps[1].params['tau_a'], 3.5)
+        ps[1].params['tau_a'] = 1.5
+        self.assertEqual(h.get(ps[1]), 1.5)
+        with self.assertRaises(AttributeError):
+            h.get(ps[2])
+
+    def test_force(self):
+        h = self.rebx.param_handle('gr_source')
+        h.set(self.gr, 3)
+        self.assertEqual(self.gr.params['gr_source'], 3)
+
+    def test_bulk(self):
+        h = self.rebx.param_handle('tau_a')
+        h.set_all(np.arange(6.))
+        ps = self.sim.particles
+        for i in range(6):
+            self.assertEqual(ps[i].params['tau_a'], float(i))
+        ps[3].params['tau_a'] = -1.
+        tau = h.get_all()
+        self.assertTrue(np.array_equal(tau, [0., 1., 2., -1., 4., 5.]))
+
+    def test_bulk_missing(self):
+        h = self.rebx.param_handle('tau_e')
+        self.sim.particles[2].params['tau_e'] = 7.
+        tau = h.get_all()
+        self.assertEqual(tau[2], 7.)
+        self.assertEqual(np.isnan(tau).sum(), 5)
+        tau = h.get_all(fill=0.)
+        self.assertEqual(tau.sum(), 7.)
+
+    def test_bulk_int(self):
+        h = self.rebx.param_handle('gr_source')
+        h.set_all([0, 1, 0, 1, 0, 1])
+        self.assertTrue(np.array_equal(h.get_all(), [0, 1, 0, 1, 0, 1]))
+
+    def test_view(self):
+        ps = self.sim.particles
+        ps[1].params['tau_a'] = 2.
+        h = self.rebx.param_handle('tau_a')
+        v = h.view(ps[1])
+        self.assertEqual(v[0], 2.)
+        v[0] = 4.
+        self.assertEqual(ps[1].params['tau_a'], 4.)
+        ps[1].params['tau_a'] = 6.
+        self.assertEqual(v[0], 6.)
+
+    def test_vec3d(self):
+        ps = self.sim.particles
+        h = self.rebx.param_handle('Omega')
+        h.set(ps[1], [1., 2., 3.])
+        Omega = h.get(ps[1])
+        self.assertEqual(Omega.z, 3.)
+        v = h.view(ps[1])
+        self.assertEqual(v[1], 2.)
+        v[2] = 5.
+        self.assertEqual(ps[1].params['Omega'].z, 5.)
+
+    def test_not_registered(self):
+        with self.assertRaises(AttributeError):
+            self.rebx.param_handle('asdfkj')
+
+    def test_pointer(self):
+        with self.assertRaises(TypeError):
+            self.rebx.param_handle('free_arrays')
+
+    def test_new_extras(self):
+        # A new Extras may reuse a freed one's address, and register the same parameter name with another type
+        for k in range(6):
+            sim = rebound.Simulation()
+            sim.add(m=1.)
+            sim.add(a=1.)
+            rebx = reboundx.Extras(sim)
+            rebx.register_param('my_param', 'REBX_TYPE_INT' if k % 2 else 'REBX_TYPE_DOUBLE')
+            sim.particles[1].params['my_param'] = 3
+            self.assertIs(type(sim.particles[1].params['my_param']), int if k % 2 else float)
+            del sim, rebx
+
 if __name__ == '__main__':
     unittest.main()
@@ -1,6 +1,10 @@
 import rebound
 import reboundx
 import unittest
+import warnings
+import os
+import pickle
+import tempfile
 
 class TestRebx(unittest.TestCase):
     def setUp(self):
@@ -16,6 +20,109 @@ class TestRebx(unittest.TestCase):
         self.sim.integrate(10)
         self.assertGreater(self.sim.particles[1].pomega, 1.e-4)
     
+    def test_diagnostics(self):
+        mm = self.rebx.load_operator('modify_mass')
+        self.rebx.add_operator(mm) # updater with adaptive IAS15 timesteps
+        self.sim.particles[1].params['tau_mass'] = -1.e6
+        with warnings.catch_warnings(record=True) as w:
+            warnings.simplefilter("always")
+            self.sim.integrate(10.)
+        N = self.rebx.diagnostic_count("adaptive_operator")
+        self.assertEqual(N, self.sim.steps_done)
+        reported = [x for x in w if "adaptive timesteps" in str(x.message)]
+        self.assertEqual(len(reported), len(str(N))) # 1st, 10th, 100th... occurrence
+        self.assertEqual(self.rebx.diagnostics(), {"ADAPTIVE_OPERATOR": N})
+        self.rebx.diagnostics_reset()
+        self.assertEqual(self.rebx.diagnostics(), {})
+
+    def test_work_precision(self):
+        def setup(dt, integrator):
+            sim = rebound.Simulation()
+            sim.add(m=1.)
+            sim.add(a=1., e=0.2)
+            sim.integrator = "whfast"
+            sim.dt = dt
+            rebx = reboundx.Extras(sim)
+            gr = rebx.load_force("gr")
+            gr.params["c"] = 10.
+            op = rebx.load_operator("integrate_force")
+            op.params["force"] = gr
+            op.params["integrator"] = reboundx.integrators[integrator]
+            rebx.add_operator(op)
+            return sim, rebx
+        dts = [0.1, 0.01]
+        euler = reboundx.work_precision(lambda dt: setup(dt, "euler"), dts, 10.)
+        rk4 = reboundx.work_precision(lambda dt: setup(dt, "rk4"), dts, 10.)
+        self.assertEqual([row["dt"] for row in rk4], dts)
+        self.assertEqual(rk4[1]["force_evaluations"], 4*euler[1]["force_evaluations"])
+        self.assertGreater(euler[1]["force_evaluations"], euler[0]["force_evaluations"])
+        self.assertLess(rk4[1]["position"], rk4[0]["position"])
+        self.assertLess(rk4[1]["phase"], rk4[0]["phase"])
+
+    def test_autotune(self):
+        with tempfile.TemporaryDirectory() as tmpdir:
+            filename = os.path.join(tmpdir, "autotune.txt")
+            self.assertFalse(self.rebx.autotune(filename))  # measured and cached
+            tuning = (self.rebx.tuning.omp_threshold, self.rebx.tuning.omp_chunk, self.rebx.tuning.simd)
+            self.assertGreaterEqual(tuning[0], 0)
+            self.assertGreaterEqual(tuning[1], 1)
+            self.assertIn(tuning[2], [0, 1])
+
+            rebx = reboundx.Extras(self.sim.copy())
+            self.assertTrue(rebx.autotune(filename))        # loaded from cache
+            self.assertEqual((rebx.tuning.omp_threshold, rebx.tuning.omp_chunk, rebx.tuning.simd), tuning)
+
+    def test_tuning(self):
+        # the kernels give the same result whatever the settings
+        drift = self.rebx.load_operator("drift")
+        kick = self.rebx.load_operator("kick")
+        ps = self.sim.particles
+        state0 = [(p.x, p.vx) for p in ps]
+        results = []
+        for simd in [0, 1]:
+            for omp_threshold in [0, 2**31-1]:
+                self.rebx.tuning.simd = simd
+                self.rebx.tuning.omp_threshold = omp_threshold
+                for p, (x, vx) in zip(ps, state0):
+                    p.x = x
+                    p.vx = vx
+                drift.step(self.sim, 0.1)
+                kick.step(self.sim, 0.1)
+                results.append([(p.x, p.vx) for p in ps])
+        for result in results[1:]:
+            self.assertEqual(result, results[0])
+        self.assertAlmostEqual(results[0][1][0], state0[1][0] + 0.1*state0[1][1], delta=1e-15)
+
+    def test_pickle(self):
+        gr = self.rebx.load_force("gr")
+        gr.params["c"] = 10.
+        self.rebx.add_force(gr)
+        mm = self.rebx.load_operator("modify_mass")
+        self.rebx.add_operator(mm)
+        self.sim.particles[1].params["tau_mass"] = -1.e4
+
+        sim, rebx = pickle.loads(pickle.dumps((self.sim, self.rebx)))
+        self.assertIs(sim._extras_ref, rebx)
+        self.assertEqual(rebx.get_force("gr").params["c"], 10.)
+        self.assertEqual(sim.particles[1].params["tau_mass"], -1.e4)
+        self.sim.integrate(10.)
+        sim.integrate(10.)
+        self.assertEqual(self.sim.particles[1].x, sim.particles[1].x)
+        self.assertEqual(self.sim.particles[1].m, sim.particles[1].m)
+
+        # the simulation comes along when pickling rebx on its own
+        rebx = pickle.loads(pickle.dumps(self.rebx))
+        self.assertEqual(rebx._sim.contents.t, self.sim.t)
+        self.assertEqual(rebx._sim.contents.particles[1].params["tau_mass"], -1.e4)
+
+    def test_save_to_bytes(self):
+        self.sim.particles[1].params["tau_mass"] = -1.e4
+        sim = rebound.Simulation()
+        sim.add(m=1.)
+        sim.add(a=1., e=0.2)
+        rebx = reboundx.Extras(sim, self.rebx.save_to_bytes())
+        self.assertEqual(sim.particles[1].params["tau_mass"], -1.e4)
+
     def test_total_angular_momentum(self):
         sim = rebound.Simulation()
         sim.add(m=1)
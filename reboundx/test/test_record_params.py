@@ -0,0 +1,88 @@
+import rebound
+import reboundx
+import unittest
+import math
+import os
+import numpy as np
+
+class TestRecordParams(unittest.TestCase):
+    def setUp(self):
+        self.sim = rebound.Simulation()
+        self.sim.integrator = "whfast"
+        self.sim.dt = 1.e-2
+        self.sim.add(m=1.)
+        self.sim.add(m=1.e-3, a=1.)
+        self.sim.move_to_com()
+        self.rebx = reboundx.Extras(self.sim)
+        self.rp = self.rebx.load_operator("record_params")
+
+    def test_channels(self):
+        self.rp.params["rp_interval"] = 2
+        self.sim.particles[1].params["tau_mass"] = -100.
+        self.sim.particles[1].params["Omega"] = rebound.Vec3d(0., 0., 3.)
+        self.rebx.record_params_add_channel(self.rp, 1, "x")
+        self.rebx.record_params_add_channel(self.rp, 1, "tau_mass")
+        self.rebx.record_params_add_channel(self.rp, 1, "Omega.z")
+        self.rebx.record_params_add_channel(self.rp, 0, "tau_mass")    # not set on star
+        self.rebx.add_operator(self.rp)
+
+        ts, xs = [], []
+        for k in range(20):
+            self.sim.step()
+            if k % 2 == 0:
+                ts.append(self.sim.t)
+                xs.append(self.sim.particles[1].x)
+        t, values = self.rebx.record_params(self.rp)
+        self.assertEqual(values.shape, (4, 10))
+        np.testing.assert_allclose(t, ts)
+        np.testing.assert_allclose(values[0], xs)
+        np.testing.assert_allclose(values[1], -100.)
+        np.testing.assert_allclose(values[2], 3.)
+        self.assertTrue(np.all(np.isnan(values[3])))
+
+    def test_ring_buffer(self):
+        self.rp.params["rp_capacity"] = 10
+        self.rebx.record_params_add_channel(self.rp, 1, "m")
+        self.rebx.add_operator(self.rp)
+        for k in range(25):
+            self.sim.step()
+        t, values = self.rebx.record_params(self.rp)
+        np.testing.assert_allclose(t, self.sim.dt*np.arange(16, 26))
+        np.testing.assert_allclose(values[0], 1.e-3)
+
+    def test_file(self):
+        filename = "test_record_params.bin"
+        self.rp.params["rp_capacity"] = 8
+        self.rebx.record_params_add_channel(self.rp, 1, "x")
+        self.rebx.record_params_add_channel(self.rp, 1, "vx")
+        self.rebx.add_operator(self.rp)
+        self.sim.step()
+        self.rebx.record_params_set_file(self.rp, filename)
+        xs = [self.sim.particles[1].x]
+        for k in range(19):
+            self.sim.step()
+            xs.append(self.sim.particles[1].x)
+        self.rebx.record_params_flush(self.rp)
+        t, values = reboundx.read_record_params(filename)
+        os.remove(filename)
+        np.testing.assert_allclose(t, self.sim.dt*np.arange(1, 21))
+        np.testing.assert_allclose(values[0], xs)
+        self.assertEqual(values.shape, (2, 20))
+
+    def test_copies(self):
+        self.rebx.record_params_add_channel(self.rp, 1, "m")
+        self.rebx.add_operator(self.rp)
+        for k in range(5):
+            self.sim.step()
+        t, values = self.rebx.record_params(self.rp)
+        self.rebx.record_params_add_channel(self.rp, 1, "x")  # reallocates and clears the buffer
+        self.sim.step()
+        np.testing.assert_allclose(t, self.sim.dt*np.arange(1, 6))
+        np.testing.assert_allclose(values[0], 1.e-3)
+
+    def test_invalid_channel(self):
+        with self.assertRaises(RuntimeError):
+            self.rebx.record_params_add_channel(self.rp, 1, "not_a_param")
+
+if __name__ == '__main__':
+    unittest.main()
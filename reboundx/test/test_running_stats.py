@@ -0,0 +1,79 @@
+import rebound
+import reboundx
+import unittest
+import math
+import numpy as np
+
+class TestRunningStats(unittest.TestCase):
+    def setUp(self):
+        self.sim = rebound.Simulation()
+        self.sim.integrator = "whfast"
+        self.sim.dt = 1.e-2
+        self.sim.add(m=1.)
+        self.sim.add(m=1.e-3, a=1., e=0.05)
+        self.sim.add(m=1.e-3, a=1.6, e=0.1, inc=0.1)
+        self.sim.move_to_com()
+        self.rebx = reboundx.Extras(self.sim)
+        self.rs = self.rebx.load_operator("running_stats")
+        self.rebx.add_operator(self.rs)
+
+    def test_brute_force(self):
+        for name in ["a", "e", "l"]:
+            self.rebx.running_stats_add(self.rs, name)
+        self.sim.particles[2].params["tau_a"] = -1.e4
+        self.rebx.running_stats_add(self.rs, "tau_a")
+
+        samples = {"a":[], "e":[], "l":[]}
+        for k in range(500):
+            self.sim.step()
+            ps = self.sim.particles
+            for name in samples:
+                samples[name].append([getattr(ps[i].orbit(primary=ps[0]), name) for i in range(1, self.sim.N)])
+
+        for name, values in samples.items():
+            values = np.array(values)
+            if name == "l":
+                values = np.unwrap(values, axis=0)
+            stats = self.rebx.running_stats(self.rs, name)
+            self.assertEqual(stats["n"][0], 0)
+            self.assertTrue(math.isnan(stats["mean"][0]))
+            np.testing.assert_array_equal(stats["n"][1:], [500, 500])
+            np.testing.assert_allclose(stats["mean"][1:], values.mean(axis=0), rtol=1.e-10)
+            np.testing.assert_allclose(stats["var"][1:], values.var(axis=0), rtol=1.e-7, atol=1.e-15)
+            np.testing.assert_allclose(stats["min"][1:], values.min(axis=0), rtol=1.e-12)
+            np.testing.assert_allclose(stats["max"][1:], values.max(axis=0), rtol=1.e-12)
+
+        stats = self.rebx.running_stats(self.rs, "tau_a")
+        np.testing.assert_array_equal(stats["n"], [0, 0, 500])
+        self.assertAlmostEqual(stats["mean"][2], -1.e4, delta=1.e-10)
+        self.assertAlmostEqual(stats["var"][2], 0., delta=1.e-10)
+
+    def test_params(self):
+        self.rebx.running_stats_add(self.rs, "e")
+        for k in range(100):
+            self.sim.step()
+        ps = self.sim.particles
+        stats = self.rebx.running_stats(self.rs, "e")
+        with self.assertRaises(AttributeError):
+            ps[0].params["e_mean"]
+        for i in range(1, self.sim.N):
+            for key in ["mean", "var", "min", "max"]:
+                self.assertEqual(ps[i].params["e_"+key], stats[key][i])
+
+        self.rebx.running_stats_reset(self.rs)
+        with self.assertRaises(AttributeError):
+            ps[1].params["e_mean"]
+
+    def test_interval(self):
+        self.rebx.running_stats_add(self.rs, "a")
+        self.rs.params["rs_interval"] = 10
+        for k in range(95):
+            self.sim.step()
+        self.assertEqual(self.rebx.running_stats(self.rs, "a")["n"][1], 10)
+
+    def test_invalid_quantity(self):
+        with self.assertRaises(RuntimeError):
+            self.rebx.running_stats_add(self.rs, "not_a_param")
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,103 @@
+import rebound
+import reboundx
+import unittest
+import numpy as np
+
+class TestTidesAveragedAnalytic(unittest.TestCase):
+    def setUp(self):
+        self.sim = rebound.Simulation()
+        self.sim.add(m=0.86, r = 0.78)
+        self.sim.add(m=3.e-6, a=1., e=0.05)
+        self.sim.move_to_com()
+        ps = self.sim.particles
+        self.sim.integrator = "whfast"
+        self.sim.dt = 10.*ps[1].P # timestep spanning many orbits
+
+        self.rebx = reboundx.Extras(self.sim)
+        self.tides = self.rebx.load_operator("tides_constant_time_lag_averaged")
+        self.rebx.add_operator(self.tides)
+        ps[0].params["tctl_k2"] = 0.023
+        ps[0].params["tctl_tau"] = 0.3
+
+        self.q = (ps[1].m/ps[0].m)
+        self.T = ps[0].r**3/self.sim.G/ps[0].m/ps[0].params["tctl_tau"]
+        self.taua = self.T/6/ps[0].params["tctl_k2"]/self.q/(1+self.q)*(ps[1].a/ps[0].r)**8
+
+    def test_adamping(self):
+        ps = self.sim.particles
+        tmax = 2e4*ps[1].P
+        apred = ps[0].r*((ps[1].a/ps[0].r)**8 - 48.*ps[0].params["tctl_k2"]*self.q*(1+self.q)*tmax/self.T)**(1./8.)
+
+        self.sim.integrate(tmax)
+        self.assertLess(abs((ps[1].a-apred)/apred), 1.e-2) # 1%
+
+    def test_linear_adamping(self):
+        ps = self.sim.particles
+        tmax = self.taua/1000
+        apred = ps[1].a*np.exp(-tmax/self.taua)
+
+        self.sim.integrate(tmax)
+        self.assertLess(abs((ps[1].a-apred)/apred), 0.1) # 10%
+
+    def test_linear_edamping(self):
+        ps = self.sim.particles
+        tmax = self.taua/1000
+        epred = ps[1].e*np.exp(-tmax/(6./27.*self.taua))
+
+        self.sim.integrate(tmax)
+        self.assertLess(abs((ps[1].e-epred)/epred), 0.1) # 10%
+
+    def test_agrees_with_direct(self):
+        sim = rebound.Simulation()
+        sim.add(m=0.86, r = 0.78)
+        sim.add(m=3.e-6, a=1., e=0.05)
+        sim.move_to_com()
+        rebx = reboundx.Extras(sim)
+        tides = rebx.load_force("tides_constant_time_lag")
+        rebx.add_force(tides)
+        sim.particles[0].params["tctl_k2"] = 0.023
+        sim.particles[0].params["tctl_tau"] = 0.3
+
+        tmax = 2e3*sim.particles[1].P
+        sim.integrate(tmax)
+        self.sim.integrate(tmax)
+        a0 = 1.
+        dadirect = sim.particles[1].a - a0
+        daavg = self.sim.particles[1].a - a0
+        self.assertLess(abs((daavg-dadirect)/dadirect), 1.e-2) # 1%
+
+    def test_no_tau(self):
+        ps = self.sim.particles
+        ps[0].params["tctl_tau"] = 0.
+        a0, e0 = ps[1].a, ps[1].e
+        self.sim.integrate(1.e3*ps[1].P)
+        self.assertAlmostEqual(ps[1].a, a0, delta=1.e-12)
+        self.assertAlmostEqual(ps[1].e, e0, delta=1.e-12)
+
+class TestTidesAveragedSpin(unittest.TestCase):
+    def test_spin_synchronization(self):
+        sim = rebound.Simulation()
+        sim.add(m=1.)
+        sim.add(m=1.e-3, a=0.05, r=0.0005)
+        sim.move_to_com()
+        sim.integrator = "whfast"
+        ps = sim.particles
+        sim.dt = 10.*ps[1].P
+        rebx = reboundx.Extras(sim)
+        tides = rebx.load_operator("tides_constant_time_lag_averaged")
+        rebx.add_operator(tides)
+        n = ps[1].n
+        ps[1].params["tctl_k2"] = 0.3
+        ps[1].params["tctl_tau"] = 1.e-3
+        ps[1].params["I"] = 0.25*ps[1].m*ps[1].r**2
+        ps[1].params["OmegaMag"] = 3.*n
+
+        sim.integrate(1.e3*ps[1].P)
+        Omega1 = ps[1].params["OmegaMag"]
+        self.assertLess(Omega1, 3.*n)
+        self.assertGreater(Omega1, n)
+        # planet spinning faster than the orbit pushes the orbit outward
+        self.assertGreater(ps[1].a, 0.05)
+
+if __name__ == '__main__':
+    unittest.main()
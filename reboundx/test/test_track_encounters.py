@@ -0,0 +1,85 @@
+import rebound
+import reboundx
+import unittest
+import math
+import numpy as np
+
+class TestTrackEncounters(unittest.TestCase):
+    def setUp(self):
+        self.sim = rebound.Simulation()
+        self.sim.integrator = "whfast"
+        self.sim.dt = 1.e-2
+        self.sim.add(m=1.)
+        self.sim.add(m=1.e-3, a=1.)
+        self.sim.add(m=1.e-4, a=1.5, f=2.)
+        self.sim.N_active = self.sim.N
+        for i in range(50):
+            self.sim.add(a=1.25, e=0.3, inc=0.002*i, f=2.*math.pi*i/50.)
+        self.sim.move_to_com()
+        self.rebx = reboundx.Extras(self.sim)
+        self.te = self.rebx.load_operator("track_encounters")
+        self.radius = 0.1
+        self.te.params["te_radius"] = self.radius
+        self.rebx.add_operator(self.te)
+
+    def brute_force(self, tracked, targets):
+        ps = self.sim.particles
+        min_distances = np.full((len(tracked), len(targets)), np.inf)
+        counts = np.zeros((len(tracked), len(targets)), dtype=int)
+        inside = np.zeros((len(tracked), len(targets)), dtype=bool)
+        for step in range(300):
+            self.sim.step()
+            for j, jp in enumerate(tracked):
+                for t, tp in enumerate(targets):
+                    p, target = ps[jp], ps[tp]
+                    r = math.sqrt((p.x-target.x)**2 + (p.y-target.y)**2 + (p.z-target.z)**2)
+                    if r < self.radius:
+                        if not inside[j,t]:
+                            counts[j,t] += 1
+                        inside[j,t] = True
+                        min_distances[j,t] = min(min_distances[j,t], r)
+                    else:
+                        inside[j,t] = False
+
+        te_tracked, te_targets = self.rebx.track_encounters_indices(self.te)
+        np.testing.assert_array_equal(te_tracked, tracked)
+        np.testing.assert_array_equal(te_targets, targets)
+        te_min_distances = self.rebx.track_encounters_min_distances(self.te)
+        te_counts = self.rebx.track_encounters_counts(self.te)
+        self.assertEqual(te_min_distances.shape, (len(tracked), len(targets)))
+        self.assertGreater(counts.sum(), 0)
+        np.testing.assert_array_equal(te_counts, counts)
+        np.testing.assert_allclose(te_min_distances, min_distances, rtol=1.e-12)
+
+    def test_brute_force(self):
+        N_active = self.sim.N_active
+        self.brute_force(list(range(N_active, self.sim.N)), list(range(1, N_active)))
+
+    def test_groups(self):
+        # track only the first planet and every other test particle, and make a test particle a target
+        ps = self.sim.particles
+        self.sim.N_active = -1
+        targets = [1, 3]
+        tracked = list(range(5, self.sim.N, 2))
+        for i in targets:
+            ps[i].params["te_group"] = 1
+        for i in tracked:
+            ps[i].params["te_group"] = 2
+        self.brute_force(tracked, targets)
+
+    def test_no_radius(self):
+        op = self.rebx.load_operator("track_encounters")
+        self.rebx.add_operator(op)
+        with self.assertRaises(RuntimeError):
+            self.sim.step()
+
+    def test_nonpositive_radius(self):
+        op = self.rebx.load_operator("track_encounters")
+        self.rebx.add_operator(op)
+        for te_radius in [0., -1.]:
+            op.params["te_radius"] = te_radius
+            with self.assertRaises(RuntimeError):
+                self.sim.step()
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,65 @@
+import rebound
+import reboundx
+import unittest
+import math
+import os
+import numpy as np
+
+class TestTrackEvents(unittest.TestCase):
+    def setUp(self):
+        self.sim = rebound.Simulation()
+        self.sim.integrator = "whfast"
+        self.sim.dt = 2.*math.pi/60.
+        self.sim.add(m=1.)
+        self.a = 1.
+        self.e = 0.5
+        self.M = 1.
+        self.sim.add(a=self.a, e=self.e, inc=0.3, omega=0.5, M=self.M)   # test particle, so star stays at origin
+        self.rebx = reboundx.Extras(self.sim)
+        self.ev = self.rebx.load_operator("track_events")
+        self.rebx.add_operator(self.ev)
+
+    def test_pericenter(self):
+        self.ev.params["ev_events"] = reboundx.events["PERICENTER"] | reboundx.events["APOCENTER"]
+        self.sim.integrate(4.*2.*math.pi)
+        events = self.rebx.track_events(self.ev)
+        peri = events[events["type"] == reboundx.events["PERICENTER"]]
+        apo = events[events["type"] == reboundx.events["APOCENTER"]]
+        self.assertEqual(len(peri), 4)
+        self.assertEqual(len(apo), 4)
+        t_peri = 2.*math.pi - self.M + 2.*math.pi*np.arange(4)
+        np.testing.assert_allclose(peri["t"], t_peri, atol=1.e-3)
+        np.testing.assert_array_equal(peri["index"], 1)
+        r = np.sqrt(peri["x"]**2 + peri["y"]**2 + peri["z"]**2)
+        np.testing.assert_allclose(r, self.a*(1.-self.e), rtol=2.e-4)
+        np.testing.assert_allclose(apo["t"], t_peri - math.pi, atol=1.e-3)
+
+    def test_nodes(self):
+        self.ev.params["ev_events"] = reboundx.events["ASCENDING_NODE"] | reboundx.events["DESCENDING_NODE"]
+        self.sim.integrate(3.*2.*math.pi)
+        events = self.rebx.track_events(self.ev)
+        self.assertEqual(len(events), 6)
+        np.testing.assert_allclose(events["z"], 0., atol=1.e-5)
+        self.assertTrue(np.all(events["type"][events["vz"] > 0] == reboundx.events["ASCENDING_NODE"]))
+        self.assertTrue(np.all(events["type"][events["vz"] < 0] == reboundx.events["DESCENDING_NODE"]))
+
+    def test_file(self):
+        filename = "test_track_events.bin"
+        self.ev.params["ev_events"] = reboundx.events["PERICENTER"]
+        self.sim.integrate(2.*2.*math.pi)
+        in_memory = self.rebx.track_events(self.ev)
+        self.rebx.track_events_set_file(self.ev, filename)
+        self.sim.integrate(4.*2.*math.pi)
+        self.rebx.track_events_flush(self.ev)
+        self.assertEqual(len(self.rebx.track_events(self.ev)), 0)
+        events = np.fromfile(filename, dtype=reboundx.event_dtype)
+        os.remove(filename)
+        self.assertEqual(len(events), 4)
+        np.testing.assert_array_equal(events[:2], in_memory)
+
+    def test_missing_events(self):
+        with self.assertRaises(RuntimeError):
+            self.sim.integrate(1.)
+
+if __name__ == '__main__':
+    unittest.main()
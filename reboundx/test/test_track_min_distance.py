@@ -0,0 +1,38 @@
+import rebound
+import reboundx
+import unittest
+
+class TestTrackMinDistance(unittest.TestCase):
+    def setUp(self):
+        self.sim = rebound.Simulation()
+        self.sim.integrator = "whfast"
+        self.sim.dt = 0.13
+        self.sim.add(m=1.)
+        self.q = 0.1
+        e = 3.
+        self.sim.add(a=self.q/(1.-e), e=e, f=-2.)     # hyperbolic flyby with pericenter distance q
+        self.sim.move_to_com()
+        self.rebx = reboundx.Extras(self.sim)
+        self.tmd = self.rebx.load_operator("track_min_distance")
+        self.rebx.add_operator(self.tmd)
+        self.sim.particles[1].params["min_distance"] = 10.
+
+    def test_step_boundaries(self):
+        self.sim.integrate(3.)
+        self.assertGreater(self.sim.particles[1].params["min_distance"] - self.q, 1.e-3)
+
+    def test_dense_output(self):
+        self.tmd.params["min_distance_dense_output"] = 1
+        self.sim.integrate(3.)
+        self.assertAlmostEqual(self.sim.particles[1].params["min_distance"], self.q, delta=1.e-4)
+
+    def test_dense_output_orbit(self):
+        self.tmd.params["min_distance_dense_output"] = 1
+        orbit = rebound.Orbit()
+        self.sim.particles[1].params["min_distance_orbit"] = orbit
+        self.sim.integrate(3.)
+        orbit = self.sim.particles[1].params["min_distance_orbit"]
+        self.assertAlmostEqual(orbit.d, self.sim.particles[1].params["min_distance"], delta=1.e-12)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -2,6 +2,103 @@ from . import clibreboundx
 from ctypes import c_double
 
 coordinates = {"JACOBI":0, "BARYCENTRIC":1, "PARTICLE":2} # to use C version's REBX_COORDINATES enum
+events = {"PERICENTER":1, "APOCENTER":2, "ASCENDING_NODE":4, "DESCENDING_NODE":8, "RESONANCE":16} # to use C version's REBX_EVENT enum
+diagnostics = {"SPIN_ODE_MISSING":0, "ADAPTIVE_OPERATOR":1, "GR_NOT_CONVERGED":2, "GR_FULL_NOT_CONVERGED":3, "IMPLICIT_MIDPOINT_NOT_CONVERGED":4} # to use C version's rebx_diagnostic enum
+event_dtype = [("t", "f8"), ("index", "i4"), ("type", "i4"), ("x", "f8"), ("y", "f8"), ("z", "f8"), ("vx", "f8"), ("vy", "f8"), ("vz", "f8")] # matches struct rebx_event
+
+def read_record_params(filename):
+    """
+    Reads a file written by the record_params operator. Returns a tuple (t, values), with t a numpy array of times and values
+    a numpy array of shape (N_channels, N_samples).
+    """
+    import numpy as np
+    with open(filename, "rb") as f:
+        N_channels = int(np.fromfile(f, dtype=np.int32, count=1)[0])
+        blocks = []
+        while True:
+            N_rows = np.fromfile(f, dtype=np.int64, count=1)
+            if len(N_rows) == 0:
+                break
+            blocks.append(np.fromfile(f, dtype=np.float64, count=(N_channels+1)*int(N_rows[0])).reshape(N_channels+1, int(N_rows[0])))
+    columns = np.concatenate(blocks, axis=1) if blocks else np.zeros((N_channels+1, 0))
+    return columns[0], columns[1:]
+
+def work_precision(setup, dts, tmax, dt_reference=None, filename=None):
+    """
+    Measures cost versus accuracy for a scenario and configuration (integrator, splitting, integrate_force scheme, ...) over a
+    sweep of timesteps, to choose the cheapest configuration that meets an accuracy target.
+
+    setup(dt) must return a new (sim, rebx) pair, set up with timestep dt, that integrate to tmax. Each run is compared against a
+    reference run with timestep dt_reference (defaults to a tenth of the smallest dt). Returns a list with a dictionary for
+    each dt with the wall time of the integration, the number of REBOUNDx force evaluations and timesteps, and the following
+    errors at tmax (maximized over particles[1:], with orbits from sim.orbits()):
+
+    - energy: relative difference in sim.energy() from the reference
+    - position: distance from the reference position, relative to the reference distance from the origin
+    - phase: difference in mean longitude (radians, wrapped to [-pi, pi])
+    - a: relative difference in semimajor axis
+    - e, inc: absolute differences in eccentricity and inclination
+
+    If filename is passed, also writes the results as a CSV file with one row per dt.
+
+    Example comparing integrate_force schemes::
+
+        def setup(dt, integrator):
+            sim = rebound.Simulation()
+            ...
+            rebx = reboundx.Extras(sim)
+            op = rebx.load_operator("integrate_force")
+            op.params["force"] = force
+            op.params["integrator"] = reboundx.integrators[integrator]
+            rebx.add_operator(op)
+            return sim, rebx
+
+        for integrator in ["euler", "rk2", "rk4", "implicit_midpoint"]:
+            data = reboundx.work_precision(lambda dt: setup(dt, integrator), [0.1, 0.03, 0.01], tmax=100.)
+    """
+    import math
+    import time
+
+    def run(dt):
+        sim, rebx = setup(dt)
+        evaluations = rebx.force_evaluations
+        steps = sim.steps_done
+        start = time.perf_counter()
+        sim.integrate(tmax)
+        wall_time = time.perf_counter() - start
+        return sim, rebx, wall_time, rebx.force_evaluations - evaluations, sim.steps_done - steps
+
+    def state(sim):
+        return sim.energy(), [(p.x, p.y, p.z) for p in sim.particles[1:]], sim.orbits()
+
+    if dt_reference is None:
+        dt_reference = min(dts)/10.
+    sim, rebx, _, _, _ = run(dt_reference)
+    E_ref, xyz_ref, orbits_ref = state(sim)
+
+    results = []
+    for dt in dts:
+        sim, rebx, wall_time, evaluations, steps = run(dt)
+        E, xyz, orbits = state(sim)
+        row = {"dt": dt, "wall_time": wall_time, "force_evaluations": evaluations, "steps": steps,
+               "energy": abs((E - E_ref)/E_ref) if E_ref != 0. else abs(E - E_ref),
+               "position": 0., "phase": 0., "a": 0., "e": 0., "inc": 0.}
+        for r, r_ref, o, o_ref in zip(xyz, xyz_ref, orbits, orbits_ref):
+            d_ref = math.sqrt(sum(x*x for x in r_ref))
+            row["position"] = max(row["position"], math.sqrt(sum((x - x_ref)**2 for x, x_ref in zip(r, r_ref)))/d_ref)
+            row["phase"] = max(row["phase"], abs(math.remainder(o.l - o_ref.l, 2.*math.pi)))
+            row["a"] = max(row["a"], abs((o.a - o_ref.a)/o_ref.a))
+            row["e"] = max(row["e"], abs(o.e - o_ref.e))
+            row["inc"] = max(row["inc"], abs(o.inc - o_ref.inc))
+        results.append(row)
+
+    if filename is not None:
+        keys = list(results[0].keys()) if results else []
+        with open(filename, "w") as f:
+            f.write(",".join(keys) + "\n")
+            for row in results:
+                f.write(",".join("{0:.17g}".format(row[k]) for k in keys) + "\n")
+    return results
 
 #function to test whether REBOUND shared library can be located and called correctly
 def install_test():
@@ -0,0 +1,217 @@
+/**
+ * @file    autotune.c
+ * @brief   Measures the fastest settings for the stepper kernels' particle loops on this machine.
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "rebound.h"
+#include "reboundx.h"
+#include "core.h"
+
+#define REBX_AUTOTUNE_NMAX 65536        // Largest number of particles timed
+#define REBX_AUTOTUNE_NMIN 64           // Smallest number of particles timed for the OpenMP threshold
+#define REBX_AUTOTUNE_MIN_TIME 2e-3     // Minimum duration (s) of each timing, to average over timer resolution
+#define REBX_AUTOTUNE_KEY_LENGTH 512
+
+static double rebx_autotune_wtime(void){
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double)clock()/CLOCKS_PER_SEC;   // single threaded, so CPU time is wall time
+#endif
+}
+
+// Identifies the machine the settings were measured on: CPU model and number of OpenMP threads.
+static void rebx_autotune_key(char* const key, const size_t size){
+    char model[REBX_AUTOTUNE_KEY_LENGTH] = "unknown cpu";
+#ifdef __APPLE__
+    size_t len = sizeof(model);
+    if (sysctlbyname("machdep.cpu.brand_string", model, &len, NULL, 0) != 0){
+        strcpy(model, "unknown cpu");
+    }
+#else
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    if (f){
+        char line[REBX_AUTOTUNE_KEY_LENGTH];
+        while (fgets(line, sizeof(line), f)){
+            if (strncmp(line, "model name", 10) == 0){
+                const char* const colon = strchr(line, ':');
+                if (colon){
+                    const char* start = colon + 1;
+                    while (*start == ' '){
+                        start++;
+                    }
+                    strncpy(model, start, sizeof(model)-1);
+                    model[strcspn(model, "\n")] = '\0';
+                }
+                break;
+            }
+        }
+        fclose(f);
+    }
+#endif
+    // tabs separate the key from the settings in the cache file
+    for (char* c = model; *c != '\0'; c++){
+        if (*c == '\t'){
+            *c = ' ';
+        }
+    }
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    snprintf(key, size, "%s|%d threads", model, threads);
+}
+
+// Returns 1 and sets tuning from the last valid line of the cache file matching key, 0 if there is none.
+static int rebx_autotune_load(const char* const filename, const char* const key, struct rebx_tuning* const tuning){
+    FILE* f = fopen(filename, "r");
+    if (f == NULL){
+        return 0;
+    }
+    int found = 0;
+    char line[2*REBX_AUTOTUNE_KEY_LENGTH];
+    while (fgets(line, sizeof(line), f)){
+        char* const tab = strrchr(line, '\t');
+        if (tab == NULL){
+            continue;
+        }
+        *tab = '\0';
+        if (strcmp(line, key) != 0){
+            continue;
+        }
+        struct rebx_tuning t;
+        if (sscanf(tab+1, "%d %d %d", &t.omp_threshold, &t.omp_chunk, &t.simd) == 3 && t.omp_threshold >= 0 && t.omp_chunk >= 1 && (t.simd == 0 || t.simd == 1)){
+            *tuning = t;
+            found = 1;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+// Time per call (s) of a drift and a kick over N particles, best of three.
+static double rebx_autotune_time(const struct rebx_tuning* const tuning, struct reb_particle* const particles, const int N){
+    double best = -1.;
+    for (int trial=0; trial<3; trial++){
+        int reps = 1;
+        double elapsed;
+        while (1){
+            const double start = rebx_autotune_wtime();
+            for (int k=0; k<reps; k++){
+                // alternating signs keep the particles bounded however many reps are taken
+                const double dt = (k % 2) ? -1e-3 : 1e-3;
+                rebx_drift_particles(tuning, particles, N, dt);
+                rebx_kick_particles(tuning, particles, N, dt);
+            }
+            elapsed = rebx_autotune_wtime() - start;
+            if (elapsed >= REBX_AUTOTUNE_MIN_TIME || reps >= (1<<24)){
+                break;
+            }
+            reps *= 2;
+        }
+        const double t = elapsed/reps;
+        if (best < 0. || t < best){
+            best = t;
+        }
+    }
+    return best;
+}
+
+static void rebx_autotune_calibrate(struct rebx_tuning* const tuning){
+    struct reb_particle* const particles = calloc(REBX_AUTOTUNE_NMAX, sizeof(*particles));
+    for (int i=0; i<REBX_AUTOTUNE_NMAX; i++){
+        particles[i].x = i;
+        particles[i].vx = 1.;
+        particles[i].ax = -1.;
+    }
+
+    // Plain vs vectorized loops, serially. Compare time per particle both in cache (small N) and out of it.
+    struct rebx_tuning serial = {.omp_threshold = INT_MAX, .omp_chunk = 1, .simd = 0};
+    const int Nsimd[3] = {256, 4096, REBX_AUTOTUNE_NMAX};
+    double tsimd[2] = {0., 0.};
+    for (int simd=0; simd<2; simd++){
+        serial.simd = simd;
+        for (int j=0; j<3; j++){
+            tsimd[simd] += rebx_autotune_time(&serial, particles, Nsimd[j])/Nsimd[j];
+        }
+    }
+    serial.simd = (tsimd[1] < tsimd[0]);
+    *tuning = serial;
+
+#ifdef _OPENMP
+    if (omp_get_max_threads() > 1){
+        // Chunk size for the guided schedule at the largest N
+        const int chunks[5] = {1, 16, 64, 256, 1024};
+        struct rebx_tuning parallel = serial;
+        parallel.omp_threshold = 0;
+        double tbest = -1.;
+        for (int j=0; j<5; j++){
+            parallel.omp_chunk = chunks[j];
+            const double t = rebx_autotune_time(&parallel, particles, REBX_AUTOTUNE_NMAX);
+            if (tbest < 0. || t < tbest){
+                tbest = t;
+                tuning->omp_chunk = chunks[j];
+            }
+        }
+        parallel.omp_chunk = tuning->omp_chunk;
+        // Threshold is the smallest N above which running in parallel is always faster
+        for (int N=REBX_AUTOTUNE_NMAX; N>=REBX_AUTOTUNE_NMIN; N/=2){
+            if (rebx_autotune_time(&parallel, particles, N) >= rebx_autotune_time(&serial, particles, N)){
+                break;
+            }
+            tuning->omp_threshold = N;
+        }
+    }
+#endif // _OPENMP
+    free(particles);
+}
+
+int rebx_autotune(struct rebx_extras* const rebx, const char* const filename){
+    char key[REBX_AUTOTUNE_KEY_LENGTH];
+    rebx_autotune_key(key, sizeof(key));
+    if (filename && rebx_autotune_load(filename, key, &rebx->tuning)){
+        return 1;
+    }
+    rebx_autotune_calibrate(&rebx->tuning);
+    if (filename){
+        FILE* f = fopen(filename, "a");
+        if (f == NULL){
+            rebx_error(rebx, "REBOUNDx Error: Could not open autotune cache file for writing. Settings were measured but not saved.\n");
+            return -1;
+        }
+        fprintf(f, "%s\t%d %d %d\n", key, rebx->tuning.omp_threshold, rebx->tuning.omp_chunk, rebx->tuning.simd);
+        fclose(f);
+    }
+    return 0;
+}
@@ -36,7 +36,11 @@
  * 
  * Adds a general central acceleration of the form a=Acentral*r^gammacentral, outward along the direction from a central particle to the body.
  * Effect is turned on by adding Acentral and gammacentral parameters to a particle, which will act as the central body for the effect,
- * and will act on all other particles.
+ * and will act on all other particles. Any number of particles can act as central bodies.
+ * Common exponents (gammacentral = -3, -2.5, -2, -1.5, 0 and 1) are evaluated without calls to pow.
+ * The list of sources is found once and cached until a particle's Acentral or gammacentral is set or removed. Their values are read at every evaluation,
+ * so they may also be changed by writing through the pointer returned by rebx_get_param (or a ParamHandle view in Python).
+ * With MPI, central bodies may live on any rank; their forces reach the particles on all ranks and the back-reactions are summed across ranks.
  *
  * **Effect Parameters**
  * 
@@ -59,8 +63,173 @@
 #include <float.h>
 #include "rebound.h"
 #include "reboundx.h"
+#include "rebxtools.h"
 
-static void rebx_calculate_central_force(struct reb_simulation* const sim, struct reb_particle* const particles, const int N, const double A, const double gamma, const int source_index){
+// Exponents with specialized kernels. Most uses have small integer or half-integer exponents, for which pow can be replaced by sqrt and multiplications.
+enum rebx_central_force_kernel{
+    REBX_CENTRAL_FORCE_GENERIC,
+    REBX_CENTRAL_FORCE_GAMMA_M3,
+    REBX_CENTRAL_FORCE_GAMMA_M2P5,
+    REBX_CENTRAL_FORCE_GAMMA_M2,
+    REBX_CENTRAL_FORCE_GAMMA_M1P5,
+    REBX_CENTRAL_FORCE_GAMMA_M1,
+    REBX_CENTRAL_FORCE_GAMMA_0,
+    REBX_CENTRAL_FORCE_GAMMA_1,
+};
+
+static enum rebx_central_force_kernel rebx_central_force_select_kernel(const double gamma){
+    if (gamma == -3.)   return REBX_CENTRAL_FORCE_GAMMA_M3;
+    if (gamma == -2.5)  return REBX_CENTRAL_FORCE_GAMMA_M2P5;
+    if (gamma == -2.)   return REBX_CENTRAL_FORCE_GAMMA_M2;
+    if (gamma == -1.5)  return REBX_CENTRAL_FORCE_GAMMA_M1P5;
+    if (gamma == -1.)   return REBX_CENTRAL_FORCE_GAMMA_M1;
+    if (gamma == 0.)    return REBX_CENTRAL_FORCE_GAMMA_0;
+    if (gamma == 1.)    return REBX_CENTRAL_FORCE_GAMMA_1;
+    return REBX_CENTRAL_FORCE_GENERIC;
+}
+
+// Returns r^(gamma-1), so that the acceleration vector is A*r^(gamma-1)*(dx,dy,dz)
+static inline double rebx_central_force_rpow(const enum rebx_central_force_kernel kernel, const double gamma, const double r2){
+    switch (kernel){
+        case REBX_CENTRAL_FORCE_GAMMA_M3:
+            return 1./(r2*r2);
+        case REBX_CENTRAL_FORCE_GAMMA_M2P5:
+        {
+            const double r = sqrt(r2);
+            return 1./(r2*r*sqrt(r));
+        }
+        case REBX_CENTRAL_FORCE_GAMMA_M2:
+            return 1./(r2*sqrt(r2));
+        case REBX_CENTRAL_FORCE_GAMMA_M1P5:
+            return 1./(r2*sqrt(sqrt(r2)));
+        case REBX_CENTRAL_FORCE_GAMMA_M1:   // pow is cheap here and keeps existing simulation archives with gammacentral=-1 reproducible bit by bit
+            return pow(r2, -1.);
+        case REBX_CENTRAL_FORCE_GAMMA_0:
+            return 1./sqrt(r2);
+        case REBX_CENTRAL_FORCE_GAMMA_1:
+            return 1.;
+        default:
+            return pow(r2, (gamma-1.)/2.);
+    }
+}
+
+// Returns the potential per unit mass and A, -r^(gamma+1)/(gamma+1) (or -log(r) for gamma=-1)
+static inline double rebx_central_force_phi(const enum rebx_central_force_kernel kernel, const double gamma, const double r2){
+    switch (kernel){
+        case REBX_CENTRAL_FORCE_GAMMA_M3:
+            return 0.5/r2;
+        case REBX_CENTRAL_FORCE_GAMMA_M2P5:
+        {
+            const double r = sqrt(r2);
+            return 1./(1.5*r*sqrt(r));
+        }
+        case REBX_CENTRAL_FORCE_GAMMA_M2:
+            return 1./sqrt(r2);
+        case REBX_CENTRAL_FORCE_GAMMA_M1P5:
+            return 2./sqrt(sqrt(r2));
+        case REBX_CENTRAL_FORCE_GAMMA_M1:
+            return -0.5*log(r2);
+        case REBX_CENTRAL_FORCE_GAMMA_0:
+            return -sqrt(r2);
+        case REBX_CENTRAL_FORCE_GAMMA_1:
+            return -0.5*r2;
+        default:
+            if (fabs(gamma+1.) < DBL_EPSILON){ // F propto 1/r
+                return -0.5*log(r2);
+            }
+            return -pow(r2, (gamma+1.)/2.)/(gamma+1.);
+    }
+}
+
+struct rebx_central_force_source{
+    int index;
+    const double* A;            // Point to the parameter values, so writes that bypass rebx_set_param_double (e.g. through a pointer from rebx_get_param) are seen
+    const double* gamma;
+};
+
+// Sources found in the last scan of the particles' parameters. Observers on Acentral and gammacentral flag the table as stale whenever either is set
+// or removed on any particle, which may move or free the values pointed to. Particles being added, removed or reordered changes N or the heads of
+// their parameter lists, which are also compared.
+struct rebx_central_force_table{
+    int N;
+    struct rebx_node** aps;
+    int stale;                                  // Set to 1 by the observers
+    struct rebx_param_observer* observers[2];
+    int N_sources;
+    struct rebx_central_force_source* sources;
+};
+
+static void rebx_central_force_free_arrays(struct rebx_extras* const rebx, struct rebx_force* const force){
+    struct rebx_central_force_table* const table = rebx_get_param(rebx, force->ap, "cf_sources");
+    if (table){
+        for (int k=0; k<2; k++){
+            if (table->observers[k]){
+                rebx_remove_param_observer(rebx, table->observers[k]);
+            }
+        }
+        free(table->aps);
+        free(table->sources);
+        free(table);
+    }
+}
+
+static struct rebx_central_force_table* rebx_central_force_get_sources(struct reb_simulation* const sim, struct rebx_force* const force, const struct reb_particle* const particles, const int N){
+    struct rebx_extras* const rebx = sim->extras;
+    struct rebx_central_force_table* table = rebx_get_param(rebx, force->ap, "cf_sources");
+    if (table == NULL){
+        table = calloc(1, sizeof(*table));
+        if (table == NULL){
+            rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for central_force sources.\n");
+            return NULL;
+        }
+        rebx_set_param_pointer(rebx, &force->ap, "cf_sources", table);
+        rebx_set_param_pointer(rebx, &force->ap, "free_arrays", rebx_central_force_free_arrays);
+        table->observers[0] = rebx_add_param_observer(rebx, "Acentral", NULL, NULL, &table->stale);
+        table->observers[1] = rebx_add_param_observer(rebx, "gammacentral", NULL, NULL, &table->stale);
+        table->N = -1;
+    }
+
+    int valid = (!table->stale && table->N == N);
+    for (int i=0; valid && i<N; i++){
+        valid = (particles[i].ap == table->aps[i]);
+    }
+    if (valid){
+        return table;
+    }
+
+    if (table->N != N){
+        struct rebx_node** const aps = realloc(table->aps, N*sizeof(*aps));
+        if (aps != NULL){
+            table->aps = aps;
+        }
+        struct rebx_central_force_source* const sources = realloc(table->sources, N*sizeof(*sources));
+        if (sources != NULL){
+            table->sources = sources;
+        }
+        if (N > 0 && (aps == NULL || sources == NULL)){
+            rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for central_force sources.\n");
+            table->N = -1;
+            return NULL;
+        }
+        table->N = N;
+    }
+    table->stale = 0;
+    table->N_sources = 0;
+    for (int i=0; i<N; i++){
+        table->aps[i] = particles[i].ap;
+        const double* const Acentral = rebx_get_param(rebx, particles[i].ap, "Acentral");
+        const double* const gammacentral = rebx_get_param(rebx, particles[i].ap, "gammacentral");
+        if (Acentral != NULL && gammacentral != NULL){ // only calculates force if a particle has both Acentral and gammacentral parameters set.
+            struct rebx_central_force_source* const source = &table->sources[table->N_sources++];
+            source->index = i;
+            source->A = Acentral;
+            source->gamma = gammacentral;
+        }
+    }
+    return table;
+}
+
+static void rebx_calculate_central_force(struct reb_particle* const particles, const int N, const double A, const double gamma, const enum rebx_central_force_kernel kernel, const int source_index){
     const struct reb_particle source = particles[source_index];
     for (int i=0; i<N; i++){
         if(i == source_index){
@@ -71,7 +240,7 @@ static void rebx_calculate_central_force(struct reb_simulation* const sim, struc
         const double dy = p.y - source.y;
         const double dz = p.z - source.z;
         const double r2 = dx*dx + dy*dy + dz*dz;
-        const double prefac = A*pow(r2, (gamma-1.)/2.);
+        const double prefac = A*rebx_central_force_rpow(kernel, gamma, r2);
 
         particles[i].ax += prefac*dx;
         particles[i].ay += prefac*dy;
@@ -82,22 +251,117 @@ static void rebx_calculate_central_force(struct reb_simulation* const sim, struc
     }
 }
 
-void rebx_central_force(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N){
-    for (int i=0; i<N; i++){
-        const double* const Acentral = rebx_get_param(sim->extras, particles[i].ap, "Acentral");
-        if (Acentral != NULL){
-            const double* const gammacentral = rebx_get_param(sim->extras, particles[i].ap, "gammacentral");
-            if (gammacentral != NULL){
-                rebx_calculate_central_force(sim, particles, N, *Acentral, *gammacentral, i); // only calculates force if a particle has both Acentral and gammacentral parameters set.
+// Test particles feel the sources without back-reactions
+static void rebx_calculate_central_force_testparticles(struct reb_particle* const particles, const int N_active, const int N, const double A, const double gamma, const enum rebx_central_force_kernel kernel, const int source_index){
+    const struct reb_particle source = particles[source_index];
+    for (int i=N_active; i<N; i++){
+        const double dx = particles[i].x - source.x;
+        const double dy = particles[i].y - source.y;
+        const double dz = particles[i].z - source.z;
+        const double r2 = dx*dx + dy*dy + dz*dz;
+        const double prefac = A*rebx_central_force_rpow(kernel, gamma, r2);
+
+        particles[i].ax += prefac*dx;
+        particles[i].ay += prefac*dy;
+        particles[i].az += prefac*dz;
+    }
+}
+
+#ifdef MPI
+// Sources can be on any rank. Every rank gathers the sources' states and parameters and adds their forces on its own particles.
+// The back-reactions on each source are then summed over ranks and added by the rank that holds the source.
+static void rebx_central_force_mpi(struct reb_simulation* const sim, struct rebx_central_force_table* const table, struct reb_particle* const particles, const int N){
+    const int n = 7; // x, y, z, m, A, gamma, rank
+    double* const local = malloc((n*table->N_sources + 1)*sizeof(*local));
+    for (int j=0; j<table->N_sources; j++){
+        const struct rebx_central_force_source* const source = &table->sources[j];
+        const struct reb_particle p = particles[source->index];
+        double* const s = &local[n*j];
+        s[0] = p.x; s[1] = p.y; s[2] = p.z; s[3] = p.m;
+        s[4] = *source->A; s[5] = *source->gamma; s[6] = sim->mpi_id;
+    }
+    int n_total;
+    double* const all = rebx_mpi_allgather(sim, local, n*table->N_sources, &n_total);
+    const int N_sources = n_total/n;
+    double* const back = calloc(3*N_sources + 1, sizeof(*back));
+
+    int j = 0; // sources gathered from this rank are in the same order as in table
+    for (int k=0; k<N_sources; k++){
+        const double* const s = &all[n*k];
+        const int source_index = ((int)s[6] == sim->mpi_id) ? table->sources[j++].index : -1;
+        const double A = s[4];
+        const double gamma = s[5];
+        const enum rebx_central_force_kernel kernel = rebx_central_force_select_kernel(gamma);
+        for (int i=0; i<N; i++){
+            if (i == source_index){
+                continue;
             }
+            const double dx = particles[i].x - s[0];
+            const double dy = particles[i].y - s[1];
+            const double dz = particles[i].z - s[2];
+            const double r2 = dx*dx + dy*dy + dz*dz;
+            const double prefac = A*rebx_central_force_rpow(kernel, gamma, r2);
+
+            particles[i].ax += prefac*dx;
+            particles[i].ay += prefac*dy;
+            particles[i].az += prefac*dz;
+            back[3*k] -= particles[i].m/s[3]*prefac*dx;
+            back[3*k+1] -= particles[i].m/s[3]*prefac*dy;
+            back[3*k+2] -= particles[i].m/s[3]*prefac*dz;
         }
     }
+
+    rebx_mpi_sum(back, 3*N_sources);
+    j = 0;
+    for (int k=0; k<N_sources; k++){
+        if ((int)all[n*k+6] == sim->mpi_id){
+            struct reb_particle* const source = &particles[table->sources[j++].index];
+            source->ax += back[3*k];
+            source->ay += back[3*k+1];
+            source->az += back[3*k+2];
+        }
+    }
+    free(back);
+    free(all);
+    free(local);
+}
+#endif // MPI
+
+void rebx_central_force(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N){
+    struct rebx_central_force_table* const table = rebx_central_force_get_sources(sim, force, particles, N);
+    if (table == NULL){
+        return;
+    }
+#ifdef MPI
+    if (sim->mpi_num > 1){
+        rebx_central_force_mpi(sim, table, particles, N);
+        return;
+    }
+#endif // MPI
+    for (int j=0; j<table->N_sources; j++){
+        const struct rebx_central_force_source* const source = &table->sources[j];
+        const double gamma = *source->gamma;
+        rebx_calculate_central_force(particles, N, *source->A, gamma, rebx_central_force_select_kernel(gamma), source->index);
+    }
+}
+
+void rebx_central_force_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N_active, const int N){
+    struct rebx_central_force_table* const table = rebx_central_force_get_sources(sim, force, particles, N_active); // only active particles can be sources
+    if (table == NULL){
+        return;
+    }
+    for (int j=0; j<table->N_sources; j++){
+        const struct rebx_central_force_source* const source = &table->sources[j];
+        const double gamma = *source->gamma;
+        rebx_calculate_central_force_testparticles(particles, N_active, N, *source->A, gamma, rebx_central_force_select_kernel(gamma), source->index);
+    }
 }
 
 static double rebx_calculate_central_force_potential(struct reb_simulation* const sim, const double A, const double gamma, const int source_index){
     const struct reb_particle* const particles = sim->particles;
 	const int _N_real = sim->N - sim->N_var;
     const struct reb_particle source = particles[source_index];
+    const enum rebx_central_force_kernel kernel = rebx_central_force_select_kernel(gamma);
     double H = 0.;
 	for (int i=0;i<_N_real;i++){
 		if(i == source_index){
@@ -108,13 +372,7 @@ static double rebx_calculate_central_force_potential(struct reb_simulation* cons
         const double dy = p.y - source.y;
         const double dz = p.z - source.z;
         const double r2 = dx*dx + dy*dy + dz*dz;
-
-        if (fabs(gamma+1.) < DBL_EPSILON){ // F propto 1/r
-            H -= p.m*A*log(sqrt(r2));
-        }
-        else{
-            H -= p.m*A*pow(r2, (gamma+1.)/2.)/(gamma+1.);
-        }
+        H += p.m*A*rebx_central_force_phi(kernel, gamma, r2);
     }		
     return H;
 }
@@ -0,0 +1,324 @@
+/**
+ * @file    collisional_damping.c
+ * @brief   Statistical collisional damping and grinding of debris swarms
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * The section after the dollar signs gets built into the documentation by a script.  All lines must start with space * space like below.
+ * Tables always must be preceded and followed by a blank line.  See http://docutils.sourceforge.net/docs/user/rst/quickstart.html for a primer on rst.
+ * $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
+ *
+ * $Debris Collisions$       // Effect category (must be the first non-blank line after dollar signs and between dollar signs to be detected by script).
+ *
+ * ======================= ===============================================
+ * Authors                 D. Tamayo
+ * Implementation Paper    None
+ * Based on                `Levison et al. 2012 <https://ui.adsabs.harvard.edu/abs/2012AJ....144..119L/abstract>`_.
+ * C Example               None
+ * Python Example          None
+ * ======================= ===============================================
+ *
+ * Damps the random velocities of debris and grinds down its mass at the rates set by the local collision frequency, without detecting collisions between particles.
+ * Each particle with cd_m and cd_s set is a tracer for a swarm of total mass cd_m made of bodies of radius cd_s and internal density cd_rho_s.
+ * Every cd_every operator steps, tracers are binned into cd_Nr logarithmically spaced annuli between cd_rmin and cd_rmax in cylindrical radius from the primary (particles[0]),
+ * each split into cd_Nphi azimuthal sectors. For each cell, this computes the (swarm mass weighted) dispersion of the velocities relative to the cell's mean, in cylindrical components
+ * with the local circular velocity subtracted from the azimuthal one, and the cell's vertical thickness, from which it gets the number density of bodies.
+ * Each tracer then collides at the rate Gamma = sum over bodies in its cell of n*pi*(s + s')^2*v_rel, with v_rel the rms relative velocity, so the cost is O(N) rather than O(N^2).
+ *
+ * By default, each tracer's velocity relative to its cell's mean is damped by exp(-(1 - cd_eps^2)*Gamma*dt/2), so that the dispersion loses the fraction (1 - cd_eps^2) of its energy per collision.
+ * If cd_stochastic is set to 1, each tracer instead collides with probability 1 - exp(-Gamma*dt), after which its relative speed is reduced by cd_eps and its direction randomized (using the simulation's random seed).
+ * In both cases, each tracer's swarm mass cd_m is multiplied by exp(-cd_loss*Gamma*dt), i.e., each collision removes the fraction cd_loss of the colliding mass (e.g., as dust blown out by radiation).
+ * The tracers' masses in the simulation (which can be zero) are not changed, and momentum is only conserved within a cell on average.
+ * Tracers outside the grid, and cells without vertical extent or random velocities, are left alone.
+ *
+ * **Effect Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * cd_rho_s (double)            Yes         Internal density of the bodies in the swarms
+ * cd_rmin (double)             Yes         Inner radius of the grid
+ * cd_rmax (double)             Yes         Outer radius of the grid
+ * cd_Nr (int)                  No          Number of annuli. Defaults to 16
+ * cd_Nphi (int)                No          Number of azimuthal sectors per annulus. Defaults to 1. cd_Nr*cd_Nphi can be at most 16777216
+ * cd_every (int)               No          Number of operator steps between applications. Defaults to 1
+ * cd_eps (double)              No          Coefficient of restitution. Defaults to 0
+ * cd_loss (double)             No          Fraction of the colliding mass removed per collision. Defaults to 0
+ * cd_stochastic (int)          No          If 1, applies collisions stochastically rather than as a mean field. Defaults to 0
+ * ============================ =========== ==================================================================
+ *
+ * **Particle Parameters**
+ *
+ * Only particles with both parameters set are tracers.
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * cd_m (double)                Yes         Total mass of the swarm the particle represents
+ * cd_s (double)                Yes         Radius of the bodies in the swarm
+ * ============================ =========== ==================================================================
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+
+#define REBX_CD_MAX_CELLS (1<<24)   // bound on cd_Nr*cd_Nphi, so the cell table stays addressable with int and of reasonable size
+
+struct rebx_cd_state{
+    int N_calls;                // operator steps since the last application
+    double dt;                  // time elapsed since the last application
+};
+
+struct rebx_cd_tracer{
+    int index;                  // in sim->particles
+    int cell;
+    double* m;                  // swarm mass (the particle's cd_m)
+    double s;
+    double n;                   // number of bodies
+    double z;
+    double u[3];                // velocity in cylindrical components (R, phi - circular, z)
+};
+
+struct rebx_cd_cell{
+    double W;                   // sums over tracers weighted by swarm mass (Wz and Wu are divided by W to give means after binning)
+    double Wz;
+    double Wu[3];
+    double Wdz2;
+    double Wdu2[3];
+    double n[3];                // sums over bodies of s^0, s^1, s^2
+    double rate;                // Gamma/(s^2*n[0] + 2*s*n[1] + n[2]) for a tracer with body radius s
+};
+
+static void rebx_cd_free_arrays(struct rebx_extras* rebx, struct rebx_operator* operator){
+    struct rebx_cd_state* state = rebx_get_param(rebx, operator->ap, "cd_state");
+    free(state);
+}
+
+static struct rebx_cd_state* rebx_cd_get_state(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_cd_state* state = rebx_get_param(rebx, operator->ap, "cd_state");
+    if (state == NULL){
+        state = calloc(1, sizeof(*state));
+        if (state == NULL){
+            rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for collisional_damping.\n");
+            return NULL;
+        }
+        rebx_set_param_pointer(rebx, &operator->ap, "cd_state", state);
+        rebx_set_param_pointer(rebx, &operator->ap, "free_arrays", rebx_cd_free_arrays);
+    }
+    return state;
+}
+
+static void rebx_cd_apply(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt, const double rho_s, const double rmin, const double rmax, const int Nr, const int Nphi){
+    struct rebx_extras* const rebx = sim->extras;
+    struct reb_particle* const particles = sim->particles;
+    const int N_real = sim->N - sim->N_var;
+    if (N_real < 2){
+        return;
+    }
+    const double* const eps_ptr = rebx_get_param(rebx, operator->ap, "cd_eps");
+    const double* const loss_ptr = rebx_get_param(rebx, operator->ap, "cd_loss");
+    const int* const stochastic_ptr = rebx_get_param(rebx, operator->ap, "cd_stochastic");
+    const double eps = (eps_ptr == NULL) ? 0. : *eps_ptr;
+    const double loss = (loss_ptr == NULL) ? 0. : *loss_ptr;
+    const int stochastic = (stochastic_ptr == NULL) ? 0 : *stochastic_ptr;
+
+    const struct reb_particle primary = particles[0];
+    const double GM = sim->G*primary.m;
+    const double dlogr = log(rmax/rmin)/Nr;
+    const double body_volume = 4./3.*M_PI*rho_s;     // body mass is body_volume*s^3
+    struct rebx_cd_tracer* const tracers = malloc((N_real-1)*sizeof(*tracers));
+    struct rebx_cd_cell* const cells = calloc((size_t)Nr*Nphi, sizeof(*cells));
+    if (tracers == NULL || cells == NULL){
+        reb_simulation_error(sim, "REBOUNDx Error: Could not allocate memory for collisional_damping.\n");
+        free(tracers);
+        free(cells);
+        return;
+    }
+
+    // Bin tracers and accumulate each cell's mean velocity and height
+    int N_tracers = 0;
+    for (int i=1; i<N_real; i++){
+        double* const m = rebx_get_param(rebx, particles[i].ap, "cd_m");
+        const double* const s = rebx_get_param(rebx, particles[i].ap, "cd_s");
+        if (m == NULL || s == NULL || *m <= 0.){
+            continue;
+        }
+        const double x = particles[i].x - primary.x;
+        const double y = particles[i].y - primary.y;
+        const double R = sqrt(x*x + y*y);
+        if (!(R >= rmin && R < rmax)){
+            continue;
+        }
+        const int ir = (int)(log(R/rmin)/dlogr);
+        int iphi = (int)((atan2(y, x) + M_PI)/(2.*M_PI)*Nphi);
+        iphi = (iphi >= Nphi) ? Nphi - 1 : iphi;
+        const double vx = particles[i].vx - primary.vx;
+        const double vy = particles[i].vy - primary.vy;
+        struct rebx_cd_tracer* const t = &tracers[N_tracers++];
+        t->index = i;
+        t->cell = (ir < Nr ? ir : Nr - 1)*Nphi + iphi;
+        t->m = m;
+        t->s = *s;
+        t->n = *m/(body_volume*(*s)*(*s)*(*s));
+        t->z = particles[i].z - primary.z;
+        t->u[0] = (x*vx + y*vy)/R;
+        t->u[1] = (x*vy - y*vx)/R - sqrt(GM/R);
+        t->u[2] = particles[i].vz - primary.vz;
+        struct rebx_cd_cell* const c = &cells[t->cell];
+        c->W += *m;
+        c->Wz += *m*t->z;
+        for (int k=0; k<3; k++){
+            c->Wu[k] += *m*t->u[k];
+        }
+        c->n[0] += t->n;
+        c->n[1] += t->n*t->s;
+        c->n[2] += t->n*t->s*t->s;
+    }
+    for (int c=0; c<Nr*Nphi; c++){
+        if (cells[c].W > 0.){
+            cells[c].Wz /= cells[c].W;
+            for (int k=0; k<3; k++){
+                cells[c].Wu[k] /= cells[c].W;
+            }
+        }
+    }
+
+    // Dispersions about the cell means (second pass, to avoid cancellation)
+    for (int j=0; j<N_tracers; j++){
+        struct rebx_cd_tracer* const t = &tracers[j];
+        struct rebx_cd_cell* const c = &cells[t->cell];
+        const double dz = t->z - c->Wz;
+        c->Wdz2 += *t->m*dz*dz;
+        for (int k=0; k<3; k++){
+            t->u[k] -= c->Wu[k];
+            c->Wdu2[k] += *t->m*t->u[k]*t->u[k];
+        }
+    }
+
+    // Number density from the cell's area and thickness (the larger of the rms height and the vertical velocity dispersion over Omega),
+    // averaged over a Gaussian vertical profile, n = N/(2 sqrt(pi) H A)
+    for (int ir=0; ir<Nr; ir++){
+        const double r0 = rmin*exp(ir*dlogr);
+        const double r1 = rmin*exp((ir+1)*dlogr);
+        const double area = M_PI*(r1*r1 - r0*r0)/Nphi;
+        const double Rc = 0.5*(r0 + r1);
+        const double Omega2 = GM/(Rc*Rc*Rc);
+        for (int iphi=0; iphi<Nphi; iphi++){
+            struct rebx_cd_cell* const c = &cells[ir*Nphi + iphi];
+            if (c->W == 0.){
+                continue;
+            }
+            const double sigma2 = (c->Wdu2[0] + c->Wdu2[1] + c->Wdu2[2])/c->W;
+            const double H2 = fmax(c->Wdz2/c->W, c->Wdu2[2]/c->W/Omega2);
+            if (sigma2 == 0. || H2 == 0.){
+                continue;
+            }
+            const double vrel = sqrt(2.*sigma2);
+            c->rate = M_PI*vrel/(2.*sqrt(M_PI*H2)*area);
+        }
+    }
+
+    // Damp and grind each tracer at its collision rate
+    for (int j=0; j<N_tracers; j++){
+        const struct rebx_cd_tracer* const t = &tracers[j];
+        const struct rebx_cd_cell* const c = &cells[t->cell];
+        if (c->rate == 0.){
+            continue;
+        }
+        const double Gamma_dt = c->rate*(t->s*t->s*c->n[0] + 2.*t->s*c->n[1] + c->n[2])*dt;
+        double du[3];
+        if (stochastic){
+            if (reb_random_uniform(sim, 0., 1.) >= -expm1(-Gamma_dt)){
+                du[0] = du[1] = du[2] = 0.;
+            }
+            else{
+                // relative speed reduced by eps, with isotropic direction
+                const double u = sqrt(t->u[0]*t->u[0] + t->u[1]*t->u[1] + t->u[2]*t->u[2]);
+                const double cos_theta = reb_random_uniform(sim, -1., 1.);
+                const double sin_theta = sqrt(1. - cos_theta*cos_theta);
+                const double phi = reb_random_uniform(sim, 0., 2.*M_PI);
+                du[0] = eps*u*sin_theta*cos(phi) - t->u[0];
+                du[1] = eps*u*sin_theta*sin(phi) - t->u[1];
+                du[2] = eps*u*cos_theta - t->u[2];
+            }
+        }
+        else{
+            const double f = expm1(-0.5*(1. - eps*eps)*Gamma_dt);
+            for (int k=0; k<3; k++){
+                du[k] = f*t->u[k];
+            }
+        }
+        if (loss > 0.){
+            *t->m *= exp(-loss*Gamma_dt);
+        }
+        struct reb_particle* const p = &particles[t->index];
+        const double x = p->x - primary.x;
+        const double y = p->y - primary.y;
+        const double R = sqrt(x*x + y*y);
+        p->vx += (x*du[0] - y*du[1])/R;
+        p->vy += (y*du[0] + x*du[1])/R;
+        p->vz += du[2];
+    }
+    free(tracers);
+    free(cells);
+}
+
+void rebx_collisional_damping(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
+    struct rebx_extras* const rebx = sim->extras;
+    const double* const rho_s = rebx_get_param(rebx, operator->ap, "cd_rho_s");
+    const double* const rmin = rebx_get_param(rebx, operator->ap, "cd_rmin");
+    const double* const rmax = rebx_get_param(rebx, operator->ap, "cd_rmax");
+    if (rho_s == NULL || rmin == NULL || rmax == NULL){
+        reb_simulation_error(sim, "REBOUNDx Error: Need to set cd_rho_s, cd_rmin and cd_rmax for collisional_damping.\n");
+        return;
+    }
+    if (*rmin <= 0. || *rmax <= *rmin){
+        reb_simulation_error(sim, "REBOUNDx Error: collisional_damping needs 0 < cd_rmin < cd_rmax.\n");
+        return;
+    }
+    if (dt < 0.){
+        return;
+    }
+    const int* const Nr = rebx_get_param(rebx, operator->ap, "cd_Nr");
+    const int* const Nphi = rebx_get_param(rebx, operator->ap, "cd_Nphi");
+    const int* const every = rebx_get_param(rebx, operator->ap, "cd_every");
+    const int N_r = (Nr == NULL || *Nr < 1) ? 16 : *Nr;
+    const int N_phi = (Nphi == NULL || *Nphi < 1) ? 1 : *Nphi;
+    if ((long long)N_r*N_phi > REBX_CD_MAX_CELLS){
+        reb_simulation_error(sim, "REBOUNDx Error: collisional_damping needs cd_Nr*cd_Nphi of at most 16777216.\n");
+        return;
+    }
+    struct rebx_cd_state* const state = rebx_cd_get_state(rebx, operator);
+    if (state == NULL){
+        return;
+    }
+    state->N_calls++;
+    state->dt += dt;
+    if (every != NULL && state->N_calls < *every){
+        return;
+    }
+    rebx_cd_apply(sim, operator, state->dt, *rho_s, *rmin, *rmax, N_r, N_phi);
+    state->N_calls = 0;
+    state->dt = 0.;
+}
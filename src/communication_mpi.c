@@ -0,0 +1,366 @@
+/**
+ * @file    communication_mpi.c
+ * @brief   MPI helpers for REBOUNDx effects in domain-decomposed REBOUND simulations
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Only compiled in when REBOUND is built with MPI (which defines MPI through REBOUND's Makefile.defs).
+ * In that case each rank only holds the particles in its root boxes in sim->particles, and REBOUND moves particles between ranks
+ * as they cross domain boundaries by copying the particle structs. The particle's ap pointer is then meaningless on the new rank,
+ * so REBOUNDx keeps track of which particles with parameters each rank holds, and sends the parameters of particles that left a rank
+ * to the rank they arrived on (matching by hash, so particles with parameters need unique hashes).
+ */
+
+#ifdef MPI
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "rebound.h"
+#include "reboundx.h"
+#include "core.h"
+#include "rebxtools.h"
+
+struct rebx_mpi_ap{
+    uint32_t hash;
+    struct rebx_node* ap;
+};
+
+// Particles with parameters held by this rank the last time parameters were synchronized, sorted by hash,
+// and parameter lists of particles removed from this rank since then (by REBOUND's particle communication or the user).
+struct rebx_mpi_params{
+    int N;
+    int N_allocated;
+    struct rebx_mpi_ap* aps;
+    int N_stash;
+    int N_stash_allocated;
+    struct rebx_mpi_ap* stash;
+    int warned;
+    int pending;                // 1 if REBOUND may have moved particles between ranks since the last migration
+};
+
+// Number of doubles per parameter in a serialized particle: registered parameter index, type and up to 3 values
+#define REBX_MPI_PARAM_SIZE 5
+
+// Every rank has to take part in each collective, so a rank that can't allocate its buffers can't just report an error and return:
+// the others would wait for it forever (or go on with parameters out of step). Allocation failures here abort all ranks instead.
+static void* rebx_mpi_realloc(void* const ptr, const size_t size){
+    void* const new_ptr = realloc(ptr, size);
+    if (new_ptr == NULL && size > 0){
+        fprintf(stderr, "REBOUNDx Error: Could not allocate memory for MPI communication. Aborting all ranks.\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    return new_ptr;
+}
+
+static void* rebx_mpi_malloc(const size_t size){
+    return rebx_mpi_realloc(NULL, size);
+}
+
+/****************************************
+Collectives used by effects
+****************************************/
+
+double* rebx_mpi_allgather(struct reb_simulation* const sim, const double* const local, const int n_local, int* const n_total){
+    const int mpi_num = sim->mpi_num;
+    int* const counts = rebx_mpi_malloc(mpi_num*sizeof(*counts));
+    int* const displs = rebx_mpi_malloc(mpi_num*sizeof(*displs));
+    MPI_Allgather((void*)&n_local, 1, MPI_INT, counts, 1, MPI_INT, MPI_COMM_WORLD);
+    int n = 0;
+    for (int i=0; i<mpi_num; i++){
+        displs[i] = n;
+        n += counts[i];
+    }
+    double* const all = rebx_mpi_malloc((n > 0 ? n : 1)*sizeof(*all));
+    MPI_Allgatherv((void*)local, n_local, MPI_DOUBLE, all, counts, displs, MPI_DOUBLE, MPI_COMM_WORLD);
+    free(counts);
+    free(displs);
+    *n_total = n;
+    return all;
+}
+
+void rebx_mpi_sum(double* const buf, const int n){
+    if (n > 0){
+        MPI_Allreduce(MPI_IN_PLACE, buf, n, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    }
+}
+
+int rebx_mpi_primary(struct reb_simulation* const sim, const struct reb_particle* const particles, const int N, struct reb_particle* const primary){
+    struct {
+        double m;
+        int rank;
+    } local = {-1., sim->mpi_id}, global;
+    int index = -1;
+    for (int i=0; i<N; i++){
+        if (particles[i].m > local.m){
+            local.m = particles[i].m;
+            index = i;
+        }
+    }
+    MPI_Allreduce(&local, &global, 1, MPI_DOUBLE_INT, MPI_MAXLOC, MPI_COMM_WORLD); // ties go to the lowest rank
+
+    double state[7] = {0.};
+    if (global.rank == sim->mpi_id){
+        const struct reb_particle p = particles[index];
+        state[0] = p.x; state[1] = p.y; state[2] = p.z;
+        state[3] = p.vx; state[4] = p.vy; state[5] = p.vz;
+        state[6] = p.m;
+    }
+    MPI_Bcast(state, 7, MPI_DOUBLE, global.rank, MPI_COMM_WORLD);
+    struct reb_particle p = {0};
+    p.x = state[0]; p.y = state[1]; p.z = state[2];
+    p.vx = state[3]; p.vy = state[4]; p.vz = state[5];
+    p.m = state[6];
+    *primary = p;
+    return (global.rank == sim->mpi_id) ? index : -1;
+}
+
+/****************************************
+Keeping particle parameters with their particles
+****************************************/
+
+static int rebx_mpi_compare_aps(const void* a, const void* b){
+    const uint32_t ha = ((const struct rebx_mpi_ap*)a)->hash;
+    const uint32_t hb = ((const struct rebx_mpi_ap*)b)->hash;
+    return (ha > hb) - (ha < hb);
+}
+
+static struct rebx_mpi_ap* rebx_mpi_find(struct rebx_mpi_ap* const aps, const int N, const uint32_t hash){
+    const struct rebx_mpi_ap key = {.hash = hash};
+    return bsearch(&key, aps, N, sizeof(*aps), rebx_mpi_compare_aps);
+}
+
+static struct rebx_mpi_params* rebx_mpi_get_params(struct rebx_extras* const rebx){
+    if (rebx->mpi_params == NULL){
+        rebx->mpi_params = rebx_mpi_malloc(sizeof(*rebx->mpi_params));
+        *rebx->mpi_params = (struct rebx_mpi_params){0};
+        rebx->mpi_params->pending = 1; // nothing recorded yet
+    }
+    return rebx->mpi_params;
+}
+
+void rebx_mpi_stash_particle_ap(struct rebx_extras* const rebx, struct reb_particle* const p){
+    struct rebx_mpi_params* const mp = rebx_mpi_get_params(rebx);
+    if (mp->N_stash == mp->N_stash_allocated){
+        mp->N_stash_allocated = mp->N_stash_allocated ? 2*mp->N_stash_allocated : 16;
+        mp->stash = rebx_mpi_realloc(mp->stash, mp->N_stash_allocated*sizeof(*mp->stash));
+    }
+    mp->stash[mp->N_stash].hash = p->hash;
+    mp->stash[mp->N_stash].ap = p->ap;
+    mp->N_stash++;
+    p->ap = NULL;
+}
+
+// Registered parameters are the same on all ranks, so parameters are sent by their position in the registered list
+static int rebx_mpi_param_index(struct rebx_extras* const rebx, const char* const name){
+    int index = 0;
+    for (struct rebx_node* current = rebx->registered_params; current != NULL; current = current->next, index++){
+        const struct rebx_param* const param = current->object;
+        if (strcmp(param->name, name) == 0){
+            return index;
+        }
+    }
+    return -1;
+}
+
+static const char* rebx_mpi_param_name(struct rebx_extras* const rebx, const int index){
+    struct rebx_node* current = rebx->registered_params;
+    for (int i=0; current != NULL && i<index; i++){
+        current = current->next;
+    }
+    return current ? ((const struct rebx_param*)current->object)->name : NULL;
+}
+
+// Appends hash, number of parameters and the parameters of a particle to buf (resizing as needed). Returns new size of buf.
+static int rebx_mpi_pack(struct rebx_extras* const rebx, const uint32_t hash, struct rebx_node* const ap, double** const buf, int n, int* const n_allocated){
+    int N_params = 0;
+    for (struct rebx_node* current = ap; current != NULL; current = current->next){
+        N_params++;
+    }
+    if (n + 2 + REBX_MPI_PARAM_SIZE*N_params > *n_allocated){
+        *n_allocated = 2*(n + 2 + REBX_MPI_PARAM_SIZE*N_params);
+        *buf = rebx_mpi_realloc(*buf, (*n_allocated)*sizeof(**buf));
+    }
+    double* const b = *buf;
+    b[n] = hash;
+    const int n_count = n+1;
+    n += 2;
+    int N_packed = 0;
+    for (struct rebx_node* current = ap; current != NULL; current = current->next){
+        const struct rebx_param* const param = current->object;
+        double v[3] = {0.};
+        switch (param->type){
+            case REBX_TYPE_DOUBLE:
+                v[0] = *(double*)param->value;
+                break;
+            case REBX_TYPE_INT:
+                v[0] = *(int*)param->value;
+                break;
+            case REBX_TYPE_UINT32:
+                v[0] = *(uint32_t*)param->value;
+                break;
+            case REBX_TYPE_VEC3D:
+            {
+                const struct reb_vec3d vec = *(struct reb_vec3d*)param->value;
+                v[0] = vec.x; v[1] = vec.y; v[2] = vec.z;
+                break;
+            }
+            default:
+                if (!rebx->mpi_params->warned){
+                    reb_simulation_warning(rebx->sim, "REBOUNDx: Only double, int, uint32 and vec3d particle parameters are kept when particles move between MPI ranks.");
+                    rebx->mpi_params->warned = 1;
+                }
+                continue;
+        }
+        b[n] = rebx_mpi_param_index(rebx, param->name);
+        b[n+1] = param->type;
+        b[n+2] = v[0]; b[n+3] = v[1]; b[n+4] = v[2];
+        n += REBX_MPI_PARAM_SIZE;
+        N_packed++;
+    }
+    b[n_count] = N_packed;
+    return n;
+}
+
+static void rebx_mpi_unpack(struct rebx_extras* const rebx, struct reb_particle* const p, const double* const b){
+    const int N_params = b[1];
+    for (int j=N_params-1; j>=0; j--){ // parameters are prepended, so add in reverse to keep the original order
+        const double* const v = &b[2+REBX_MPI_PARAM_SIZE*j];
+        const char* const name = rebx_mpi_param_name(rebx, v[0]);
+        if (name == NULL){
+            continue;
+        }
+        switch ((enum rebx_param_type)v[1]){
+            case REBX_TYPE_DOUBLE:
+                rebx_set_param_double(rebx, (struct rebx_node**)&p->ap, name, v[2]);
+                break;
+            case REBX_TYPE_INT:
+                rebx_set_param_int(rebx, (struct rebx_node**)&p->ap, name, v[2]);
+                break;
+            case REBX_TYPE_UINT32:
+                rebx_set_param_uint32(rebx, (struct rebx_node**)&p->ap, name, v[2]);
+                break;
+            case REBX_TYPE_VEC3D:
+                rebx_set_param_vec3d(rebx, (struct rebx_node**)&p->ap, name, (struct reb_vec3d){.x=v[2], .y=v[3], .z=v[4]});
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void rebx_mpi_expect_redistribution(struct rebx_extras* const rebx){
+    rebx_mpi_get_params(rebx)->pending = 1;
+}
+
+// REBOUND only moves particles between ranks once per step, when it updates the tree after the first half of the step.
+// Every rank calls this from the same hooks in the same order, so they all agree on whether to run the collective.
+void rebx_mpi_migrate_params(struct rebx_extras* const rebx){
+    struct reb_simulation* const sim = rebx->sim;
+    struct rebx_mpi_params* const mp = rebx_mpi_get_params(rebx);
+    if (!mp->pending){
+        return;
+    }
+    mp->pending = 0;
+    struct reb_particle* const ps = sim->particles;
+    const int N = sim->N - sim->N_var;
+
+    // Local particles, sorted by hash
+    struct rebx_mpi_ap* const local = rebx_mpi_malloc((N > 0 ? N : 1)*sizeof(*local));
+    for (int i=0; i<N; i++){
+        local[i].hash = ps[i].hash;
+        local[i].ap = (struct rebx_node*)(intptr_t)i; // reuse the pointer slot for the particle's index
+    }
+    qsort(local, N, sizeof(*local), rebx_mpi_compare_aps);
+
+    // Pack parameters of particles that left this rank
+    double* departed = NULL;
+    int n_departed = 0;
+    int n_allocated = 0;
+    for (int i=0; i<mp->N_stash; i++){
+        struct rebx_mpi_ap* const recorded = rebx_mpi_find(mp->aps, mp->N, mp->stash[i].hash);
+        if (recorded){
+            recorded->ap = NULL;    // same list as the stashed one (which is more recent if parameters were added since)
+        }
+        if (mp->stash[i].ap != NULL){
+            n_departed = rebx_mpi_pack(rebx, mp->stash[i].hash, mp->stash[i].ap, &departed, n_departed, &n_allocated);
+            rebx_free_ap(&mp->stash[i].ap);
+        }
+    }
+    mp->N_stash = 0;
+    for (int i=0; i<mp->N; i++){
+        if (mp->aps[i].ap != NULL && rebx_mpi_find(local, N, mp->aps[i].hash) == NULL){
+            n_departed = rebx_mpi_pack(rebx, mp->aps[i].hash, mp->aps[i].ap, &departed, n_departed, &n_allocated);
+            rebx_free_ap(&mp->aps[i].ap);
+        }
+    }
+
+    int n_total = n_departed;
+    MPI_Allreduce(MPI_IN_PLACE, &n_total, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if (n_total > 0){
+        double* const all = rebx_mpi_allgather(sim, departed, n_departed, &n_total);
+        // Particles that arrived on this rank weren't here at the last synchronization. Their ap pointers came from another rank.
+        for (int k=0; k<n_total; k += 2 + REBX_MPI_PARAM_SIZE*(int)all[k+1]){
+            const uint32_t hash = all[k];
+            const struct rebx_mpi_ap* const found = rebx_mpi_find(local, N, hash);
+            if (found == NULL || (mp->N > 0 && rebx_mpi_find(mp->aps, mp->N, hash) != NULL)){
+                continue;
+            }
+            struct reb_particle* const p = &ps[(intptr_t)found->ap];
+            p->ap = NULL;
+            rebx_mpi_unpack(rebx, p, &all[k]);
+        }
+        free(all);
+    }
+    free(departed);
+
+    // Record particles with parameters currently on this rank
+    if (mp->N_allocated < N){
+        mp->N_allocated = N;
+        mp->aps = rebx_mpi_realloc(mp->aps, N*sizeof(*mp->aps));
+    }
+    mp->N = 0;
+    for (int i=0; i<N; i++){
+        if (ps[i].ap != NULL){
+            mp->aps[mp->N].hash = ps[i].hash;
+            mp->aps[mp->N].ap = ps[i].ap;
+            mp->N++;
+        }
+    }
+    qsort(mp->aps, mp->N, sizeof(*mp->aps), rebx_mpi_compare_aps);
+    free(local);
+}
+
+void rebx_mpi_free(struct rebx_extras* const rebx){
+    struct rebx_mpi_params* const mp = rebx->mpi_params;
+    if (mp == NULL){
+        return;
+    }
+    for (int i=0; i<mp->N_stash; i++){
+        rebx_free_ap(&mp->stash[i].ap);
+    }
+    free(mp->stash);
+    free(mp->aps);  // parameter lists of particles still in the simulation are freed with the particles
+    free(mp);
+    rebx->mpi_params = NULL;
+}
+
+#endif // MPI
@@ -34,6 +34,7 @@
 #include "core.h"
 #include "rebound.h"
 #include "linkedlist.h"
+#include "rebxtools.h"
 
 #define STRINGIFY(s) str(s)
 #define str(s) #s
@@ -101,6 +102,8 @@ void rebx_register_default_params(struct rebx_extras* rebx){
     rebx_register_param(rebx, "min_distance", REBX_TYPE_DOUBLE);
     rebx_register_param(rebx, "min_distance_from", REBX_TYPE_UINT32);
     rebx_register_param(rebx, "min_distance_orbit", REBX_TYPE_ORBIT);
+    rebx_register_param(rebx, "min_distance_dense_output", REBX_TYPE_INT);
+    rebx_register_param(rebx, "min_distance_dense", REBX_TYPE_POINTER);
     rebx_register_param(rebx, "luminosity", REBX_TYPE_DOUBLE);
     rebx_register_param(rebx, "ide_position", REBX_TYPE_DOUBLE);
     rebx_register_param(rebx, "ide_width", REBX_TYPE_DOUBLE);
@@ -121,7 +124,7 @@ void rebx_register_default_params(struct rebx_extras* rebx){
     rebx_register_param(rebx, "ye_spin_axis_x", REBX_TYPE_DOUBLE);
     rebx_register_param(rebx, "ye_spin_axis_y", REBX_TYPE_DOUBLE);
     rebx_register_param(rebx, "ye_spin_axis_z", REBX_TYPE_DOUBLE);
-    rebx_register_param(rebx, "OmegaMag", REBX_TYPE_VEC3D);
+    rebx_register_param(rebx, "OmegaMag", REBX_TYPE_DOUBLE);
     rebx_register_param(rebx, "Omega", REBX_TYPE_VEC3D);
     rebx_register_param(rebx, "k2", REBX_TYPE_DOUBLE);
     rebx_register_param(rebx, "I", REBX_TYPE_DOUBLE);
@@ -141,6 +144,56 @@ void rebx_register_default_params(struct rebx_extras* rebx){
     rebx_register_param(rebx, "lt_p_haty", REBX_TYPE_DOUBLE);
     rebx_register_param(rebx, "lt_p_hatz", REBX_TYPE_DOUBLE);
     rebx_register_param(rebx, "lt_c", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "te_radius", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "te_tables", REBX_TYPE_POINTER);
+    rebx_register_param(rebx, "te_group", REBX_TYPE_INT);
+    rebx_register_param(rebx, "rs_interval", REBX_TYPE_INT);
+    rebx_register_param(rebx, "rs_tables", REBX_TYPE_POINTER);
+    rebx_register_param(rebx, "ev_events", REBX_TYPE_INT);
+    rebx_register_param(rebx, "ev_state", REBX_TYPE_POINTER);
+    rebx_register_param(rebx, "ev_res_partner", REBX_TYPE_INT);
+    rebx_register_param(rebx, "ev_res_p", REBX_TYPE_INT);
+    rebx_register_param(rebx, "ev_res_q", REBX_TYPE_INT);
+    rebx_register_param(rebx, "rp_interval", REBX_TYPE_INT);
+    rebx_register_param(rebx, "rp_capacity", REBX_TYPE_INT);
+    rebx_register_param(rebx, "rp_buffer", REBX_TYPE_POINTER);
+    rebx_register_param(rebx, "cf_sources", REBX_TYPE_POINTER);
+    rebx_register_param(rebx, "ias15_group", REBX_TYPE_INT);
+    rebx_register_param(rebx, "opening_angle", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "gd_rhog", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "gd_alpha_rhog", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "gd_cs", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "gd_alpha_cs", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "gd_mfp", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "gd_s", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "gd_rho_s", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "dsg_sigma0", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "dsg_rin", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "dsg_rout", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "dsg_alpha", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "dsg_profile", REBX_TYPE_POINTER);
+    rebx_register_param(rebx, "dsg_softening", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "dsg_rmax", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "dsg_zmax", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "dsg_Nr", REBX_TYPE_INT);
+    rebx_register_param(rebx, "dsg_Nz", REBX_TYPE_INT);
+    rebx_register_param(rebx, "dsg_Nrings", REBX_TYPE_INT);
+    rebx_register_param(rebx, "dsg_refresh", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "dsg_table", REBX_TYPE_POINTER);
+    rebx_register_param(rebx, "flyby_tidal", REBX_TYPE_INT);
+    rebx_register_param(rebx, "flyby_state", REBX_TYPE_POINTER);
+    rebx_register_param(rebx, "cd_rho_s", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "cd_rmin", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "cd_rmax", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "cd_Nr", REBX_TYPE_INT);
+    rebx_register_param(rebx, "cd_Nphi", REBX_TYPE_INT);
+    rebx_register_param(rebx, "cd_every", REBX_TYPE_INT);
+    rebx_register_param(rebx, "cd_eps", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "cd_loss", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "cd_stochastic", REBX_TYPE_INT);
+    rebx_register_param(rebx, "cd_m", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "cd_s", REBX_TYPE_DOUBLE);
+    rebx_register_param(rebx, "cd_state", REBX_TYPE_POINTER);
 }
 
 void rebx_register_param(struct rebx_extras* const rebx, const char* name, enum rebx_param_type type){
@@ -194,6 +247,10 @@ void rebx_detach(struct reb_simulation* sim, struct rebx_extras* rebx){
         if (sim->additional_forces == rebx_additional_forces){
             sim->additional_forces = NULL;
         }
+        if (rebx->set_velocity_dependent){
+            sim->force_is_velocity_dependent = 0;
+            rebx->set_velocity_dependent = 0;
+        }
         if (sim->pre_timestep_modifications == rebx_pre_timestep_modifications){
             sim->pre_timestep_modifications = NULL;
         }
@@ -220,6 +277,15 @@ void rebx_initialize(struct reb_simulation* sim, struct rebx_extras* rebx){
     rebx->allocated_forces=NULL;
     rebx->allocated_operators=NULL;
     rebx->registered_params=NULL;
+    rebx->orbits=NULL;
+    rebx->orbits_N=0;
+    rebx->orbits_valid=0;
+    rebx->set_velocity_dependent=0;
+    rebx->jacobi=NULL;
+    rebx->force_evaluations=0;
+    rebx_diagnostics_reset(rebx);
+    rebx->param_observers=NULL;
+    rebx_tuning_set_defaults(&rebx->tuning);
 
     sim->free_particle_ap = rebx_free_particle_ap;
     sim->extras_cleanup = rebx_extras_cleanup;
@@ -227,6 +293,10 @@ void rebx_initialize(struct reb_simulation* sim, struct rebx_extras* rebx){
     if(sim->additional_forces || sim->pre_timestep_modifications || sim->post_timestep_modifications){
         reb_simulation_warning(sim, "REBOUNDx overwrites sim->additional_forces, sim->pre_timestep_modifications and sim->post_timestep_modifications whenever forces or operators that use them get added.  If you want to use REBOUNDx together with your own custom functions that use these callbacks, you should add them through REBOUNDx.  See https://github.com/dtamayo/reboundx/blob/master/ipython_examples/Custom_Effects.ipynb for a tutorial.");
     }
+    rebx->mpi_params = NULL;
+#ifdef MPI
+    sim->pre_timestep_modifications = rebx_pre_timestep_modifications; // particle parameters need to follow particles that moved to other ranks even without operators
+#endif // MPI
 }
 
 void rebx_free(struct rebx_extras* rebx){
@@ -251,6 +321,7 @@ struct rebx_force* rebx_create_force(struct rebx_extras* const rebx, const char*
     force->sim = rebx->sim;
     force->force_type = REBX_FORCE_NONE;
     force->update_accelerations = NULL;
+    force->update_accelerations_testparticles = NULL;
     force->name = NULL;
     if(name != NULL)
     {
@@ -287,14 +358,17 @@ struct rebx_force* rebx_load_force(struct rebx_extras* const rebx, const char* n
     }
     else if (strcmp(name, "central_force") == 0){
         force->update_accelerations = rebx_central_force;
+        force->update_accelerations_testparticles = rebx_central_force_testparticles;
         force->force_type = REBX_FORCE_POS;
     }
     else if (strcmp(name, "modify_orbits_forces") == 0){
         force->update_accelerations = rebx_modify_orbits_forces;
+        force->update_accelerations_testparticles = rebx_modify_orbits_forces_testparticles;
         force->force_type = REBX_FORCE_VEL;
     }
     else if (strcmp(name, "exponential_migration") == 0){
         force->update_accelerations = rebx_exponential_migration;
+        force->update_accelerations_testparticles = rebx_exponential_migration_testparticles;
         force->force_type = REBX_FORCE_VEL;
     }
     else if (strcmp(name, "gr_full") == 0){
@@ -303,10 +377,12 @@ struct rebx_force* rebx_load_force(struct rebx_extras* const rebx, const char* n
     }
     else if (strcmp(name, "gravitational_harmonics") == 0){
         force->update_accelerations = rebx_gravitational_harmonics;
+        force->update_accelerations_testparticles = rebx_gravitational_harmonics_testparticles;
         force->force_type = REBX_FORCE_POS;
     }
     else if (strcmp(name, "gr_potential") == 0){
         force->update_accelerations = rebx_gr_potential;
+        force->update_accelerations_testparticles = rebx_gr_potential_testparticles;
         force->force_type = REBX_FORCE_POS;
     }
     else if (strcmp(name, "radiation_forces") == 0){
@@ -319,14 +395,17 @@ struct rebx_force* rebx_load_force(struct rebx_extras* const rebx, const char* n
     }
     else if (strcmp(name, "tides_constant_time_lag") == 0){
         force->update_accelerations = rebx_tides_constant_time_lag;
+        force->update_accelerations_testparticles = rebx_tides_constant_time_lag_testparticles;
         force->force_type = REBX_FORCE_VEL;
     }
     else if (strcmp(name, "type_I_migration") == 0){
         force->update_accelerations = rebx_modify_orbits_with_type_I_migration;
+        force->update_accelerations_testparticles = rebx_modify_orbits_with_type_I_migration_testparticles;
         force->force_type = REBX_FORCE_VEL;
     }
     else if (strcmp(name, "tides_spin") == 0){
         force->update_accelerations = rebx_tides_spin;
+        force->update_accelerations_testparticles = rebx_tides_spin_testparticles;
         force->force_type = REBX_FORCE_VEL;
     }
     else if (strcmp(name, "yarkovsky_effect") == 0){
@@ -341,6 +420,14 @@ struct rebx_force* rebx_load_force(struct rebx_extras* const rebx, const char* n
         force->update_accelerations = rebx_lense_thirring;
         force->force_type = REBX_FORCE_VEL;
     }
+    else if (strcmp(name, "gas_drag") == 0){
+        force->update_accelerations = rebx_gas_drag;
+        force->force_type = REBX_FORCE_VEL;
+    }
+    else if (strcmp(name, "disk_self_gravity") == 0){
+        force->update_accelerations = rebx_disk_self_gravity;
+        force->force_type = REBX_FORCE_POS;
+    }
     else{
         char str[300];
         sprintf(str, "REBOUNDx error: Force '%s' not found in REBOUNDx library.\n", name);
@@ -369,7 +456,7 @@ struct rebx_operator* rebx_create_operator(struct rebx_extras* const rebx, const
     if(name != NULL){
         operator->name = rebx_malloc(rebx, strlen(name) + 1); // +1 for \0 at end
         if (operator->name == NULL){
-            rebx_free_operator(operator);
+            rebx_free_operator(rebx, operator);
             return NULL;
         }
         else{
@@ -380,7 +467,7 @@ struct rebx_operator* rebx_create_operator(struct rebx_extras* const rebx, const
     // Add operator to allocated_operators list for later freeing
     struct rebx_node* node = rebx_create_node(rebx);
     if (node == NULL){
-        rebx_free_operator(operator);
+        rebx_free_operator(rebx, operator);
         return NULL;
     }
     node->object = operator;
@@ -410,6 +497,10 @@ struct rebx_operator* rebx_load_operator(struct rebx_extras* const rebx, const c
         operator->step_function = rebx_kick_step;
         operator->operator_type = REBX_OPERATOR_UPDATER;
     }
+    else if (strcmp(name, "kick_forces") == 0){
+        operator->step_function = rebx_kick_forces_step;
+        operator->operator_type = REBX_OPERATOR_UPDATER;
+    }
     else if (strcmp(name, "kepler") == 0){
         operator->step_function = rebx_kepler_step;
         operator->operator_type = REBX_OPERATOR_UPDATER;
@@ -426,6 +517,10 @@ struct rebx_operator* rebx_load_operator(struct rebx_extras* const rebx, const c
         operator->step_function = rebx_ias15_step;
         operator->operator_type = REBX_OPERATOR_UPDATER;
     }
+    else if (strcmp(name, "ias15_group") == 0){
+        operator->step_function = rebx_ias15_group_step;
+        operator->operator_type = REBX_OPERATOR_UPDATER;
+    }
     else if (strcmp(name, "modify_orbits_direct") == 0){
         operator->step_function = rebx_modify_orbits_direct;
         operator->operator_type = REBX_OPERATOR_UPDATER;
@@ -434,6 +529,38 @@ struct rebx_operator* rebx_load_operator(struct rebx_extras* const rebx, const c
         operator->step_function = rebx_track_min_distance;
         operator->operator_type = REBX_OPERATOR_RECORDER;
     }
+    else if (strcmp(name, "track_encounters") == 0){
+        operator->step_function = rebx_track_encounters;
+        operator->operator_type = REBX_OPERATOR_RECORDER;
+    }
+    else if (strcmp(name, "running_stats") == 0){
+        operator->step_function = rebx_running_stats;
+        operator->operator_type = REBX_OPERATOR_RECORDER;
+    }
+    else if (strcmp(name, "track_events") == 0){
+        operator->step_function = rebx_track_events;
+        operator->operator_type = REBX_OPERATOR_RECORDER;
+    }
+    else if (strcmp(name, "record_params") == 0){
+        operator->step_function = rebx_record_params;
+        operator->operator_type = REBX_OPERATOR_RECORDER;
+    }
+    else if (strcmp(name, "tides_constant_time_lag_averaged") == 0){
+        operator->step_function = rebx_tides_constant_time_lag_averaged;
+        operator->operator_type = REBX_OPERATOR_UPDATER;
+    }
+    else if (strcmp(name, "gas_drag_exact") == 0){
+        operator->step_function = rebx_gas_drag_exact;
+        operator->operator_type = REBX_OPERATOR_UPDATER;
+    }
+    else if (strcmp(name, "flyby") == 0){
+        operator->step_function = rebx_flyby;
+        operator->operator_type = REBX_OPERATOR_UPDATER;
+    }
+    else if (strcmp(name, "collisional_damping") == 0){
+        operator->step_function = rebx_collisional_damping;
+        operator->operator_type = REBX_OPERATOR_UPDATER;
+    }
     else{
         char str[300];
         sprintf(str, "REBOUNDx error: Operator '%s' not found in REBOUNDx library.\n", name);
@@ -465,10 +592,6 @@ int rebx_add_force(struct rebx_extras* rebx, struct rebx_force* force){
         return 0;
     }
 
-    if (force->force_type == REBX_FORCE_VEL){
-        rebx->sim->force_is_velocity_dependent = 1;
-    }
-
     // Could add logic based on different integrators
     struct rebx_node* node = rebx_create_node(rebx);
     if (node == NULL){
@@ -476,6 +599,7 @@ int rebx_add_force(struct rebx_extras* rebx, struct rebx_force* force){
     }
     node->object = force;
     rebx_add_node(&rebx->additional_forces, node);
+    rebx_update_velocity_dependence(rebx);
     if (rebx->sim->additional_forces != NULL && rebx->sim->additional_forces != rebx_additional_forces){
         reb_simulation_warning(rebx->sim, "REBOUNDx Warning: additional_forces was set and is being overwritten by REBOUNDx. To incorporate both, you can add your own custom effects through REBOUNDx.  See https://github.com/dtamayo/reboundx/blob/master/ipython_examples/Custom_Effects.ipynb for a tutorial.\n");
     }
@@ -584,6 +708,91 @@ int rebx_add_operator(struct rebx_extras* rebx, struct rebx_operator* operator){
  User interface for setting parameter values
  *****************************************************************/
 
+static void rebx_notify_param_observers(struct rebx_extras* const rebx, struct rebx_node** const apptr, const char* const param_name){
+    struct rebx_node* current = rebx->param_observers;
+    while (current != NULL){
+        struct rebx_param_observer* observer = current->object;
+        if (observer->name == NULL || strcmp(observer->name, param_name) == 0){
+            if (observer->flag != NULL){
+                *observer->flag = 1;
+            }
+            if (observer->callback != NULL){
+                observer->callback(rebx, apptr, param_name, observer->data);
+            }
+        }
+        current = current->next;
+    }
+}
+
+struct rebx_param_observer* rebx_add_param_observer(struct rebx_extras* const rebx, const char* const param_name, void (*callback) (struct rebx_extras* const rebx, struct rebx_node** const apptr, const char* const param_name, void* const data), void* const data, int* const flag){
+    if (param_name != NULL && rebx_get_type(rebx, param_name) == REBX_TYPE_NONE){
+        char str[300];
+        sprintf(str, "REBOUNDx Error: Need to register parameter name '%s' before observing it. See examples.\n", param_name);
+        rebx_error(rebx, str);
+        return NULL;
+    }
+    struct rebx_param_observer* observer = rebx_malloc(rebx, sizeof(*observer));
+    struct rebx_node* node = rebx_malloc(rebx, sizeof(*node));
+    if (observer == NULL || node == NULL){
+        free(observer);
+        free(node);
+        return NULL;
+    }
+    observer->name = NULL;
+    if (param_name != NULL){
+        observer->name = rebx_malloc(rebx, strlen(param_name) + 1);
+        if (observer->name == NULL){
+            free(observer);
+            free(node);
+            return NULL;
+        }
+        strcpy(observer->name, param_name);
+    }
+    observer->callback = callback;
+    observer->data = data;
+    observer->flag = flag;
+    node->object = observer;
+    node->next = rebx->param_observers;
+    rebx->param_observers = node;
+    return observer;
+}
+
+int rebx_remove_param_observer(struct rebx_extras* const rebx, struct rebx_param_observer* const observer){
+    struct rebx_node** link = &rebx->param_observers;
+    while (*link != NULL){
+        struct rebx_node* node = *link;
+        if (node->object == observer){
+            *link = node->next;
+            free(observer->name);
+            free(observer);
+            free(node);
+            return 1;
+        }
+        link = &node->next;
+    }
+    return 0;
+}
+
+int rebx_remove_param(struct rebx_extras* const rebx, struct rebx_node** apptr, const char* const param_name){
+    if (apptr == NULL){
+        return 0;
+    }
+    struct rebx_node** link = apptr;
+    while (*link != NULL){
+        struct rebx_node* node = *link;
+        struct rebx_param* param = node->object;
+        if (strcmp(param->name, param_name) == 0){
+            *link = node->next;
+            rebx_free_param(param);
+            free(node);
+            rebx_notify_param_observers(rebx, apptr, param_name);
+            return 1;
+        }
+        link = &node->next;
+    }
+    return 0;
+}
+
 // Gets parameter if it already exists, otherwise creates a new one and adds it to the passed linked list
 struct rebx_param* rebx_get_or_add_param(struct rebx_extras* const rebx, struct rebx_node** apptr, const char* const param_name){
     if (apptr == NULL){
@@ -621,6 +830,7 @@ void rebx_set_param_pointer(struct rebx_extras* const rebx, struct rebx_node** a
         return;
     }
     param->value = val;
+    rebx_notify_param_observers(rebx, apptr, param_name);
     return;
 }
 
@@ -636,6 +846,7 @@ void rebx_set_param_double(struct rebx_extras* const rebx, struct rebx_node** ap
     double* valptr = param->value;
     *valptr = val;
 
+    rebx_notify_param_observers(rebx, apptr, param_name);
     return;
 }
 
@@ -651,6 +862,7 @@ void rebx_set_param_int(struct rebx_extras* const rebx, struct rebx_node** apptr
     int* valptr = param->value;
     *valptr = val;
 
+    rebx_notify_param_observers(rebx, apptr, param_name);
     return;
 }
 
@@ -666,6 +878,7 @@ void rebx_set_param_uint32(struct rebx_extras* const rebx, struct rebx_node** ap
     uint32_t* valptr = param->value;
     *valptr = val;
 
+    rebx_notify_param_observers(rebx, apptr, param_name);
     return;
 }
 
@@ -683,6 +896,7 @@ void rebx_set_param_vec3d(struct rebx_extras* const rebx, struct rebx_node** app
     valptr->y = val.y;
     valptr->z = val.z;
 
+    rebx_notify_param_observers(rebx, apptr, param_name);
     return;
 }
 
@@ -750,6 +964,7 @@ int rebx_remove_force(struct rebx_extras* rebx, struct rebx_force* force){
     }
     // success only cares about removal from add_forces that affects sim
     int success = rebx_remove_node(&rebx->additional_forces, force);
+    rebx_update_velocity_dependence(rebx);
     return success;
 }
 
@@ -789,7 +1004,7 @@ static int rebx_remove_step_node(struct rebx_node** head, struct rebx_operator*
 int rebx_remove_operator(struct rebx_extras* rebx, struct rebx_operator* operator){
     int allocated = rebx_remove_node(&rebx->allocated_operators, operator);
     if(allocated){
-        rebx_free_operator(operator);
+        rebx_free_operator(rebx, operator);
 
     }
 
@@ -834,7 +1049,7 @@ void rebx_free_param(struct rebx_param* param){
         free(param->name);
     }
     // Don't free pointers to structs
-    if(param->type == REBX_TYPE_INT || param->type == REBX_TYPE_DOUBLE){
+    if(param->type == REBX_TYPE_INT || param->type == REBX_TYPE_DOUBLE || param->type == REBX_TYPE_UINT32 || param->type == REBX_TYPE_VEC3D){
         if(param->value){
             free(param->value);
         }
@@ -854,6 +1069,12 @@ void rebx_free_ap(struct rebx_node** ap){
 }
 
 void rebx_free_particle_ap(struct reb_particle* p){
+#ifdef MPI
+    if (p->ap != NULL && p->sim != NULL && p->sim->extras != NULL){ // REBOUND might be sending the particle to another rank, so keep parameters until they've been sent along
+        rebx_mpi_stash_particle_ap(p->sim->extras, p);
+        return;
+    }
+#endif // MPI
     rebx_free_ap(&p->ap);
 }
 
@@ -869,7 +1090,11 @@ void rebx_free_force(struct rebx_extras* rebx, struct rebx_force* force){
     free(force);
 }
 
-void rebx_free_operator(struct rebx_operator* operator){
+void rebx_free_operator(struct rebx_extras* rebx, struct rebx_operator* operator){
+    void (*free_arrays)(struct rebx_extras* rebx, struct rebx_operator* operator) = rebx_get_param(rebx, operator->ap, "free_arrays");
+    if (free_arrays){
+        free_arrays(rebx, operator);
+    }
     if(operator->name){
         free(operator->name);
     }
@@ -907,7 +1132,7 @@ void rebx_free_pointers(struct rebx_extras* rebx){
     current = rebx->allocated_operators;
     while (current != NULL){
         next = current->next;
-        rebx_free_operator(current->object);
+        rebx_free_operator(rebx, current->object);
         free(current);
         current = next;
     }
@@ -943,6 +1168,26 @@ void rebx_free_pointers(struct rebx_extras* rebx){
         free(current);
         current = next;
     }
+
+    current = rebx->param_observers;
+    while (current != NULL){
+        next = current->next;
+        struct rebx_param_observer* observer = current->object;
+        free(observer->name);
+        free(observer);
+        free(current);
+        current = next;
+    }
+    rebx->param_observers = NULL;
+
+    free(rebx->orbits);
+    rebx->orbits = NULL;
+    rebx->orbits_N = 0;
+    rebx->orbits_valid = 0;
+    rebx_free_jacobi(rebx);
+#ifdef MPI
+    rebx_mpi_free(rebx);
+#endif // MPI
 }
 
 /**********************************************
@@ -957,8 +1202,57 @@ void rebx_reset_accelerations(struct reb_particle* const ps, const int N){
     }
 }
 
+void rebx_update_velocity_dependence(struct rebx_extras* rebx){
+    struct reb_simulation* const sim = rebx->sim;
+    if (sim == NULL){
+        return;
+    }
+    int velocity_dependent = 0;
+    for (struct rebx_node* current = rebx->additional_forces; current != NULL; current = current->next){
+        const struct rebx_force* const force = current->object;
+        if (force->force_type == REBX_FORCE_VEL){
+            velocity_dependent = 1;
+            break;
+        }
+    }
+    if (velocity_dependent && !sim->force_is_velocity_dependent){
+        sim->force_is_velocity_dependent = 1;
+        rebx->set_velocity_dependent = 1;
+    }
+    else if (!velocity_dependent && rebx->set_velocity_dependent){ // don't turn off a flag the user (or REBOUND) set
+        sim->force_is_velocity_dependent = 0;
+        rebx->set_velocity_dependent = 0;
+    }
+}
+
+static void rebx_call_force(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N, const int testparticles_massless);
+
+// 1 if particles [N_active, N) are massless test particles that only feel the active particles, so forces can hand them to their test particle kernels.
+// REBOUND allows massive particles beyond N_active, which the kernels don't treat as sources, so masses are checked once per force evaluation (they can change between evaluations, e.g., with modify_mass).
+static int rebx_testparticles_massless(const struct reb_simulation* const sim, const struct reb_particle* const particles, const int N){
+#ifdef MPI
+    return 0;   // particle indices are local to each rank, so [N_active, N) doesn't identify test particles
+#else
+    const int N_active = sim->N_active;
+    if (sim->testparticle_type != 0 || N_active <= 0 || N_active >= N){
+        return 0;
+    }
+    for (int i=N_active; i<N; i++){
+        if (particles[i].m != 0.){
+            return 0;
+        }
+    }
+    return 1;
+#endif // MPI
+}
+
 void rebx_additional_forces(struct reb_simulation* sim){
     struct rebx_extras* rebx = sim->extras;
+    rebx_invalidate_jacobi(rebx);   // new particle states, shared by all the forces below
+#ifdef MPI
+    rebx_mpi_migrate_params(rebx);  // only does work on the first force evaluation after REBOUND moved particles between ranks
+#endif // MPI
+    const int testparticles_massless = rebx_testparticles_massless(sim, sim->particles, sim->N - sim->N_var);
     struct rebx_node* current = rebx->additional_forces;
     while(current != NULL){
         /*if(sim->force_is_velocity_dependent && sim->integrator==REB_INTEGRATOR_WHFAST){
@@ -966,23 +1260,50 @@ void rebx_additional_forces(struct reb_simulation* sim){
          }*/
         struct rebx_force* force = current->object;
         const double N = sim->N - sim->N_var;
-        force->update_accelerations(sim, force, sim->particles, N);
+        rebx_call_force(sim, force, sim->particles, N, testparticles_massless);
         current = current->next;
     }
 }
 
+void rebx_update_accelerations(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N){
+    rebx_invalidate_jacobi(sim->extras);    // particles may be a scratch array (e.g., a Runge-Kutta stage) reused with new states
+    rebx_call_force(sim, force, particles, N, rebx_testparticles_massless(sim, particles, N));
+}
+
+static void rebx_call_force(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N, const int testparticles_massless){
+    struct rebx_extras* const rebx = sim->extras;
+    rebx->force_evaluations++;
+    const int N_active = sim->N_active;
+    // Massless test particles only feel the active particles, so forces with a test particle kernel can skip them in the general loop
+    if (testparticles_massless && force->update_accelerations_testparticles != NULL){
+        force->update_accelerations(sim, force, particles, N_active);
+        force->update_accelerations_testparticles(sim, force, particles, N_active, N);
+    }
+    else{
+        force->update_accelerations(sim, force, particles, N);
+    }
+}
+
 void rebx_pre_timestep_modifications(struct reb_simulation* sim){
     struct rebx_extras* rebx = sim->extras;
     struct rebx_node* current = rebx->pre_timestep_modifications;
     const double dt = sim->dt;
+    rebx_invalidate_orbits(rebx);  // particles may have been modified since the last step
+#ifdef MPI
+    rebx_mpi_migrate_params(rebx);  // in case neither forces nor post-timestep modifications ran after particles moved in the last step
+    rebx_mpi_expect_redistribution(rebx);
+#endif // MPI
 
     while(current != NULL){
         struct rebx_step* step = current->object;
         struct rebx_operator* operator = step->operator;
         if(sim->integrator==REB_INTEGRATOR_IAS15 && sim->ri_ias15.epsilon != 0 && operator->operator_type == REBX_OPERATOR_UPDATER){
-            reb_simulation_warning(sim, "REBOUNDx: Operators that affect particle trajectories with adaptive timesteps can give spurious results. Use sim.ri_ias15.epsilon=0 for fixed timestep with IAS, or use a different integrator.");
+            rebx_diagnostic(rebx, REBX_DIAGNOSTIC_ADAPTIVE_OPERATOR);
         }
         operator->step_function(sim, operator, dt*step->dt_fraction);
+        if (operator->operator_type != REBX_OPERATOR_RECORDER){
+            rebx_invalidate_orbits(rebx);
+        }
         current = current->next;
     }
 }
@@ -991,14 +1312,21 @@ void rebx_post_timestep_modifications(struct reb_simulation* sim){
     struct rebx_extras* rebx = sim->extras;
     struct rebx_node* current = rebx->post_timestep_modifications;
     const double dt = sim->dt;
+    rebx_invalidate_orbits(rebx);  // integrator has moved the particles
+#ifdef MPI
+    rebx_mpi_migrate_params(rebx);
+#endif // MPI
 
     while(current != NULL){
         struct rebx_step* step = current->object;
         struct rebx_operator* operator = step->operator;
         if(sim->integrator==REB_INTEGRATOR_IAS15 && sim->ri_ias15.epsilon != 0 && operator->operator_type == REBX_OPERATOR_UPDATER){
-            reb_simulation_warning(sim, "REBOUNDx: Operators that affect particle trajectories with adaptive timesteps can give spurious results. Use sim.ri_ias15.epsilon=0 for fixed timestep with IAS, or use a different integrator.");
+            rebx_diagnostic(rebx, REBX_DIAGNOSTIC_ADAPTIVE_OPERATOR);
         }
         operator->step_function(sim, operator, dt*step->dt_fraction);
+        if (operator->operator_type != REBX_OPERATOR_RECORDER){
+            rebx_invalidate_orbits(rebx);
+        }
         current = current->next;
     }
 }
@@ -1091,6 +1419,58 @@ size_t rebx_sizeof(struct rebx_extras* rebx, enum rebx_param_type type){
     }
 }
 
+/****************************************************************
+ Diagnostics
+ ****************************************************************/
+
+static const char* const rebx_diagnostic_messages[REBX_DIAGNOSTIC_N] = {
+    "Spin axes are not being evolved. Call rebx_spin_initialize_ode to evolve.",
+    "Operators that affect particle trajectories with adaptive timesteps can give spurious results. Use sim.ri_ias15.epsilon=0 for fixed timestep with IAS, or use a different integrator.",
+    "10 iterations in gr.c failed to converge. This is typically because the perturbation is too strong for the current implementation.",
+    "10 loops in rebx_gr_full did not converge.",
+    "10 iterations in integrator_implicit_midpoint.c failed to converge. This is typically because the perturbation is too strong for the current implementation.",
+};
+
+void rebx_diagnostic(struct rebx_extras* const rebx, const enum rebx_diagnostic code){
+    const unsigned long count = ++rebx->diagnostic_counts[code];
+    if (count < rebx->diagnostic_next_report[code] || rebx->sim == NULL){
+        return;
+    }
+    // only report on the 1st, 10th, 100th... occurrence so that conditions hit on every call don't flood the warnings
+    rebx->diagnostic_next_report[code] *= 10;
+    if (count == 1){
+        char str[400];
+        snprintf(str, sizeof(str), "REBOUNDx Warning: %s", rebx_diagnostic_messages[code]);
+        reb_simulation_warning(rebx->sim, str);
+    }
+    else{
+        char str[500];
+        snprintf(str, sizeof(str), "REBOUNDx Warning (%lu occurrences, next reported at %lu): %s", count, rebx->diagnostic_next_report[code], rebx_diagnostic_messages[code]);
+        reb_simulation_warning(rebx->sim, str);
+    }
+}
+
+unsigned long rebx_diagnostic_count(struct rebx_extras* const rebx, const enum rebx_diagnostic code){
+    if (code < 0 || code >= REBX_DIAGNOSTIC_N){
+        return 0;
+    }
+    return rebx->diagnostic_counts[code];
+}
+
+const char* rebx_diagnostic_message(const enum rebx_diagnostic code){
+    if (code < 0 || code >= REBX_DIAGNOSTIC_N){
+        return NULL;
+    }
+    return rebx_diagnostic_messages[code];
+}
+
+void rebx_diagnostics_reset(struct rebx_extras* const rebx){
+    for (int i=0; i<REBX_DIAGNOSTIC_N; i++){
+        rebx->diagnostic_counts[i] = 0;
+        rebx->diagnostic_next_report[i] = 1;
+    }
+}
+
 void rebx_error(struct rebx_extras* rebx, const char* const msg){
     if (rebx->sim == NULL){
         fprintf(stderr, "REBOUNDx Error: A Simulation is no longer attached to this REBOUNDx extras instance. Most likely the Simulation has been freed.\n");
@@ -51,8 +51,48 @@ void rebx_init_interpolator(struct rebx_extras* const rebx, struct rebx_interpol
  *********************************************/
 
 void rebx_additional_forces(struct reb_simulation* sim);                       // Calls all the forces that have been added to the simulation.
+void rebx_update_accelerations(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N); // Calls a force on new particle states, using its test particle kernel for particles [N_active, N) if it has one.
+void rebx_update_velocity_dependence(struct rebx_extras* rebx);                 // Sets sim->force_is_velocity_dependent from the velocity-dependent forces currently added.
 void rebx_pre_timestep_modifications(struct reb_simulation* sim);   // Calls all the pre-timestep modifications that have been added to the simulation.
 void rebx_post_timestep_modifications(struct reb_simulation* sim);  // Calls all the post-timestep modifications that have been added to the simulation.
+void rebx_diagnostic(struct rebx_extras* const rebx, const enum rebx_diagnostic code); // Counts an occurrence of code, warning only on its 1st, 10th, 100th... occurrence. Use instead of warnings on the hot path.
+
+#ifdef MPI
+/**********************************************
+ Keeping particle parameters with particles that move between MPI ranks (communication_mpi.c)
+ *********************************************/
+
+void rebx_mpi_migrate_params(struct rebx_extras* const rebx);   // Collective. If particles may have moved since the last call, sends parameters of particles that left each rank to the rank they're now on.
+void rebx_mpi_expect_redistribution(struct rebx_extras* const rebx); // Marks that REBOUND is about to move particles between ranks (once per step), so the next rebx_mpi_migrate_params does work.
+void rebx_mpi_stash_particle_ap(struct rebx_extras* const rebx, struct reb_particle* const p); // Holds on to a removed particle's parameters until the next rebx_mpi_migrate_params
+void rebx_mpi_free(struct rebx_extras* const rebx);
+#endif // MPI
+
+/**********************************************
+ Gas disk and pebbles shared by gas_drag and gas_drag_exact (gas_drag.c)
+ *********************************************/
+
+struct rebx_gas_drag_disk{
+    double rhog;            // midplane density rhog*r^alpha_rhog
+    double alpha_rhog;
+    double cs;              // sound speed cs*r^alpha_cs
+    double alpha_cs;
+    double mfp;             // mean free path where the density is rhog (0 for Epstein drag only)
+};
+
+struct rebx_gas_drag_pebbles{
+    int N;                  // number of particles with gas drag params
+    int* index;             // their indices in the particles array
+    double* ts;             // stopping times
+    double* dvx;            // velocities relative to the local gas
+    double* dvy;
+    double* dvz;
+    double* buf;            // single allocation backing the arrays above
+};
+
+int rebx_gas_drag_load_disk(struct reb_simulation* const sim, struct rebx_node* const ap, struct rebx_gas_drag_disk* const disk); // Returns 0 (and sets a simulation error) if a required param is missing.
+int rebx_gas_drag_load_pebbles(struct reb_simulation* const sim, struct reb_particle* const particles, const int N, const struct rebx_gas_drag_disk* const disk, struct rebx_gas_drag_pebbles* const pebbles); // Returns the number of pebbles. Free with rebx_gas_drag_free_pebbles if nonzero.
+void rebx_gas_drag_free_pebbles(struct rebx_gas_drag_pebbles* const pebbles);
 
 /***********************************************************************************
  * Miscellaneous Functions
@@ -61,24 +101,42 @@ void rebx_post_timestep_modifications(struct reb_simulation* sim);  // Calls all
 size_t rebx_sizeof(struct rebx_extras* rebx, enum rebx_param_type type); // Returns size in bytes of the corresponding rebx_param_type type
 void rebx_reset_accelerations(struct reb_particle* const ps, const int N);
 
+/**********************************************
+ Particle loops of the stepper kernels (steppers.c), with settings from rebx_autotune (autotune.c)
+ *********************************************/
+
+void rebx_tuning_set_defaults(struct rebx_tuning* const tuning);
+void rebx_drift_particles(const struct rebx_tuning* const tuning, struct reb_particle* const particles, const int N, const double dt); // x += dt*v
+void rebx_kick_particles(const struct rebx_tuning* const tuning, struct reb_particle* const particles, const int N, const double dt);  // v += dt*a
+
 /****************************************
 Force prototypes
 *****************************************/
 void rebx_gr(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
 void rebx_gr_full(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
 void rebx_gr_potential(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
+void rebx_gr_potential_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N_active, const int N);
 void rebx_radiation_forces(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
 void rebx_stochastic_forces(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
 void rebx_modify_orbits_forces(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
+void rebx_modify_orbits_forces_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N_active, const int N);
 void rebx_exponential_migration(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
+void rebx_exponential_migration_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N_active, const int N);
 void rebx_tides_constant_time_lag(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
+void rebx_tides_constant_time_lag_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N_active, const int N);
 void rebx_central_force(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
+void rebx_central_force_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N_active, const int N);
 void rebx_gravitational_harmonics(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
+void rebx_gravitational_harmonics_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N_active, const int N);
 void rebx_modify_orbits_with_type_I_migration(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
+void rebx_modify_orbits_with_type_I_migration_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N_active, const int N);
 void rebx_tides_spin(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
+void rebx_tides_spin_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N_active, const int N);
 void rebx_yarkovsky_effect(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
 void rebx_gas_dynamical_friction(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
 void rebx_lense_thirring(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
+void rebx_gas_drag(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
+void rebx_disk_self_gravity(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N);
 /****************************************
  Operator prototypes
  *****************************************/
@@ -86,6 +144,14 @@ void rebx_modify_mass(struct reb_simulation* const sim, struct rebx_operator* co
 void rebx_integrate_force(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
 void rebx_modify_orbits_direct(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
 void rebx_track_min_distance(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
+void rebx_track_encounters(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
+void rebx_running_stats(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
+void rebx_track_events(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
+void rebx_record_params(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
+void rebx_tides_constant_time_lag_averaged(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
+void rebx_gas_drag_exact(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
+void rebx_flyby(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
+void rebx_collisional_damping(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
 
 /****************************************
  Integrator prototypes
@@ -100,7 +166,7 @@ void* rebx_malloc(struct rebx_extras* const rebx, size_t memsize);
 void rebx_free_ap(struct rebx_node** ap);
 void rebx_free_particle_ap(struct reb_particle* p);
 void rebx_free_force(struct rebx_extras* rebx, struct rebx_force* force);
-void rebx_free_operator(struct rebx_operator* operator);
+void rebx_free_operator(struct rebx_extras* rebx, struct rebx_operator* operator);
 void rebx_free_step(struct rebx_step* step);
 void rebx_free_pointers(struct rebx_extras* rebx);
 void rebx_free_param(struct rebx_param* param);
@@ -0,0 +1,346 @@
+/**
+ * @file    disk_self_gravity.c
+ * @brief   Gravitational field of a massive axisymmetric disk, tabulated on an (R, z) grid
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * The section after the dollar signs gets built into the documentation by a script.  All lines must start with space * space like below.
+ * Tables always must be preceded and followed by a blank line.  See http://docutils.sourceforge.net/docs/user/rst/quickstart.html for a primer on rst.
+ * $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
+ *
+ * $Gas Effects$       // Effect category (must be the first non-blank line after dollar signs and between dollar signs to be detected by script).
+ *
+ * ======================= ===============================================
+ * Authors                 D. Tamayo
+ * Implementation Paper    None
+ * Based on                `Binney and Tremaine 2008, Sec. 2.6 <https://ui.adsabs.harvard.edu/abs/2008gady.book.....B/abstract>`_.
+ * C Example               None
+ * Python Example          None
+ * ======================= ===============================================
+ *
+ * Adds the gravitational acceleration from a razor-thin, axisymmetric disk centered on the primary (particles[0]) and lying in the z=0 plane,
+ * on all other particles. There is no back-reaction on the primary (which an axisymmetric disk centered on it would not feel) or on the disk.
+ * The disk's surface density is dsg_sigma0*R^dsg_alpha between dsg_rin and dsg_rout, or dsg_sigma0 times an arbitrary radial profile passed as a rebx_interpolator
+ * (created with rebx_create_interpolator, with the radii passed as the times) in dsg_profile.
+ *
+ * Summing the field of each ring requires complete elliptic integrals for every particle, ring and substep, so the radial and vertical accelerations
+ * are instead tabulated once on a uniform grid in cylindrical R and abs(z), and interpolated bilinearly for each particle.
+ * The table is built by summing dsg_Nrings rings, each evaluated with K(k) and E(k) from the arithmetic-geometric mean, and softened by dsg_softening
+ * (added in quadrature to z) to smooth the field across the razor-thin disk and between rings.
+ * Outside the table, the disk acts as a point mass at the primary.
+ *
+ * The table scales linearly with dsg_sigma0, so dsg_sigma0 can be changed at any time (e.g., interpolated in time with rebx_interpolate from an operator) without rebuilding it.
+ * The table is rebuilt whenever any of the other effect parameters change. If dsg_refresh is set, these rebuilds happen at most once per dsg_refresh in simulation time,
+ * and the table is also rebuilt every dsg_refresh, to pick up profiles whose interpolator values are modified in place.
+ *
+ * **Effect Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * dsg_sigma0 (double)          Yes         Surface density normalization.
+ * dsg_rin (double)             Yes         Inner edge of the disk.
+ * dsg_rout (double)            Yes         Outer edge of the disk.
+ * dsg_alpha (double)           No          Power-law slope of the surface density, dsg_sigma0*R^dsg_alpha. Defaults to 0. Ignored if dsg_profile is set.
+ * dsg_profile (rebx_interp*)   No          Interpolator giving the surface density profile (in units of dsg_sigma0) vs. radius.
+ * dsg_softening (double)       No          Softening length. Defaults to the larger of the table's and the rings' radial spacings.
+ * dsg_rmax (double)            No          Extent of the table in R. Defaults to 3*dsg_rout.
+ * dsg_zmax (double)            No          Extent of the table in abs(z). Defaults to 3*dsg_rout.
+ * dsg_Nr (int)                 No          Number of table points in R. Defaults to 256.
+ * dsg_Nz (int)                 No          Number of table points in abs(z). Defaults to 128.
+ * dsg_Nrings (int)             No          Number of rings the disk is divided into to build the table. Defaults to 256.
+ * dsg_refresh (double)         No          Minimum simulation time between table rebuilds (see above).
+ * ============================ =========== ==================================================================
+ *
+ * **Particle Parameters**
+ *
+ * *None*
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+#include "core.h"
+
+// Disk shape and table layout. Accelerations are tabulated per unit G*dsg_sigma0.
+struct rebx_dsg_shape{
+    double rin;
+    double rout;
+    double alpha;
+    struct rebx_interpolator* profile;
+    double softening;
+    double rmax;
+    double zmax;
+    int Nr;
+    int Nz;
+    int Nrings;
+};
+
+struct rebx_dsg_table{
+    struct rebx_dsg_shape shape;
+    double dr;
+    double dz;
+    double* aR;             // aR[j*Nr + i] at R = i*dr, z = j*dz
+    double* az;
+    double mass;            // disk mass per unit dsg_sigma0
+    double t_built;
+};
+
+// Complete elliptic integrals of the first and second kinds with parameter m = k^2, from the arithmetic-geometric mean
+static void rebx_dsg_ellip(const double m, double* const K, double* const E){
+    double a = 1.;
+    double b = sqrt(1.-m);
+    double pow2 = 0.5;
+    double sum = 0.5*m;
+    while (fabs(a-b) > 1.e-15*a){
+        const double c = 0.5*(a-b);
+        const double an = 0.5*(a+b);
+        b = sqrt(a*b);
+        a = an;
+        pow2 *= 2.;
+        sum += pow2*c*c;
+    }
+    *K = M_PI/(2.*a);
+    *E = (*K)*(1.-sum);
+}
+
+// Acceleration at (R, z) from a softened ring of radius a and unit G*mass
+static void rebx_dsg_ring(const double a, const double R, const double z, const double eps2, double* const aR, double* const az){
+    const double S2 = (a+R)*(a+R) + z*z + eps2;
+    const double S = sqrt(S2);
+    const double m = 4.*a*R/S2;
+    double K, E, dKdm;
+    rebx_dsg_ellip(m, &K, &E);
+    if (m < 1.e-3){
+        dKdm = M_PI/2.*(1./4. + 9./32.*m + 75./256.*m*m); // series avoids cancellation near the axis
+    }
+    else{
+        dKdm = (E/(1.-m) - K)/(2.*m);
+    }
+    const double S4 = S2*S2;
+    const double dmdR = 4.*a*(a*a - R*R + z*z + eps2)/S4;
+    const double dmdz = -8.*a*R*z/S4;
+    // a = grad(2/pi K(m)/S)
+    *aR = 2./M_PI*(dKdm*dmdR/S - K*(a+R)/(S2*S));
+    *az = 2./M_PI*(dKdm*dmdz/S - K*z/(S2*S));
+}
+
+static double rebx_dsg_sigma(struct rebx_extras* const rebx, const struct rebx_dsg_shape* const shape, const double R){
+    if (shape->profile == NULL){
+        return pow(R, shape->alpha);
+    }
+    const struct rebx_interpolator* const profile = shape->profile;
+    double Rc = R;
+    Rc = (Rc < profile->times[0]) ? profile->times[0] : Rc;
+    Rc = (Rc > profile->times[profile->Nvalues-1]) ? profile->times[profile->Nvalues-1] : Rc;
+    return rebx_interpolate(rebx, shape->profile, Rc);
+}
+
+// Tabulates the disk's acceleration for shape. Returns 0 (leaving the previous table in place) if memory could not be allocated.
+static int rebx_dsg_build(struct rebx_extras* const rebx, struct rebx_dsg_table* const table, const struct rebx_dsg_shape* const shape, const double t){
+    const int Nr = shape->Nr;
+    const int Nz = shape->Nz;
+    const int Nrings = shape->Nrings;
+    const double dr = shape->rmax/(Nr-1);
+    const double dz = shape->zmax/(Nz-1);
+    double* const table_aR = rebx_malloc(rebx, (size_t)Nr*Nz*sizeof(*table_aR));
+    double* const table_az = rebx_malloc(rebx, (size_t)Nr*Nz*sizeof(*table_az));
+    // ring radii and masses per unit sigma0 (midpoint rule in R)
+    double* const ring_a = rebx_malloc(rebx, Nrings*sizeof(*ring_a));
+    double* const ring_m = rebx_malloc(rebx, Nrings*sizeof(*ring_m));
+    if (table_aR == NULL || table_az == NULL || ring_a == NULL || ring_m == NULL){
+        free(table_aR);
+        free(table_az);
+        free(ring_a);
+        free(ring_m);
+        return 0;
+    }
+    const double da = (shape->rout - shape->rin)/Nrings;
+    double mass = 0.;
+    for (int k=0; k<Nrings; k++){
+        ring_a[k] = shape->rin + (k+0.5)*da;
+        ring_m[k] = 2.*M_PI*ring_a[k]*da*rebx_dsg_sigma(rebx, shape, ring_a[k]);
+        mass += ring_m[k];
+    }
+
+    const double eps2 = shape->softening*shape->softening;
+#pragma omp parallel for
+    for (int j=0; j<Nz; j++){
+        const double z = j*dz;
+        for (int i=0; i<Nr; i++){
+            const double R = i*dr;
+            double aR = 0.;
+            double az = 0.;
+            for (int k=0; k<Nrings; k++){
+                double aRk, azk;
+                rebx_dsg_ring(ring_a[k], R, z, eps2, &aRk, &azk);
+                aR += ring_m[k]*aRk;
+                az += ring_m[k]*azk;
+            }
+            table_aR[j*Nr + i] = aR;
+            table_az[j*Nr + i] = az;
+        }
+    }
+    free(ring_a);
+    free(ring_m);
+
+    free(table->aR);
+    free(table->az);
+    table->shape = *shape;
+    table->dr = dr;
+    table->dz = dz;
+    table->aR = table_aR;
+    table->az = table_az;
+    table->mass = mass;
+    table->t_built = t;
+    return 1;
+}
+
+static void rebx_dsg_free_arrays(struct rebx_extras* const rebx, struct rebx_force* const force){
+    struct rebx_dsg_table* const table = rebx_get_param(rebx, force->ap, "dsg_table");
+    if (table){
+        free(table->aR);
+        free(table->az);
+        free(table);
+    }
+}
+
+static int rebx_dsg_shape_changed(const struct rebx_dsg_shape* const a, const struct rebx_dsg_shape* const b){
+    return a->rin != b->rin || a->rout != b->rout || a->alpha != b->alpha || a->profile != b->profile || a->softening != b->softening
+        || a->rmax != b->rmax || a->zmax != b->zmax || a->Nr != b->Nr || a->Nz != b->Nz || a->Nrings != b->Nrings;
+}
+
+static struct rebx_dsg_table* rebx_dsg_get_table(struct reb_simulation* const sim, struct rebx_force* const force){
+    struct rebx_extras* const rebx = sim->extras;
+    const double* const rin = rebx_get_param(rebx, force->ap, "dsg_rin");
+    const double* const rout = rebx_get_param(rebx, force->ap, "dsg_rout");
+    if (rin == NULL || rout == NULL || *rout <= *rin || *rin < 0.){
+        reb_simulation_error(sim, "REBOUNDx Error: disk_self_gravity needs dsg_rout > dsg_rin >= 0.\n");
+        return NULL;
+    }
+    const double* const alpha = rebx_get_param(rebx, force->ap, "dsg_alpha");
+    const double* const softening = rebx_get_param(rebx, force->ap, "dsg_softening");
+    const double* const rmax = rebx_get_param(rebx, force->ap, "dsg_rmax");
+    const double* const zmax = rebx_get_param(rebx, force->ap, "dsg_zmax");
+    const int* const Nr = rebx_get_param(rebx, force->ap, "dsg_Nr");
+    const int* const Nz = rebx_get_param(rebx, force->ap, "dsg_Nz");
+    const int* const Nrings = rebx_get_param(rebx, force->ap, "dsg_Nrings");
+    struct rebx_dsg_shape shape = {
+        .rin = *rin,
+        .rout = *rout,
+        .alpha = alpha ? *alpha : 0.,
+        .profile = rebx_get_param(rebx, force->ap, "dsg_profile"),
+        .rmax = rmax ? *rmax : 3.*(*rout),
+        .zmax = zmax ? *zmax : 3.*(*rout),
+        .Nr = Nr ? *Nr : 256,
+        .Nz = Nz ? *Nz : 128,
+        .Nrings = Nrings ? *Nrings : 256,
+    };
+    if (shape.Nr < 2 || shape.Nz < 2 || shape.Nrings < 1){
+        reb_simulation_error(sim, "REBOUNDx Error: disk_self_gravity needs dsg_Nr and dsg_Nz of at least 2 and dsg_Nrings of at least 1.\n");
+        return NULL;
+    }
+    if (softening){
+        shape.softening = *softening;
+    }
+    else{
+        const double dr = shape.rmax/(shape.Nr-1);
+        const double da = (shape.rout - shape.rin)/shape.Nrings;
+        shape.softening = (dr > da) ? dr : da;
+    }
+
+    struct rebx_dsg_table* table = rebx_get_param(rebx, force->ap, "dsg_table");
+    if (table == NULL){
+        table = calloc(1, sizeof(*table));
+        if (table == NULL){
+            reb_simulation_error(sim, "REBOUNDx Error: Could not allocate memory for disk_self_gravity table.\n");
+            return NULL;
+        }
+        rebx_set_param_pointer(rebx, &force->ap, "dsg_table", table);
+        rebx_set_param_pointer(rebx, &force->ap, "free_arrays", rebx_dsg_free_arrays);
+    }
+    if (table->aR == NULL){ // never built, or the first build failed
+        return rebx_dsg_build(rebx, table, &shape, sim->t) ? table : NULL;
+    }
+    const double* const refresh = rebx_get_param(rebx, force->ap, "dsg_refresh");
+    const int due = (refresh == NULL) || (fabs(sim->t - table->t_built) >= *refresh);
+    if (due && (refresh != NULL || rebx_dsg_shape_changed(&shape, &table->shape))){
+        if (!rebx_dsg_build(rebx, table, &shape, sim->t)){
+            return NULL;
+        }
+    }
+    return table;
+}
+
+void rebx_disk_self_gravity(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N){
+    struct rebx_extras* const rebx = sim->extras;
+    const double* const sigma0 = rebx_get_param(rebx, force->ap, "dsg_sigma0");
+    if (sigma0 == NULL){
+        reb_simulation_error(sim, "REBOUNDx Error: Need to set dsg_sigma0 for disk_self_gravity.\n");
+        return;
+    }
+    const struct rebx_dsg_table* const table = rebx_dsg_get_table(sim, force);
+    if (table == NULL){
+        return;
+    }
+    const double Gsigma0 = sim->G*(*sigma0);
+    const int Nr = table->shape.Nr;
+    const int Nz = table->shape.Nz;
+    const double inv_dr = 1./table->dr;
+    const double inv_dz = 1./table->dz;
+    const struct reb_particle primary = particles[0];
+#pragma omp parallel for schedule(guided, rebx->tuning.omp_chunk) if(N >= rebx->tuning.omp_threshold)
+    for (int i=1; i<N; i++){
+        const double dx = particles[i].x - primary.x;
+        const double dy = particles[i].y - primary.y;
+        const double dz = particles[i].z - primary.z;
+        const double R = sqrt(dx*dx + dy*dy);
+        const double u = R*inv_dr;
+        const double w = fabs(dz)*inv_dz;
+        const int iR = (int)u;
+        const int iz = (int)w;
+        if (iR >= Nr-1 || iz >= Nz-1){
+            // outside the table, the disk acts as a point mass
+            const double r2 = dx*dx + dy*dy + dz*dz;
+            const double prefac = -Gsigma0*table->mass/(r2*sqrt(r2));
+            particles[i].ax += prefac*dx;
+            particles[i].ay += prefac*dy;
+            particles[i].az += prefac*dz;
+            continue;
+        }
+        const double fR = u - iR;
+        const double fz = w - iz;
+        const int n = iz*Nr + iR;
+        const double c00 = (1.-fR)*(1.-fz);
+        const double c10 = fR*(1.-fz);
+        const double c01 = (1.-fR)*fz;
+        const double c11 = fR*fz;
+        const double aR = Gsigma0*(c00*table->aR[n] + c10*table->aR[n+1] + c01*table->aR[n+Nr] + c11*table->aR[n+Nr+1]);
+        const double az = Gsigma0*(c00*table->az[n] + c10*table->az[n+1] + c01*table->az[n+Nr] + c11*table->az[n+Nr+1]);
+        if (R > 0.){
+            particles[i].ax += aR*dx/R;
+            particles[i].ay += aR*dy/R;
+        }
+        particles[i].az += (dz > 0.) ? az : ((dz < 0.) ? -az : 0.); // table is for z >= 0, and the field is odd in z
+    }
+}
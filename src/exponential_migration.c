@@ -110,3 +110,13 @@ void rebx_exponential_migration(struct reb_simulation* const sim, struct rebx_fo
     const char* reference_name = "primary";
     rebx_com_force(sim, force, coordinates, back_reactions_inclusive, reference_name, rebx_calculate_modify_orbits_forces_new, particles, N);
 }
+
+void rebx_exponential_migration_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N_active, const int N){
+    int* ptr = rebx_get_param(sim->extras, force->ap, "coordinates");
+    enum REBX_COORDINATES coordinates = REBX_COORDINATES_JACOBI; // Default
+    if (ptr != NULL){
+        coordinates = *ptr;
+    }
+    const char* reference_name = "primary";
+    rebx_com_force_testparticles(sim, force, coordinates, reference_name, rebx_calculate_modify_orbits_forces_new, particles, N_active, N);
+}
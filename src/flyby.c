@@ -0,0 +1,214 @@
+/**
+ * @file    flyby.c
+ * @brief   Velocity kicks from passing stars in the impulse approximation
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * The section after the dollar signs gets built into the documentation by a script.  All lines must start with space * space like below.
+ * Tables always must be preceded and followed by a blank line.  See http://docutils.sourceforge.net/docs/user/rst/quickstart.html for a primer on rst.
+ * $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
+ *
+ * $Stellar Flybys$       // Effect category (must be the first non-blank line after dollar signs and between dollar signs to be detected by script).
+ *
+ * ======================= ===============================================
+ * Authors                 D. Tamayo
+ * Implementation Paper    None
+ * Based on                `Rickman 1976 <https://ui.adsabs.harvard.edu/abs/1976BAICz..27...92R/abstract>`_, `Heggie and Rasio 1996 <https://ui.adsabs.harvard.edu/abs/1996MNRAS.282.1064H/abstract>`_.
+ * C Example               None
+ * Python Example          None
+ * ======================= ===============================================
+ *
+ * Applies the velocity kicks from a schedule of passing stars, without adding them to the simulation.
+ * Each encounter is added with rebx_flyby_add (Extras.flyby_add in Python), giving the time of closest approach, the star's mass,
+ * its position at closest approach (the impact vector) and its (constant) velocity, both relative to the simulation's center of mass.
+ * Any component of the impact vector along the velocity is ignored.
+ *
+ * Each encounter is applied once, in the first operator step at or after its time, so the operator costs nothing between encounters
+ * and should typically be added after the timestep (it's exact in the limit of passages much faster than the orbital motion).
+ * By default, each body gets the kick from a straight-line passage, 2GM/(Vd) toward the star's closest approach point at distance d from the body,
+ * with the exact hyperbolic two-body deflection factor so that very close passages don't give divergent kicks.
+ * This kicks the whole system, so it moves the center of mass.
+ * If flyby_tidal is set to 1, the kicks are instead expanded to first order in the bodies' distances from the center of mass relative to the impact parameter
+ * (the distant-tidal approximation), which removes the common kick and leaves the center of mass in place.
+ * Encounters are only applied when integrating forward in time.
+ *
+ * **Effect Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * flyby_tidal (int)            No          If 1, uses the distant-tidal form of the kicks. Defaults to 0.
+ * ============================ =========== ==================================================================
+ *
+ * **Particle Parameters**
+ *
+ * *None*
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+
+struct rebx_flyby{
+    double t;
+    double m;
+    struct reb_vec3d b;     // impact vector (perpendicular to v)
+    struct reb_vec3d v;
+};
+
+struct rebx_flyby_state{
+    int N;                      // Number of scheduled encounters, sorted by time
+    int N_allocated;
+    int next;                   // First encounter not yet applied
+    struct rebx_flyby* flybys;
+};
+
+static void rebx_flyby_free_arrays(struct rebx_extras* rebx, struct rebx_operator* operator){
+    struct rebx_flyby_state* state = rebx_get_param(rebx, operator->ap, "flyby_state");
+    if (state == NULL){
+        return;
+    }
+    free(state->flybys);
+    free(state);
+}
+
+static struct rebx_flyby_state* rebx_flyby_get_state(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_flyby_state* state = rebx_get_param(rebx, operator->ap, "flyby_state");
+    if (state == NULL){
+        state = calloc(1, sizeof(*state));
+        if (state == NULL){
+            rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for flyby schedule.\n");
+            return NULL;
+        }
+        rebx_set_param_pointer(rebx, &operator->ap, "flyby_state", state);
+        rebx_set_param_pointer(rebx, &operator->ap, "free_arrays", rebx_flyby_free_arrays);
+    }
+    return state;
+}
+
+int rebx_flyby_add(struct rebx_extras* const rebx, struct rebx_operator* const operator, const double t, const double m, const struct reb_vec3d b, const struct reb_vec3d v){
+    if (rebx->sim == NULL){
+        rebx_error(rebx, ""); // rebx_error gives meaningful err
+        return -1;
+    }
+    const double v2 = v.x*v.x + v.y*v.y + v.z*v.z;
+    if (v2 == 0.){
+        rebx_error(rebx, "REBOUNDx Error: Flyby velocity must be nonzero.\n");
+        return -1;
+    }
+    if (t < rebx->sim->t){
+        rebx_error(rebx, "REBOUNDx Error: Flyby time of closest approach has already passed.\n");
+        return -1;
+    }
+    struct rebx_flyby_state* const state = rebx_flyby_get_state(rebx, operator);
+    if (state == NULL){
+        return -1;
+    }
+    // insert sorted by time (schedules are typically added in order, so this is usually an append).
+    // Applied encounters all have t <= sim->t, so this never moves in front of them.
+    int i = state->N;
+    while (i > state->next && state->flybys[i-1].t > t){
+        i--;
+    }
+    if (state->N == state->N_allocated){
+        const int N_allocated = state->N_allocated ? 2*state->N_allocated : 16;
+        struct rebx_flyby* const flybys = realloc(state->flybys, N_allocated*sizeof(*flybys));
+        if (flybys == NULL){
+            rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for flyby schedule.\n");
+            return -1;
+        }
+        state->flybys = flybys;
+        state->N_allocated = N_allocated;
+    }
+    for (int j=state->N; j>i; j--){
+        state->flybys[j] = state->flybys[j-1];
+    }
+    struct rebx_flyby* const flyby = &state->flybys[i];
+    flyby->t = t;
+    flyby->m = m;
+    flyby->v = v;
+    const double bdotv = b.x*v.x + b.y*v.y + b.z*v.z;
+    flyby->b.x = b.x - bdotv*v.x/v2;
+    flyby->b.y = b.y - bdotv*v.y/v2;
+    flyby->b.z = b.z - bdotv*v.z/v2;
+    state->N++;
+    return i;
+}
+
+int rebx_flyby_N_applied(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    const struct rebx_flyby_state* const state = rebx_get_param(rebx, operator->ap, "flyby_state");
+    return (state == NULL) ? 0 : state->next;
+}
+
+static void rebx_flyby_apply(struct reb_simulation* const sim, const struct rebx_flyby* const flyby, const int tidal){
+    struct reb_particle* const particles = sim->particles;
+    const int N_real = sim->N - sim->N_var;
+    const struct reb_particle com = reb_simulation_com(sim);
+    const double GM = sim->G*flyby->m;
+    const double V = sqrt(flyby->v.x*flyby->v.x + flyby->v.y*flyby->v.y + flyby->v.z*flyby->v.z);
+    const double vhat[3] = {flyby->v.x/V, flyby->v.y/V, flyby->v.z/V};
+    const double b[3] = {flyby->b.x, flyby->b.y, flyby->b.z};
+    const double b2 = b[0]*b[0] + b[1]*b[1] + b[2]*b[2];
+    for (int i=0; i<N_real; i++){
+        const double r[3] = {particles[i].x - com.x, particles[i].y - com.y, particles[i].z - com.z};
+        double dv[3];
+        if (tidal){
+            // 2GM/(V b^2)*(2(bhat.r_perp)bhat - r_perp), with r_perp the position perpendicular to the star's path
+            const double rdotv = r[0]*vhat[0] + r[1]*vhat[1] + r[2]*vhat[2];
+            const double rperp[3] = {r[0] - rdotv*vhat[0], r[1] - rdotv*vhat[1], r[2] - rdotv*vhat[2]};
+            const double bdotr = b[0]*rperp[0] + b[1]*rperp[1] + b[2]*rperp[2];
+            const double prefac = 2.*GM/(V*b2);
+            for (int k=0; k<3; k++){
+                dv[k] = prefac*(2.*bdotr*b[k]/b2 - rperp[k]);
+            }
+        }
+        else{
+            // s is the separation from the body to the star at closest approach, perpendicular to the star's path
+            const double s0[3] = {b[0] - r[0], b[1] - r[1], b[2] - r[2]};
+            const double sdotv = s0[0]*vhat[0] + s0[1]*vhat[1] + s0[2]*vhat[2];
+            const double s[3] = {s0[0] - sdotv*vhat[0], s0[1] - sdotv*vhat[1], s0[2] - sdotv*vhat[2]};
+            const double d2 = s[0]*s[0] + s[1]*s[1] + s[2]*s[2];
+            // hyperbolic deflection by angle theta with tan(theta/2) = x: V*sin(theta) toward the star's path, V*(1-cos(theta)) along its velocity
+            const double x = GM/(sqrt(d2)*V*V);
+            const double corr = 1./(1.+x*x);
+            for (int k=0; k<3; k++){
+                dv[k] = 2.*GM/(V*d2)*corr*s[k] + 2.*V*x*x*corr*vhat[k];
+            }
+        }
+        particles[i].vx += dv[0];
+        particles[i].vy += dv[1];
+        particles[i].vz += dv[2];
+    }
+}
+
+void rebx_flyby(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
+    struct rebx_flyby_state* const state = rebx_get_param(sim->extras, operator->ap, "flyby_state");
+    if (state == NULL || dt < 0.){
+        return;
+    }
+    const int* const tidal = rebx_get_param(sim->extras, operator->ap, "flyby_tidal");
+    while (state->next < state->N && state->flybys[state->next].t <= sim->t){
+        rebx_flyby_apply(sim, &state->flybys[state->next], tidal != NULL && *tidal);
+        state->next++;
+    }
+}
@@ -0,0 +1,202 @@
+/**
+ * @file    gas_drag.c
+ * @brief   Aerodynamic drag on small solids (pebbles) from a power-law gas disk
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * The section after the dollar signs gets built into the documentation by a script.  All lines must start with space * space like below.
+ * Tables always must be preceded and followed by a blank line.  See http://docutils.sourceforge.net/docs/user/rst/quickstart.html for a primer on rst.
+ * $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
+ *
+ * $Gas Effects$       // Effect category (must be the first non-blank line after dollar signs and between dollar signs to be detected by script).
+ *
+ * ======================= ===============================================
+ * Authors                 D. Tamayo
+ * Implementation Paper    None
+ * Based on                `Weidenschilling 1977 <https://ui.adsabs.harvard.edu/abs/1977MNRAS.180...57W/abstract>`_.
+ * C Example               None
+ * Python Example          None
+ * ======================= ===============================================
+ *
+ * Adds aerodynamic drag on particles with gd_s and gd_rho_s set, relaxing their velocities toward the local gas velocity on the stopping time t_s, a = -(v - v_gas)/t_s.
+ * The gas orbits the primary (particles[0]) in its midplane (z=0), with midplane density gd_rhog*r^gd_alpha_rhog and sound speed gd_cs*r^gd_alpha_cs in cylindrical radius r.
+ * The density falls off vertically as a Gaussian with scale height H = c_s/Omega_K, and the gas is sub-Keplerian due to its pressure gradient, v_gas^2 = v_K^2 + (gd_alpha_rhog + 2*gd_alpha_cs)*c_s^2.
+ * Particles are in the Epstein regime, t_s = rho_s*s/(rho_g*v_th) with v_th = sqrt(8/pi)*c_s, unless gd_mfp is set and the particle radius exceeds 9/4 of the local mean free path,
+ * in which case the (low Reynolds number) Stokes stopping time 4*s/(9*lambda) times longer is used. The mean free path scales inversely with the gas density, and equals gd_mfp where the density is gd_rhog.
+ * There is no back-reaction on the gas or the primary.
+ *
+ * Since t_s is often much shorter than an orbital period for pebbles, adding this as a force limits the timestep to a fraction of the stopping time.
+ * The gas_drag_exact operator instead applies the drag as an exact exponential relaxation toward the gas velocity over each operator step, so it can be combined with, e.g., WHFast at timesteps set by the orbital dynamics.
+ * It reads the same parameters as this effect (set on the operator rather than on a force).
+ *
+ * **Effect Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * gd_rhog (double)             Yes         Normalization of the midplane gas density, rho_g = gd_rhog*r^gd_alpha_rhog
+ * gd_alpha_rhog (double)       Yes         Power-law slope of the midplane gas density
+ * gd_cs (double)               Yes         Normalization of the sound speed, c_s = gd_cs*r^gd_alpha_cs
+ * gd_alpha_cs (double)         Yes         Power-law slope of the sound speed
+ * gd_mfp (double)              No          Mean free path where the gas density equals gd_rhog. If not set, all particles are in the Epstein regime
+ * ============================ =========== ==================================================================
+ *
+ * **Particle Parameters**
+ *
+ * Only particles with both parameters set feel gas drag.
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * gd_s (double)                Yes         Particle radius entering the stopping time
+ * gd_rho_s (double)            Yes         Particle internal (material) density
+ * ============================ =========== ==================================================================
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+#include "core.h"
+
+int rebx_gas_drag_load_disk(struct reb_simulation* const sim, struct rebx_node* const ap, struct rebx_gas_drag_disk* const disk){
+    struct rebx_extras* const rebx = sim->extras;
+    const double* const rhog = rebx_get_param(rebx, ap, "gd_rhog");
+    const double* const alpha_rhog = rebx_get_param(rebx, ap, "gd_alpha_rhog");
+    const double* const cs = rebx_get_param(rebx, ap, "gd_cs");
+    const double* const alpha_cs = rebx_get_param(rebx, ap, "gd_alpha_cs");
+    if (rhog == NULL || alpha_rhog == NULL || cs == NULL || alpha_cs == NULL){
+        reb_simulation_error(sim, "REBOUNDx Error: Need to set gd_rhog, gd_alpha_rhog, gd_cs and gd_alpha_cs for gas drag.\n");
+        return 0;
+    }
+    const double* const mfp = rebx_get_param(rebx, ap, "gd_mfp");
+    disk->rhog = *rhog;
+    disk->alpha_rhog = *alpha_rhog;
+    disk->cs = *cs;
+    disk->alpha_cs = *alpha_cs;
+    disk->mfp = (mfp == NULL) ? 0. : *mfp;
+    return 1;
+}
+
+int rebx_gas_drag_load_pebbles(struct reb_simulation* const sim, struct reb_particle* const particles, const int N, const struct rebx_gas_drag_disk* const disk, struct rebx_gas_drag_pebbles* const pebbles){
+    struct rebx_extras* const rebx = sim->extras;
+    *pebbles = (struct rebx_gas_drag_pebbles){0};
+    if (N < 2){
+        return 0;
+    }
+    // Gather the pebbles' params and phase-space coordinates (relative to the primary) into contiguous arrays,
+    // so that the stopping time and gas velocity are evaluated in a single branch-free loop that the compiler can vectorize
+    int* const index = rebx_malloc(rebx, (N-1)*sizeof(*index));
+    double* const buf = rebx_malloc(rebx, 8*(N-1)*sizeof(*buf));
+    if (index == NULL || buf == NULL){
+        free(index);
+        free(buf);
+        return 0;
+    }
+    double* const s = buf;
+    double* const rho_s = buf + (N-1);
+    double* const x = buf + 2*(N-1);
+    double* const y = buf + 3*(N-1);
+    double* const z = buf + 4*(N-1);
+    double* const dvx = buf + 5*(N-1);
+    double* const dvy = buf + 6*(N-1);
+    double* const dvz = buf + 7*(N-1);
+    const struct reb_particle primary = particles[0];
+    int n = 0;
+    for (int i=1; i<N; i++){
+        const double* const s_i = rebx_get_param(rebx, particles[i].ap, "gd_s");
+        const double* const rho_s_i = rebx_get_param(rebx, particles[i].ap, "gd_rho_s");
+        if (s_i == NULL || rho_s_i == NULL){
+            continue;
+        }
+        index[n] = i;
+        s[n] = *s_i;
+        rho_s[n] = *rho_s_i;
+        x[n] = particles[i].x - primary.x;
+        y[n] = particles[i].y - primary.y;
+        z[n] = particles[i].z - primary.z;
+        dvx[n] = particles[i].vx - primary.vx;
+        dvy[n] = particles[i].vy - primary.vy;
+        dvz[n] = particles[i].vz - primary.vz;
+        n++;
+    }
+    if (n == 0){
+        free(index);
+        free(buf);
+        return 0;
+    }
+
+    const double GM = sim->G*primary.m;
+    const double eta = disk->alpha_rhog + 2.*disk->alpha_cs;
+    const double vth_fac = sqrt(8./M_PI);   // v_th = vth_fac*c_s
+    const double stokes_fac = (disk->mfp > 0.) ? 4./(9.*disk->mfp*disk->rhog) : 0.; // 4*s/(9*lambda) = stokes_fac*s*rho_g
+#pragma omp simd
+    for (int k=0; k<n; k++){
+        const double r2 = x[k]*x[k] + y[k]*y[k];
+        const double r = sqrt(r2);
+        const double logr = log(r);
+        const double vK2 = GM/r;
+        const double cs = disk->cs*exp(disk->alpha_cs*logr);
+        const double H2 = cs*cs*r2/vK2;     // (c_s/Omega_K)^2
+        const double rhog = disk->rhog*exp(disk->alpha_rhog*logr - z[k]*z[k]/(2.*H2));
+        const double vphi = sqrt(fmax(vK2 + eta*cs*cs, 0.));
+        // velocity relative to the gas, overwriting the velocity relative to the primary
+        dvx[k] += vphi*y[k]/r;
+        dvy[k] -= vphi*x[k]/r;
+        // Epstein stopping time, lengthened by 4s/(9 lambda) in the Stokes regime. Stored in place of s (infinite if there is no gas).
+        const double ts_epstein = rho_s[k]*s[k]/(rhog*vth_fac*cs);
+        s[k] = ts_epstein*fmax(1., stokes_fac*s[k]*rhog);
+    }
+    pebbles->N = n;
+    pebbles->index = index;
+    pebbles->buf = buf;
+    pebbles->ts = s;
+    pebbles->dvx = dvx;
+    pebbles->dvy = dvy;
+    pebbles->dvz = dvz;
+    return n;
+}
+
+void rebx_gas_drag_free_pebbles(struct rebx_gas_drag_pebbles* const pebbles){
+    free(pebbles->index);
+    free(pebbles->buf);
+    *pebbles = (struct rebx_gas_drag_pebbles){0};
+}
+
+void rebx_gas_drag(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N){
+    struct rebx_gas_drag_disk disk;
+    if (!rebx_gas_drag_load_disk(sim, force->ap, &disk)){
+        return;
+    }
+    struct rebx_gas_drag_pebbles pebbles;
+    if (!rebx_gas_drag_load_pebbles(sim, particles, N, &disk, &pebbles)){
+        return;
+    }
+    for (int k=0; k<pebbles.N; k++){
+        const double inv_ts = 1./pebbles.ts[k];
+        struct reb_particle* const p = &particles[pebbles.index[k]];
+        p->ax -= pebbles.dvx[k]*inv_ts;
+        p->ay -= pebbles.dvy[k]*inv_ts;
+        p->az -= pebbles.dvz[k]*inv_ts;
+    }
+    rebx_gas_drag_free_pebbles(&pebbles);
+}
@@ -0,0 +1,106 @@
+/**
+ * @file    gas_drag_exact.c
+ * @brief   Operator applying aerodynamic gas drag exactly over a timestep
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * The section after the dollar signs gets built into the documentation by a script.  All lines must start with space * space like below.
+ * Tables always must be preceded and followed by a blank line.  See http://docutils.sourceforge.net/docs/user/rst/quickstart.html for a primer on rst.
+ * $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
+ *
+ * $Gas Effects$       // Effect category (must be the first non-blank line after dollar signs and between dollar signs to be detected by script).
+ *
+ * ======================= ===============================================
+ * Authors                 D. Tamayo
+ * Implementation Paper    None
+ * Based on                `Weidenschilling 1977 <https://ui.adsabs.harvard.edu/abs/1977MNRAS.180...57W/abstract>`_.
+ * C Example               None
+ * Python Example          None
+ * ======================= ===============================================
+ *
+ * This is the operator counterpart of gas_drag, for pebbles whose stopping times are much shorter than the timestep.
+ * Over each operator step, it holds positions, the stopping time and the gas velocity fixed, and integrates the drag exactly,
+ * v -> v_gas + (v - v_gas)*exp(-dt/t_s), so the velocity relaxes to the gas velocity rather than overshooting for dt > t_s.
+ * Both drag regimes are linear in the velocity relative to the gas, so this is the exact solution for the frozen gas state.
+ * The error therefore comes from the splitting with the orbital motion, and the timestep only needs to resolve the orbits.
+ * The gas disk and the particle parameters are the same as in gas_drag, and the effect parameters are set on the operator.
+ *
+ * **Effect Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * gd_rhog (double)             Yes         Normalization of the midplane gas density, rho_g = gd_rhog*r^gd_alpha_rhog
+ * gd_alpha_rhog (double)       Yes         Power-law slope of the midplane gas density
+ * gd_cs (double)               Yes         Normalization of the sound speed, c_s = gd_cs*r^gd_alpha_cs
+ * gd_alpha_cs (double)         Yes         Power-law slope of the sound speed
+ * gd_mfp (double)              No          Mean free path where the gas density equals gd_rhog. If not set, all particles are in the Epstein regime
+ * ============================ =========== ==================================================================
+ *
+ * **Particle Parameters**
+ *
+ * Only particles with both parameters set feel gas drag.
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * gd_s (double)                Yes         Particle radius entering the stopping time
+ * gd_rho_s (double)            Yes         Particle internal (material) density
+ * ============================ =========== ==================================================================
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+#include "core.h"
+
+void rebx_gas_drag_exact(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
+    struct rebx_gas_drag_disk disk;
+    if (!rebx_gas_drag_load_disk(sim, operator->ap, &disk)){
+        return;
+    }
+    struct reb_particle* const particles = sim->particles;
+    struct rebx_gas_drag_pebbles pebbles;
+    if (!rebx_gas_drag_load_pebbles(sim, particles, sim->N - sim->N_var, &disk, &pebbles)){
+        return;
+    }
+    double* const dvx = pebbles.dvx;
+    double* const dvy = pebbles.dvy;
+    double* const dvz = pebbles.dvz;
+    const double* const ts = pebbles.ts;
+    // change in velocity, (v_gas - v)*(1 - exp(-dt/t_s)), overwriting the velocity relative to the gas
+#pragma omp simd
+    for (int k=0; k<pebbles.N; k++){
+        const double f = expm1(-dt/ts[k]);
+        dvx[k] *= f;
+        dvy[k] *= f;
+        dvz[k] *= f;
+    }
+    for (int k=0; k<pebbles.N; k++){
+        struct reb_particle* const p = &particles[pebbles.index[k]];
+        p->vx += dvx[k];
+        p->vy += dvy[k];
+        p->vz += dvz[k];
+    }
+    rebx_gas_drag_free_pebbles(&pebbles);
+}
@@ -100,12 +100,12 @@ static void get_vrel_disk(const struct reb_particle p, const double GMBH, double
 
 }
 
-static void rebx_calculate_gas_dynamical_friction(struct reb_simulation* const sim, struct reb_particle* const particles,\
+static void rebx_calculate_gas_dynamical_friction(struct reb_simulation* const sim, const struct rebx_tuning* const tuning, struct reb_particle* const particles,\
     const int N, const double rhog, const double alpha_rhog, const double cs, const double alpha_cs, const double xmin, const double hr, const double Qd){
 
     const int _N_real = sim->N - sim->N_var;
     const struct reb_particle bh = particles[0];
-#pragma omp parallel for
+#pragma omp parallel for schedule(guided, tuning->omp_chunk) if(_N_real >= tuning->omp_threshold)
     for (int i=1;i<_N_real;i++){
         const struct reb_particle p = particles[i];
         struct reb_particle diff = p;
@@ -169,7 +169,7 @@ void rebx_gas_dynamical_friction(struct reb_simulation* const sim, struct rebx_f
         reb_simulation_error(sim, "Need to specify Qd");
     }
 
-    rebx_calculate_gas_dynamical_friction(sim, particles, N, *rhog, *alpha_rhog, *cs, *alpha_cs, *xmin, *hr, *Qd);
+    rebx_calculate_gas_dynamical_friction(sim, &rebx->tuning, particles, N, *rhog, *alpha_rhog, *cs, *alpha_cs, *xmin, *hr, *Qd);
 
 }
 
@@ -60,9 +60,13 @@
 #include "rebound.h"
 #include "reboundx.h"
 #include "rebxtools.h"
+#include "core.h"
 
 static void rebx_calculate_gr(struct reb_simulation* const sim, struct reb_particle* const particles, const int N, const double C2, const double G, const int max_iterations){
-    
+    const struct reb_particle* const ps_j_posvel = rebx_jacobi_particles(sim->extras, particles, N);
+    if (ps_j_posvel == NULL){
+        return;
+    }
     struct reb_particle* const ps = malloc(N*sizeof(*ps));
     struct reb_particle* const ps_j = malloc(N*sizeof(*ps_j));
     memcpy(ps, particles, N*sizeof(*ps));
@@ -96,7 +100,8 @@ static void rebx_calculate_gr(struct reb_simulation* const sim, struct reb_parti
     // Transform to Jacobi coordinates
     const struct reb_particle source = ps[0];
 	const double mu = G*source.m;
-    reb_particles_transform_inertial_to_jacobi_posvelacc(ps, ps_j, ps, N, N);
+    memcpy(ps_j, ps_j_posvel, N*sizeof(*ps_j)); // Jacobi positions and velocities are shared with other effects, so only transform accelerations
+    reb_particles_transform_inertial_to_jacobi_acc(ps, ps_j, ps, N, N);
     
     for (int i=1; i<N; i++){
         struct reb_particle p = ps_j[i];
@@ -127,7 +132,7 @@ static void rebx_calculate_gr(struct reb_simulation* const sim, struct reb_parti
         }
         const int default_max_iterations = 10;
         if(q==default_max_iterations){
-            reb_simulation_warning(sim, "REBOUNDx Warning: 10 iterations in gr.c failed to converge. This is typically because the perturbation is too strong for the current implementation.");
+            rebx_diagnostic(sim->extras, REBX_DIAGNOSTIC_GR_NOT_CONVERGED);
         }
   
         const double B = (mu/ri - 1.5*vi2)*mu/(ri*ri*ri)/C2;
@@ -182,8 +187,13 @@ static double rebx_calculate_gr_hamiltonian(struct rebx_extras* const rebx, stru
     const int N = sim->N - sim->N_var;
     const double G = sim->G;
 
-    struct reb_particle* const ps_j = malloc(N*sizeof(*ps_j));
     struct reb_particle* const ps = sim->particles; 
+    rebx_invalidate_jacobi(rebx);   // called outside force evaluations, so particles may have changed since the cache was filled
+    const struct reb_particle* const ps_j = rebx_jacobi_particles(rebx, ps, N);
+    const double* const m_j = rebx_jacobi_masses(rebx, ps, N);
+    if (ps_j == NULL || m_j == NULL){
+        return 0.;
+    }
     // Calculate Newtonian potentials
 
     double V_newt = 0.;
@@ -200,12 +210,8 @@ static double rebx_calculate_gr_hamiltonian(struct rebx_extras* const rebx, stru
         }
     }
    
-    // Transform to Jacobi coordinates
     const struct reb_particle source = ps[0];
 	const double mu = G*source.m;
-    double* const m_j = malloc(N*sizeof(*m_j));
-    rebx_calculate_jacobi_masses(ps, m_j, N);
-    reb_particles_transform_inertial_to_jacobi_posvel(ps, ps_j, ps, N, N);
 
     double T = 0.5*m_j[0]*(ps_j[0].vx*ps_j[0].vx + ps_j[0].vy*ps_j[0].vy + ps_j[0].vz*ps_j[0].vz);
     double V_PN = 0.;
@@ -230,9 +236,6 @@ static double rebx_calculate_gr_hamiltonian(struct rebx_extras* const rebx, stru
     }
     V_PN /= C2;
     
-    free(ps_j);
-    free(m_j);
-    
 	return T + V_newt + V_PN;
 }
 
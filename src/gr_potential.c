@@ -39,6 +39,7 @@
  * It gets the precession right, but gets the mean motion wrong by :math:`\mathcal{O}(GM/ac^2)`.  
  * It's the fastest option, and because it's not velocity-dependent, it automatically keeps WHFast symplectic.  
  * Nice if you have a single-star system, don't need to get GR exactly right, and want speed.
+ * With MPI, the central body is taken to be the most massive particle across all ranks.
  * 
  * **Effect Parameters**
  * 
@@ -56,6 +57,7 @@
 #include <math.h>
 #include "rebound.h"
 #include "reboundx.h"
+#include "rebxtools.h"
 
 static void rebx_calculate_gr_potential(struct reb_particle* const particles, const int N, const double C2, const double G){
     const struct reb_particle source = particles[0];
@@ -77,14 +79,74 @@ static void rebx_calculate_gr_potential(struct reb_particle* const particles, co
     }
 }
 
+#ifdef MPI
+// The source (the most massive particle across ranks, rather than particles[0]) is broadcast to all ranks, and its back-reaction summed over ranks
+static void rebx_calculate_gr_potential_mpi(struct reb_simulation* const sim, struct reb_particle* const particles, const int N, const double C2, const double G){
+    struct reb_particle source;
+    const int source_index = rebx_mpi_primary(sim, particles, N, &source);
+    const double prefac1 = 6.*(G*source.m)*(G*source.m)/C2;
+    double back[3] = {0.};
+    for (int i=0; i<N; i++){
+        if (i == source_index){
+            continue;
+        }
+        const struct reb_particle p = particles[i];
+        const double dx = p.x - source.x;
+        const double dy = p.y - source.y;
+        const double dz = p.z - source.z;
+        const double r2 = dx*dx + dy*dy + dz*dz;
+        const double prefac = prefac1/(r2*r2);
+
+        particles[i].ax -= prefac*dx;
+        particles[i].ay -= prefac*dy;
+        particles[i].az -= prefac*dz;
+        back[0] += p.m/source.m*prefac*dx;
+        back[1] += p.m/source.m*prefac*dy;
+        back[2] += p.m/source.m*prefac*dz;
+    }
+    rebx_mpi_sum(back, 3);
+    if (source_index >= 0){
+        particles[source_index].ax += back[0];
+        particles[source_index].ay += back[1];
+        particles[source_index].az += back[2];
+    }
+}
+#endif // MPI
+
 void rebx_gr_potential(struct reb_simulation* const sim, struct rebx_force* const gr_potential, struct reb_particle* const particles, const int N){
     double* c = rebx_get_param(sim->extras, gr_potential->ap, "c");
     if (c == NULL){
         reb_simulation_error(sim, "REBOUNDx Error: Need to set speed of light in gr effect.  See examples in documentation.\n");
+        return;
     }
-    else{
-        const double C2 = (*c)*(*c);
-        rebx_calculate_gr_potential(particles, N, C2, sim->G);
+    const double C2 = (*c)*(*c);
+#ifdef MPI
+    if (sim->mpi_num > 1){
+        rebx_calculate_gr_potential_mpi(sim, particles, N, C2, sim->G);
+        return;
+    }
+#endif // MPI
+    rebx_calculate_gr_potential(particles, N, C2, sim->G);
+}
+
+void rebx_gr_potential_testparticles(struct reb_simulation* const sim, struct rebx_force* const gr_potential, struct reb_particle* const particles, const int N_active, const int N){
+    double* c = rebx_get_param(sim->extras, gr_potential->ap, "c");
+    if (c == NULL){
+        return; // already reported by rebx_gr_potential
+    }
+    const double C2 = (*c)*(*c);
+    const struct reb_particle source = particles[0];
+    const double prefac1 = 6.*(sim->G*source.m)*(sim->G*source.m)/C2;
+    for (int i=N_active; i<N; i++){
+        const double dx = particles[i].x - source.x;
+        const double dy = particles[i].y - source.y;
+        const double dz = particles[i].z - source.z;
+        const double r2 = dx*dx + dy*dy + dz*dz;
+        const double prefac = prefac1/(r2*r2);
+
+        particles[i].ax -= prefac*dx;
+        particles[i].ay -= prefac*dy;
+        particles[i].az -= prefac*dz;
     }
 }
 
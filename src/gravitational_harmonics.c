@@ -140,6 +140,44 @@ void rebx_gravitational_harmonics(struct reb_simulation* const sim, struct rebx_
     rebx_J4(sim->extras, sim, gh, particles, N);
 }
 
+// Test particles feel the harmonics of the active particles, without back-reactions
+static void rebx_calculate_harmonics_testparticles(struct reb_simulation* const sim, struct reb_particle* const particles, const int N_active, const int N, const double J2, const double J4, const double R_eq, const int source_index){
+    const struct reb_particle source = particles[source_index];
+    const double Gm = sim->G*source.m;
+    const double R_eq2 = R_eq*R_eq;
+    for (int i=N_active; i<N; i++){
+        const double dx = particles[i].x - source.x;
+        const double dy = particles[i].y - source.y;
+        const double dz = particles[i].z - source.z;
+        const double r2 = dx*dx + dy*dy + dz*dz;
+        const double r = sqrt(r2);
+        const double costheta2 = dz*dz/r2;
+        const double prefac2 = 3.*J2*R_eq2/r2/r2/r/2.;
+        const double fac2 = 5.*costheta2-1.;
+        const double prefac4 = 5.*J4*R_eq2*R_eq2/r2/r2/r2/r/8.;
+        const double fac4 = 63.*costheta2*costheta2-42.*costheta2 + 3.;
+
+        particles[i].ax += Gm*(prefac2*fac2 + prefac4*fac4)*dx;
+        particles[i].ay += Gm*(prefac2*fac2 + prefac4*fac4)*dy;
+        particles[i].az += Gm*(prefac2*(fac2-2.) + prefac4*(fac4+12.-28.*costheta2))*dz;
+    }
+}
+
+void rebx_gravitational_harmonics_testparticles(struct reb_simulation* const sim, struct rebx_force* const gh, struct reb_particle* const particles, const int N_active, const int N){
+    struct rebx_extras* const rebx = sim->extras;
+    for (int i=0; i<N_active; i++){
+        const double* const R_eq = rebx_get_param(rebx, particles[i].ap, "R_eq");
+        if (R_eq == NULL){
+            continue;
+        }
+        const double* const J2 = rebx_get_param(rebx, particles[i].ap, "J2");
+        const double* const J4 = rebx_get_param(rebx, particles[i].ap, "J4");
+        if (J2 != NULL || J4 != NULL){
+            rebx_calculate_harmonics_testparticles(sim, particles, N_active, N, J2 ? *J2 : 0., J4 ? *J4 : 0., *R_eq, i);
+        }
+    }
+}
+
 static double rebx_calculate_J2_potential(struct reb_simulation* const sim, const double J2, const double R_eq, const int source_index){
     const struct reb_particle* const particles = sim->particles;
 	const int _N_real = sim->N - sim->N_var;
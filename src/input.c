@@ -642,6 +642,35 @@ void rebx_init_extras_from_binary(struct rebx_extras* rebx, const char* const fi
     return;
 }
 
+void rebx_init_extras_from_stream(struct rebx_extras* rebx, const char* const buf, const size_t size, enum rebx_input_binary_messages* warnings){
+    if (rebx->sim == NULL){
+        rebx_error(rebx, ""); // rebx_error gives meaningful err
+        return;
+    }
+#ifdef _WIN32
+    // No fmemopen on Windows, so go through a temporary file
+    FILE* inf = tmpfile();
+    if (inf && fwrite(buf, 1, size, inf) != size){
+        fclose(inf);
+        inf = NULL;
+    }
+    if (inf){
+        rewind(inf);
+    }
+#else
+    FILE* inf = fmemopen((void*)buf, size, "rb");
+#endif // _WIN32
+    if (!inf){
+        *warnings |= REBX_INPUT_BINARY_ERROR_NOFILE;
+        return;
+    }
+
+    rebx_input_read_header(inf, warnings);
+    rebx_load_snapshot(rebx, inf, warnings);
+
+    fclose(inf);
+}
+
 struct rebx_extras* rebx_create_extras_from_binary(struct reb_simulation* sim, const char* const filename){
     if (sim == NULL){
         fprintf(stderr, "REBOUNDx Error: Simulation pointer passed to rebx_create_extras_from_binary was NULL.\n");
@@ -29,6 +29,7 @@
 #include <float.h>
 #include "rebound.h"
 #include "reboundx.h"
+#include "core.h"
 
 static void avg_particles(struct reb_particle* const ps_avg, struct reb_particle* const ps1, struct reb_particle* const ps2, int N){
     for(int i=0; i<N; i++){
@@ -100,7 +101,7 @@ void rebx_integrator_implicit_midpoint_integrate(struct reb_simulation* const si
     int n, converged;
     for(n=0;n<10;n++){
         memcpy(ps_prev, ps_final, N*sizeof(*ps_prev));
-        force->update_accelerations(sim, force, ps_avg, N);
+        rebx_update_accelerations(sim, force, ps_avg, N);
         for(int i=0; i<N; i++){
             ps_final[i].vx = ps_orig[i].vx + dt*ps_avg[i].ax;
             ps_final[i].vy = ps_orig[i].vy + dt*ps_avg[i].ay;
@@ -114,7 +115,7 @@ void rebx_integrator_implicit_midpoint_integrate(struct reb_simulation* const si
     }
     const int default_max_iterations = 10;
     if(n==default_max_iterations){
-        reb_simulation_warning(sim, "REBOUNDx: 10 iterations in integrator_implicit_midpoint.c failed to converge. This is typically because the perturbation is too strong for the current implementation.");
+        rebx_diagnostic(sim->extras, REBX_DIAGNOSTIC_IMPLICIT_MIDPOINT_NOT_CONVERGED);
     }
     for(int i=0; i<N; i++){
         sim->particles[i].vx = ps_final[i].vx;
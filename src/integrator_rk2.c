@@ -47,7 +47,7 @@ void rebx_integrator_rk2_integrate(struct reb_simulation* const sim, const doubl
     }
     memcpy(k2, sim->particles, N*sizeof(*k2));
 
-    force->update_accelerations(sim, force, sim->particles, N);
+    rebx_update_accelerations(sim, force, sim->particles, N);
     const double a21 = 2.*dt/3.;
     for(int i=0; i<N; i++){
         k2[i].vx = sim->particles[i].vx + a21*sim->particles[i].ax;
@@ -55,7 +55,7 @@ void rebx_integrator_rk2_integrate(struct reb_simulation* const sim, const doubl
         k2[i].vz = sim->particles[i].vz + a21*sim->particles[i].az;
     }
 
-    force->update_accelerations(sim, force, k2, N);
+    rebx_update_accelerations(sim, force, k2, N);
 
     const double b1 = dt/4.;
     const double b2 = 3.*dt/4.;
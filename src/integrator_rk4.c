@@ -55,21 +55,21 @@ void rebx_integrator_rk4_integrate(struct reb_simulation* const sim, const doubl
     memcpy(k3, sim->particles, N*sizeof(*k3));
     
     const double dt2 = dt/2.;
-    force->update_accelerations(sim, force, sim->particles, N);  // k1 = sim.particles.a
+    rebx_update_accelerations(sim, force, sim->particles, N);  // k1 = sim.particles.a
     
     for(int i=0; i<N; i++){
         k2[i].vx = sim->particles[i].vx + dt2*sim->particles[i].ax;
         k2[i].vy = sim->particles[i].vy + dt2*sim->particles[i].ay;
         k2[i].vz = sim->particles[i].vz + dt2*sim->particles[i].az;
     }
-    force->update_accelerations(sim, force, k2, N);
+    rebx_update_accelerations(sim, force, k2, N);
     
     for(int i=0; i<N; i++){
         k3[i].vx = sim->particles[i].vx + dt2*k2[i].ax;
         k3[i].vy = sim->particles[i].vy + dt2*k2[i].ay;
         k3[i].vz = sim->particles[i].vz + dt2*k2[i].az;
     }
-    force->update_accelerations(sim, force, k3, N);
+    rebx_update_accelerations(sim, force, k3, N);
     
     for(int i=0; i<N; i++){     // store k2+k3 in k3 and reuse k2 for k4 to avoid a memcpy
         k2[i].vx = sim->particles[i].vx + dt*k3[i].ax;
@@ -80,7 +80,7 @@ void rebx_integrator_rk4_integrate(struct reb_simulation* const sim, const doubl
         k3[i].az += k2[i].az;
     }
     rebx_reset_accelerations(k2, N);
-    force->update_accelerations(sim, force, k2, N);
+    rebx_update_accelerations(sim, force, k2, N);
     
     const double dt6 = dt/6.;
     for(int i=0; i<N; i++){
@@ -37,6 +37,7 @@
  * 
  * This adds exponential mass growth/loss to individual particles every timestep.
  * Set particles' ``tau_mass`` parameter to a negative value for mass loss, positive for mass growth.
+ * Masses are updated with the exact exponential factor for each step, and the simulation is then shifted back to the center of mass frame.
  * 
  * **Effect Parameters**
  * 
@@ -62,13 +63,36 @@
 
 void rebx_modify_mass(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
     const int _N_real = sim->N - sim->N_var;
+    struct reb_particle* const particles = sim->particles;
+    double M = 0.;
+    struct reb_vec3d mr = {0};  // sum of m*r and m*v with the updated masses, accumulated in the same pass
+    struct reb_vec3d mv = {0};
 	for(int i=0; i<_N_real; i++){
-		struct reb_particle* const p = &sim->particles[i];
+		struct reb_particle* const p = &particles[i];
         const double* const tau_mass = rebx_get_param(sim->extras, p->ap, "tau_mass");
         if (tau_mass != NULL){
-		    p->m += p->m*dt/(*tau_mass);
+		    p->m *= exp(dt/(*tau_mass));   // exact solution of dm/dt = m/tau_mass over dt
         }
+        M += p->m;
+        mr.x += p->m*p->x; mr.y += p->m*p->y; mr.z += p->m*p->z;
+        mv.x += p->m*p->vx; mv.y += p->m*p->vy; mv.z += p->m*p->vz;
 	}
-    reb_simulation_move_to_com(sim);
+    if (sim->N_var > 0 || sim->integrator == REB_INTEGRATOR_MERCURIUS){
+        reb_simulation_move_to_com(sim); // also shifts variational particles / MERCURIUS's internal coordinates
+        return;
+    }
+    if (M <= 0.){
+        return;
+    }
+    // Re-centre every step, as reb_simulation_move_to_com would, using the center of mass from the sums above instead of a separate pass
+    const double x = mr.x/M, y = mr.y/M, z = mr.z/M;
+    const double vx = mv.x/M, vy = mv.y/M, vz = mv.z/M;
+	for(int i=0; i<_N_real; i++){
+		struct reb_particle* const p = &particles[i];
+        p->x -= x; p->y -= y; p->z -= z;
+        p->vx -= vx; p->vy -= vy; p->vz -= vz;
+    }
+    if (sim->integrator == REB_INTEGRATOR_WHFAST || sim->integrator == REB_INTEGRATOR_SABA){
+        sim->ri_whfast.recalculate_coordinates_this_timestep = 1;   // SABA uses WHFast's internal coordinates. Needed with safe_mode=0
+    }
 }
-
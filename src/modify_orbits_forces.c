@@ -138,3 +138,13 @@ void rebx_modify_orbits_forces(struct reb_simulation* const sim, struct rebx_for
     const char* reference_name = "primary";
     rebx_com_force(sim, force, coordinates, back_reactions_inclusive, reference_name, rebx_calculate_modify_orbits_forces, particles, N);
 }
+
+void rebx_modify_orbits_forces_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N_active, const int N){
+    int* ptr = rebx_get_param(sim->extras, force->ap, "coordinates");
+    enum REBX_COORDINATES coordinates = REBX_COORDINATES_JACOBI; // Default
+    if (ptr != NULL){
+        coordinates = *ptr;
+    }
+    const char* reference_name = "primary";
+    rebx_com_force_testparticles(sim, force, coordinates, reference_name, rebx_calculate_modify_orbits_forces, particles, N_active, N);
+}
@@ -109,7 +109,7 @@ long pos_end_##name = ftell(of);\
 header_##name.size = pos_end_##name - pos_start_##name;\
 fseek(of, pos_start_header_##name, SEEK_SET);\
 fwrite(&header_##name, sizeof(header_##name), 1, of);\
-fseek(of, 0, SEEK_END);\
+fseek(of, pos_end_##name, SEEK_SET);\
 }
 
 /*  Write a list of listtype (e.g., ALLOCATED_FORCES) with nodes of type nodetype (e.g. ALLOCATED_FORCE), to the passed linkedlist (e.g. rebx->allocated_forces)*/
@@ -265,15 +265,7 @@ static void rebx_write_snapshot(struct rebx_extras* rebx, FILE* of){
     REBX_END_OBJECT_FIELD(snapshot);
 }
 
-void rebx_output_binary(struct rebx_extras* rebx, char* filename){
-    FILE* of = fopen(filename,"wb");
-    if (of==NULL){
-        rebx_error(rebx, "REBOUNDx error: Can not open file passed to rebx_output_binary.");
-    }
-    if (rebx->sim == NULL){
-        rebx_error(rebx, ""); // rebx_error gives meaningful err
-        return;
-    }
+static void rebx_write_binary(struct rebx_extras* rebx, FILE* of){
     // Write header.
     const char str[] = "REBOUNDx Binary File. Version: ";
     char zero = '\0';
@@ -285,5 +277,61 @@ void rebx_output_binary(struct rebx_extras* rebx, char* filename){
     fwrite(&zero,sizeof(char),1,of);
 
     rebx_write_snapshot(rebx, of);
+}
+
+void rebx_output_binary(struct rebx_extras* rebx, char* filename){
+    if (rebx->sim == NULL){
+        rebx_error(rebx, ""); // rebx_error gives meaningful err
+        return;
+    }
+    FILE* of = fopen(filename,"wb");
+    if (of==NULL){
+        rebx_error(rebx, "REBOUNDx error: Can not open file passed to rebx_output_binary.");
+        return;
+    }
+    rebx_write_binary(rebx, of);
     fclose(of);
 }
+
+void rebx_output_binary_to_stream(struct rebx_extras* rebx, char** bufp, size_t* sizep){
+    *bufp = NULL;
+    *sizep = 0;
+    if (rebx->sim == NULL){
+        rebx_error(rebx, ""); // rebx_error gives meaningful err
+        return;
+    }
+#ifdef _WIN32
+    // No open_memstream on Windows, so go through a temporary file
+    FILE* of = tmpfile();
+    if (of==NULL){
+        rebx_error(rebx, "REBOUNDx error: Can not open temporary file in rebx_output_binary_to_stream.");
+        return;
+    }
+    rebx_write_binary(rebx, of);
+    fseek(of, 0, SEEK_END);
+    const long size = ftell(of);
+    rewind(of);
+    *bufp = malloc(size);
+    if (*bufp == NULL || fread(*bufp, 1, size, of) != (size_t)size){
+        free(*bufp);
+        *bufp = NULL;
+        rebx_error(rebx, "REBOUNDx error: Could not read back temporary file in rebx_output_binary_to_stream.");
+    }
+    else{
+        *sizep = size;
+    }
+    fclose(of);
+#else
+    FILE* of = open_memstream(bufp, sizep);
+    if (of==NULL){
+        rebx_error(rebx, "REBOUNDx error: Can not open memory stream in rebx_output_binary_to_stream.");
+        return;
+    }
+    rebx_write_binary(rebx, of);
+    fclose(of);     // sets *bufp and *sizep
+#endif // _WIN32
+}
+
+void rebx_free_stream(char* buf){
+    free(buf);
+}
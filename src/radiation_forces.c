@@ -51,6 +51,7 @@
  * **Particle Parameters**
  *
  * If no particles have radiation_source set, effect will assume the particle at index 0 in the particles array is the source.
+ * With MPI, sources may live on any rank, and if none are set the most massive particle across all ranks is used instead.
  *
  * ============================ =========== ==================================================================
  * Field (C type)               Required    Description
@@ -65,9 +66,10 @@
 #include <math.h>
 #include <stdlib.h>
 #include "reboundx.h"
+#include "rebxtools.h"
 
-static void rebx_calculate_radiation_forces(struct rebx_extras* const rebx, struct reb_simulation* const sim, const double c, const int source_index, struct reb_particle* const particles, const int N){
-    const struct reb_particle source = particles[source_index];
+// source_index is the index of the source in particles (-1 if it is not in particles, e.g., on another MPI rank)
+static void rebx_calculate_radiation_forces(struct rebx_extras* const rebx, struct reb_simulation* const sim, const double c, const struct reb_particle source, const int source_index, struct reb_particle* const particles, const int N){
     const double mu = sim->G*source.m;
 
     for (int i=0;i<N;i++){
@@ -97,6 +99,47 @@ static void rebx_calculate_radiation_forces(struct rebx_extras* const rebx, stru
 	}
 }
 
+#ifdef MPI
+// Sources can be on any rank, so their states are gathered on all ranks. Without any radiation_source, the source defaults to the most massive particle.
+static void rebx_radiation_forces_mpi(struct rebx_extras* const rebx, struct reb_simulation* const sim, const double c, struct reb_particle* const particles, const int N){
+    const int n = 9; // x, y, z, vx, vy, vz, m, rank, index
+    int N_local = 0;
+    for (int i=0; i<N; i++){
+        if (rebx_get_param(rebx, particles[i].ap, "radiation_source") != NULL){
+            N_local++;
+        }
+    }
+    double* const local = malloc((n*N_local + 1)*sizeof(*local));
+    for (int i=0, j=0; i<N; i++){
+        if (rebx_get_param(rebx, particles[i].ap, "radiation_source") != NULL){
+            const struct reb_particle p = particles[i];
+            double* const s = &local[n*j++];
+            s[0] = p.x; s[1] = p.y; s[2] = p.z;
+            s[3] = p.vx; s[4] = p.vy; s[5] = p.vz;
+            s[6] = p.m; s[7] = sim->mpi_id; s[8] = i;
+        }
+    }
+    int n_total;
+    double* const all = rebx_mpi_allgather(sim, local, n*N_local, &n_total);
+    if (n_total == 0){
+        struct reb_particle source;
+        const int source_index = rebx_mpi_primary(sim, particles, N, &source);
+        rebx_calculate_radiation_forces(rebx, sim, c, source, source_index, particles, N);
+    }
+    for (int k=0; k<n_total/n; k++){
+        const double* const s = &all[n*k];
+        struct reb_particle source = {0};
+        source.x = s[0]; source.y = s[1]; source.z = s[2];
+        source.vx = s[3]; source.vy = s[4]; source.vz = s[5];
+        source.m = s[6];
+        const int source_index = ((int)s[7] == sim->mpi_id) ? (int)s[8] : -1;
+        rebx_calculate_radiation_forces(rebx, sim, c, source, source_index, particles, N);
+    }
+    free(all);
+    free(local);
+}
+#endif // MPI
+
 void rebx_radiation_forces(struct reb_simulation* const sim, struct rebx_force* const radiation_forces, struct reb_particle* const particles, const int N){
     struct rebx_extras* const rebx = sim->extras;
     double* c = rebx_get_param(rebx, radiation_forces->ap, "c");
@@ -105,15 +148,21 @@ void rebx_radiation_forces(struct reb_simulation* const sim, struct rebx_force*
         return;
     }
     
+#ifdef MPI
+    if (sim->mpi_num > 1){
+        rebx_radiation_forces_mpi(rebx, sim, *c, particles, N);
+        return;
+    }
+#endif // MPI
     int source_found=0;
     for (int i=0; i<N; i++){
         if (rebx_get_param(rebx, particles[i].ap, "radiation_source") != NULL){
             source_found = 1;
-            rebx_calculate_radiation_forces(rebx, sim, *c, i, particles, N);
+            rebx_calculate_radiation_forces(rebx, sim, *c, particles[i], i, particles, N);
         }
     }
     if (!source_found){
-        rebx_calculate_radiation_forces(rebx, sim, *c, 0, particles, N);    // default source to index 0 if "radiation_source" not found on any particle
+        rebx_calculate_radiation_forces(rebx, sim, *c, particles[0], 0, particles, N);    // default source to index 0 if "radiation_source" not found on any particle
     }
 }
 
@@ -69,6 +69,30 @@ enum REBX_COORDINATES{
     REBX_COORDINATES_PARTICLE,              ///< Coordinates relative to pos/vel of a particular particle.
 };
 
+/**
+ * @brief Built-in events detected by the track_events operator. Combine with | to set the ev_events bitmask.
+ */
+enum REBX_EVENT{
+    REBX_EVENT_PERICENTER = 1,              ///< Pericenter passage (r.v changes sign from - to +)
+    REBX_EVENT_APOCENTER = 2,               ///< Apocenter passage (r.v changes sign from + to -)
+    REBX_EVENT_ASCENDING_NODE = 4,          ///< z changes sign from - to +
+    REBX_EVENT_DESCENDING_NODE = 8,         ///< z changes sign from + to -
+    REBX_EVENT_RESONANCE = 16,              ///< Resonant angle crosses zero
+};
+
+/**
+ * @brief Conditions reported through the diagnostics channel. Each is counted every time it occurs, but only reported as a warning
+ * on its 1st, 10th, 100th... occurrence (see rebx_diagnostic_count).
+ */
+enum rebx_diagnostic{
+    REBX_DIAGNOSTIC_SPIN_ODE_MISSING,               ///< tides_spin called without the spin ODE (see rebx_spin_initialize_ode)
+    REBX_DIAGNOSTIC_ADAPTIVE_OPERATOR,              ///< Operator modifying particles applied with an adaptive IAS15 timestep
+    REBX_DIAGNOSTIC_GR_NOT_CONVERGED,               ///< Velocity iteration in gr did not converge (counted per particle)
+    REBX_DIAGNOSTIC_GR_FULL_NOT_CONVERGED,          ///< Acceleration iteration in gr_full did not converge
+    REBX_DIAGNOSTIC_IMPLICIT_MIDPOINT_NOT_CONVERGED,///< Iteration in the implicit midpoint integrator did not converge
+    REBX_DIAGNOSTIC_N,                              ///< Number of diagnostic codes
+};
+
 /**
  * @brief Flag for whether steps should happen before or after the timestep
  */
@@ -195,6 +219,25 @@ struct rebx_param{
     void* value;                ///< Pointer to parameter value
 };
 
+/**
+ * @brief Subscription to changes in a parameter (see rebx_add_param_observer).
+ */
+struct rebx_param_observer{
+    char* name;                 ///< Name of the observed parameter, or NULL to observe all parameters
+    void (*callback) (struct rebx_extras* const rebx, struct rebx_node** const apptr, const char* const param_name, void* const data); ///< Called after each change if not NULL, with the parameter list (e.g. &particle->ap) that changed
+    void* data;                 ///< Passed to callback
+    int* flag;                  ///< Set to 1 after each change if not NULL
+};
+
+/**
+ * @brief Machine-dependent settings for the loops over particles in the stepper kernels (see rebx_autotune), whose OpenMP threshold and chunk size also apply to the parallel loops in forces.
+ */
+struct rebx_tuning{
+    int omp_threshold;          ///< Minimum number of particles for which loops run in parallel with OpenMP
+    int omp_chunk;              ///< Chunk size for OpenMP's guided schedule
+    int simd;                   ///< 1 to use the explicitly vectorized (omp simd) variants of the loops
+};
+
 /**
  * @brief Structure for REBOUNDx forces.
  */
@@ -205,6 +248,7 @@ struct rebx_force{
     // See comments in params.py in __init__
     enum rebx_force_type force_type;    ///< Force type for internal logic
     void (*update_accelerations) (struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N); ///< Function pointer to add additional accelerations
+    void (*update_accelerations_testparticles) (struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* const particles, const int N_active, const int N); ///< Optional function pointer to add accelerations to test particles [N_active, N) from particles [0, N_active), without back-reactions
 };
 
 /**
@@ -244,6 +288,18 @@ struct rebx_interpolator{
     double* y2;
     int klo;
 };
+
+/**
+ * @brief Record of a single event logged by the track_events operator (also the record format of its binary file).
+ */
+struct rebx_event{
+    double t;                                       ///< Time of the event
+    int32_t index;                                  ///< Index of the particle in sim->particles
+    int32_t type;                                   ///< Event type (REBX_EVENT enum)
+    double x, y, z;                                 ///< Interpolated position of the particle
+    double vx, vy, vz;                              ///< Interpolated velocity of the particle
+};
+
 /**
  * @brief Main REBOUNDx structure.
  * @details These fields are used internally by REBOUNDx and generally should not be changed manually by the user. Use the API instead.
@@ -258,6 +314,20 @@ struct rebx_extras {
     struct rebx_node* registered_params;            ///< Linked list of rebx_params with all the parameter names registered with their type (for type safety)
     struct rebx_node* allocated_forces;             ///< For memory management
     struct rebx_node* allocated_operators;          ///< For memory management
+
+    struct reb_orbit* orbits;                       ///< Heliocentric orbits shared between effects (see rebx_heliocentric_orbits)
+    int orbits_N;                                   ///< Number of entries in orbits
+    int orbits_valid;                               ///< 1 if orbits reflect the current particle states
+
+    int set_velocity_dependent;                     ///< 1 if REBOUNDx turned on sim->force_is_velocity_dependent (and should turn it off when no velocity-dependent forces remain)
+
+    struct rebx_jacobi_cache* jacobi;               ///< Jacobi coordinates, masses and interior centers of mass shared between effects (see rebxtools.h)
+    unsigned long force_evaluations;                ///< Number of REBOUNDx force evaluations (calls to a force's update_accelerations) since REBOUNDx was attached
+    unsigned long diagnostic_counts[REBX_DIAGNOSTIC_N];     ///< Number of times each rebx_diagnostic occurred
+    unsigned long diagnostic_next_report[REBX_DIAGNOSTIC_N];///< Count at which each rebx_diagnostic is next reported as a warning
+    struct rebx_node* param_observers;              ///< Linked list of rebx_param_observers notified when parameters are set or removed
+    struct rebx_tuning tuning;                      ///< Loop settings for the stepper kernels, set by rebx_autotune
+    struct rebx_mpi_params* mpi_params;             ///< Particles with parameters on this rank, to send their parameters along when they move to another rank (see communication_mpi.c). Always NULL without MPI, but present so that the struct has the same layout in every build.
 };
 
 /****************************************
@@ -304,6 +374,20 @@ int rebx_remove_operator(struct rebx_extras* rebx, struct rebx_operator* operato
  */
 void rebx_output_binary(struct rebx_extras* rebx, char* filename);
 
+/**
+ * @brief Same as rebx_output_binary(), but writes the binary to a buffer in memory (e.g. to send it to another process).
+ * @param rebx Pointer to the rebx_extras instance
+ * @param bufp Set to the newly allocated buffer. Free with rebx_free_stream().
+ * @param sizep Set to the size of the buffer in bytes.
+ */
+void rebx_output_binary_to_stream(struct rebx_extras* rebx, char** bufp, size_t* sizep);
+
+/**
+ * @brief Frees a buffer allocated by rebx_output_binary_to_stream().
+ * @param buf Pointer to the buffer.
+ */
+void rebx_free_stream(char* buf);
+
 /**
  * @brief Reads a REBOUNDx binary file, loads all effects and parameters.
  * @param sim Pointer to the simulation to which the effects and parameters should be added.
@@ -318,6 +402,15 @@ struct rebx_extras* rebx_create_extras_from_binary(struct reb_simulation* sim, c
  * @param warnings Pointer to an array of warnings to be populated during loading.
  */
 void rebx_init_extras_from_binary(struct rebx_extras* rebx, const char* const filename, enum rebx_input_binary_messages* warnings);
+
+/**
+ * @brief Same as rebx_init_extras_from_binary(), but reads the binary from a buffer written by rebx_output_binary_to_stream().
+ * @param rebx Pointer to a rebx_extras instance to be updated.
+ * @param buf Pointer to the buffer.
+ * @param size Size of the buffer in bytes.
+ * @param warnings Pointer to an array of warnings to be populated during loading.
+ */
+void rebx_init_extras_from_stream(struct rebx_extras* rebx, const char* const buf, const size_t size, enum rebx_input_binary_messages* warnings);
 /** @} */
 /** @} */
 
@@ -402,11 +495,35 @@ struct rebx_operator* rebx_get_operator(struct rebx_extras* const rebx, const ch
 
 /**
  * @brief Removes a parameter from a particle or effect.
- * @param object Pointer to the particle or effect we want to remove a parameter from.
+ * @details Values of double, int, uint32 and vec3d parameters are freed. Structures set with rebx_set_param_pointer are not.
+ * @param rebx Pointer to the extras instance.
+ * @param apptr Pointer to the ap member of the particle or effect we want to remove a parameter from.
  * @param param_name Name of the parameter we want to remove.
  * @return 1 if parameter found and successfully removed, 0 otherwise.
  */
-int rebx_remove_param(struct rebx_node** apptr, const char* const param_name);
+int rebx_remove_param(struct rebx_extras* const rebx, struct rebx_node** apptr, const char* const param_name);
+
+/**
+ * @brief Subscribes to changes in a parameter, so that quantities derived from it can be cached and only recomputed when it changes.
+ * @details The observer is notified whenever a parameter with the passed name is set (through the rebx_set_param functions) or removed,
+ * on any particle, force or operator. Changes made by writing through the pointer returned by rebx_get_param are not detected.
+ * Callbacks must not add or remove observers, or set the parameters they observe.
+ * @param rebx Pointer to the extras instance.
+ * @param param_name Name of the parameter to observe, or NULL to observe all parameters.
+ * @param callback Function called after each change (can be NULL), with the parameter list that changed (e.g. &sim->particles[i].ap), the parameter name and data.
+ * @param data Pointer passed to callback.
+ * @param flag If not NULL, set to 1 after each change (for the observer to reset once it has updated its cache).
+ * @return Pointer to the observer, to pass to rebx_remove_param_observer, or NULL on error.
+ */
+struct rebx_param_observer* rebx_add_param_observer(struct rebx_extras* const rebx, const char* const param_name, void (*callback) (struct rebx_extras* const rebx, struct rebx_node** const apptr, const char* const param_name, void* const data), void* const data, int* const flag);
+
+/**
+ * @brief Unsubscribes and frees an observer returned by rebx_add_param_observer.
+ * @param rebx Pointer to the extras instance.
+ * @param observer Observer to remove.
+ * @return 1 if the observer was found and removed, 0 otherwise.
+ */
+int rebx_remove_param_observer(struct rebx_extras* const rebx, struct rebx_param_observer* const observer);
 
 /**
  * @brief Gets a parameter from a particle or effect.
@@ -450,6 +567,37 @@ struct reb_vec3d rebx_tools_spin_angular_momentum(struct rebx_extras* const rebx
 
 void rebx_simulation_irotate(struct rebx_extras* const rebx, const struct reb_rotation q);
 
+/**
+ * @brief Returns the number of times a diagnostic condition has occurred since REBOUNDx was attached (or rebx_diagnostics_reset was called).
+ * @param rebx Pointer to the rebx_extras instance
+ * @param code Diagnostic code
+ */
+unsigned long rebx_diagnostic_count(struct rebx_extras* const rebx, const enum rebx_diagnostic code);
+
+/**
+ * @brief Returns the message reported as a warning for a diagnostic code, or NULL if the code is invalid.
+ * @param code Diagnostic code
+ */
+const char* rebx_diagnostic_message(const enum rebx_diagnostic code);
+
+/**
+ * @brief Sets all diagnostic counts to zero, so that each condition gets reported again on its next occurrence.
+ * @param rebx Pointer to the rebx_extras instance
+ */
+void rebx_diagnostics_reset(struct rebx_extras* const rebx);
+
+/**
+ * @brief Sets rebx->tuning for this machine, measuring the stepper kernels if needed.
+ * @details Calibration times the drift and kick loops for several particle numbers, to choose between the plain and vectorized loops
+ * and (with OpenMP) the chunk size and the number of particles above which loops run in parallel. It takes a fraction of a second.
+ * If filename is not NULL, the results are cached in that file, keyed by CPU model and number of OpenMP threads,
+ * and loaded from it instead of recalibrating when the key matches.
+ * @param rebx Pointer to the rebx_extras instance
+ * @param filename Path to the cache file, or NULL to always calibrate
+ * @return 1 if the settings were loaded from the cache, 0 if they were measured, -1 on error.
+ */
+int rebx_autotune(struct rebx_extras* const rebx, const char* const filename);
+
 
 
 /******************************************
@@ -564,6 +712,179 @@ double rebx_central_force_potential(struct rebx_extras* const rebx);
  */
 double rebx_gravitational_harmonics_potential(struct rebx_extras* const rebx);
 
+/**
+ * @brief Number of targets (columns) in the track_encounters tables.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @return Number of targets, or 0 if the operator has not run yet.
+ */
+int rebx_track_encounters_N_targets(struct rebx_extras* const rebx, struct rebx_operator* const operator);
+
+/**
+ * @brief Number of tracked particles (rows) in the track_encounters tables.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @return Number of tracked particles, or 0 if the operator has not run yet.
+ */
+int rebx_track_encounters_N_tracked(struct rebx_extras* const rebx, struct rebx_operator* const operator);
+
+/**
+ * @brief Copies the minimum separation of each (tracked, target) pair from the track_encounters operator.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @param min_distances Array of length N_tracked*N_targets to fill (row-major, one row per tracked particle). INFINITY for pairs that never had an encounter.
+ */
+void rebx_track_encounters_min_distances(struct rebx_extras* const rebx, struct rebx_operator* const operator, double* const min_distances);
+
+/**
+ * @brief Copies the number of encounters of each (tracked, target) pair from the track_encounters operator.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @param counts Array of length N_tracked*N_targets to fill (row-major, one row per tracked particle).
+ */
+void rebx_track_encounters_counts(struct rebx_extras* const rebx, struct rebx_operator* const operator, int* const counts);
+
+/**
+ * @brief Copies the particle indices of the rows (tracked particles) and columns (targets) of the track_encounters tables.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @param tracked Array of length N_tracked to fill.
+ * @param targets Array of length N_targets to fill.
+ */
+void rebx_track_encounters_indices(struct rebx_extras* const rebx, struct rebx_operator* const operator, int* const tracked, int* const targets);
+
+/**
+ * @brief Adds a quantity to accumulate statistics for in the running_stats operator.
+ * @details Registers the double particle parameters <name>_mean, <name>_var, <name>_min and <name>_max, which the operator updates on every sample.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @param name Heliocentric orbital element (a, e, inc, Omega, omega, pomega, f, M, l, P) or name of a registered parameter of type double.
+ * @return Index of the quantity, or -1 on error.
+ */
+int rebx_running_stats_add(struct rebx_extras* const rebx, struct rebx_operator* const operator, const char* const name);
+
+/**
+ * @brief Number of particles (rows) in the running_stats tables.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @return Number of particles, or 0 if the operator has not run yet.
+ */
+int rebx_running_stats_N(struct rebx_extras* const rebx, struct rebx_operator* const operator);
+
+/**
+ * @brief Copies the statistics of one quantity for all particles from the running_stats operator.
+ * @details Each array has length rebx_running_stats_N and can be NULL if not needed. Particles without samples get NaN.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @param name Quantity previously added with rebx_running_stats_add.
+ * @param n Number of samples.
+ * @param mean Mean.
+ * @param var Population variance.
+ * @param min Minimum (unwrapped for angles).
+ * @param max Maximum (unwrapped for angles).
+ */
+void rebx_running_stats_get(struct rebx_extras* const rebx, struct rebx_operator* const operator, const char* const name, long long* const n, double* const mean, double* const var, double* const min, double* const max);
+
+/**
+ * @brief Resets all statistics accumulated by the running_stats operator, keeping the list of quantities.
+ * @details Also removes the <name>_mean, <name>_var, <name>_min and <name>_max parameters from the particles.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ */
+void rebx_running_stats_reset(struct rebx_extras* const rebx, struct rebx_operator* const operator);
+
+/**
+ * @brief Appends events logged by the track_events operator to a binary file of struct rebx_event records instead of keeping them in memory.
+ * @details Truncates the file. Records already in memory are written to it.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @param filename File to write to.
+ */
+void rebx_track_events_set_file(struct rebx_extras* const rebx, struct rebx_operator* const operator, const char* const filename);
+
+/**
+ * @brief Writes any buffered track_events records to the file set with rebx_track_events_set_file.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ */
+void rebx_track_events_flush(struct rebx_extras* const rebx, struct rebx_operator* const operator);
+
+/**
+ * @brief Number of track_events records currently held in memory.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @return Number of records.
+ */
+int rebx_track_events_N(struct rebx_extras* const rebx, struct rebx_operator* const operator);
+
+/**
+ * @brief Copies the track_events records currently held in memory.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @param events Array of length rebx_track_events_N to fill.
+ */
+void rebx_track_events_get(struct rebx_extras* const rebx, struct rebx_operator* const operator, struct rebx_event* const events);
+
+/**
+ * @brief Adds a (particle, parameter) channel to the record_params operator.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @param index Index of the particle in sim->particles.
+ * @param name Registered parameter of type double or int, vector parameter with .x, .y or .z suffix, or particle field (m, r, x, y, z, vx, vy, vz).
+ * @return Index of the channel (its column is index+1 after the time column), or -1 on error.
+ */
+int rebx_record_params_add_channel(struct rebx_extras* const rebx, struct rebx_operator* const operator, const int index, const char* const name);
+
+/**
+ * @brief Writes the record_params buffer to a binary column file in blocks whenever it fills up, rather than overwriting old rows.
+ * @details Truncates the file. Rows already in the buffer are written to it. Channels can not be added afterward.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @param filename File to write to.
+ */
+void rebx_record_params_set_file(struct rebx_extras* const rebx, struct rebx_operator* const operator, const char* const filename);
+
+/**
+ * @brief Writes the rows in the record_params buffer to the file set with rebx_record_params_set_file and empties the buffer.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ */
+void rebx_record_params_flush(struct rebx_extras* const rebx, struct rebx_operator* const operator);
+
+/**
+ * @brief Gives direct access to the columnar buffer of the record_params operator.
+ * @details Column c (0 for times, c+1 for channel c) starts at buffer + c*capacity. The N_rows valid rows end just before row head, wrapping around.
+ * The pointer is invalidated by rebx_record_params_add_channel (which reallocates the buffer) and when the operator is freed, so copy out the rows you need.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator.
+ * @param N_channels Set to the number of channels.
+ * @param capacity Set to the number of rows per column.
+ * @param N_rows Set to the number of valid rows.
+ * @param head Set to the row that will be written next.
+ * @return Pointer to the buffer, or NULL if no channels have been added.
+ */
+double* rebx_record_params_buffer(struct rebx_extras* const rebx, struct rebx_operator* const operator, int* const N_channels, int* const capacity, int* const N_rows, int* const head);
+
+/**
+ * @brief Schedules a stellar encounter for the flyby operator.
+ * @details The impact vector and velocity are relative to the simulation's center of mass. Any component of the impact vector along the velocity is dropped.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator("flyby").
+ * @param t Time of closest approach. Must not have already passed.
+ * @param m Mass of the passing star.
+ * @param b Position of the star at closest approach.
+ * @param v Velocity of the star.
+ * @return Index of the encounter in the time-sorted schedule, or -1 on error.
+ */
+int rebx_flyby_add(struct rebx_extras* const rebx, struct rebx_operator* const operator, const double t, const double m, const struct reb_vec3d b, const struct reb_vec3d v);
+
+/**
+ * @brief Returns the number of scheduled encounters the flyby operator has applied so far.
+ * @param rebx pointer to the REBOUNDx extras instance.
+ * @param operator Operator structure returned by rebx_load_operator("flyby").
+ */
+int rebx_flyby_N_applied(struct rebx_extras* const rebx, struct rebx_operator* const operator);
+
 /** @} */
 /** @} */
 
@@ -620,6 +941,15 @@ struct rebx_param* rebx_get_or_add_param(struct rebx_extras* const rebx, struct
  * @param dt timestep for which to step in simulation time units.
  */
 void rebx_ias15_step(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
+/**
+ * @brief Executes a step for passed time dt using the IAS15 integrator in REBOUND on only the particles with the ias15_group parameter set to 1.
+ * @details The remaining massive particles act as an external field, interpolated between their states at the start of the step and
+ * their states predicted along unperturbed heliocentric orbits at the end. Only the group's particles are moved.
+ * @param sim Pointer to the simulation to step.
+ * @param operator Unused pointer (kept for consistency with other operators). Can pass NULL.
+ * @param dt timestep for which to step in simulation time units.
+ */
+void rebx_ias15_group_step(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
 /**
  * @brief Executes a Kepler step for passed time dt using the WHFast integrator in REBOUND.
  * @details Will use the coordinates and other options set in sim.ri_whfast
@@ -658,6 +988,15 @@ void rebx_drift_step(struct reb_simulation* const sim, struct rebx_operator* con
  * @param dt timestep for which to step in simulation time units.
  */
 void rebx_kick_step(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
+/**
+ * @brief Executes a kick step for passed time dt using only REBOUNDx forces (no gravity).
+ * @details Evaluates the force set as the operator's "force" parameter (or, if not set, all forces added with rebx_add_force) into zeroed accelerations,
+ * and kicks the velocities. Positions are not modified.
+ * @param sim Pointer to the simulation to step.
+ * @param operator Pointer to the operator (can pass NULL to kick with all added forces).
+ * @param dt timestep for which to step in simulation time units.
+ */
+void rebx_kick_forces_step(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt);
 /** @} */
 /** @} */
 
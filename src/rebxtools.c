@@ -1,7 +1,9 @@
 #include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "reboundx.h"
+#include "rebxtools.h"
 
 struct reb_particle rebx_get_com_without_particle(struct reb_particle com, struct reb_particle p){
     com.x = com.x*com.m - p.x*p.m;
@@ -68,8 +70,12 @@ void rebx_com_force(struct reb_simulation* const sim, struct rebx_force* const f
     struct reb_particle com = reb_simulation_com(sim); // Start with full com for jacobi and barycentric coordinates.
 
     int refindex = -1;
+    const struct reb_particle* interior_coms = NULL;
     if(coordinates == REBX_COORDINATES_JACOBI){
         refindex = 0;                           // There is no jacobi coordinate for the 0th particle, so set refindex to skip it in loop below.
+        if (particles == sim->particles && N == sim->N - sim->N_var){
+            interior_coms = rebx_interior_coms(rebx);  // shared with other effects using Jacobi coordinates in the same substep
+        }
     }
     else if(coordinates == REBX_COORDINATES_PARTICLE){
         for (int i=0; i < N; i++){
@@ -94,7 +100,10 @@ void rebx_com_force(struct reb_simulation* const sim, struct rebx_force* const f
             continue;
         }
         struct reb_particle* p = &particles[i];
-        if (coordinates == REBX_COORDINATES_JACOBI){
+        if (interior_coms){
+            com = interior_coms[i];
+        }
+        else if (coordinates == REBX_COORDINATES_JACOBI){
             com = rebx_get_com_without_particle(com, *p);
         }
 
@@ -146,6 +155,41 @@ void rebx_com_force(struct reb_simulation* const sim, struct rebx_force* const f
     }
 }
 
+void rebx_com_force_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, const enum REBX_COORDINATES coordinates, const char* reference_name, struct reb_vec3d (*calculate_force) (struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* p, struct reb_particle* source), struct reb_particle* const particles, const int N_active, const int N){
+    struct rebx_extras* const rebx = sim->extras;
+    // Test particles are massless, so the barycenter and the center of mass interior to any test particle (Jacobi) are both the full com
+    struct reb_particle com = reb_simulation_com(sim);
+
+    if(coordinates == REBX_COORDINATES_PARTICLE){
+        int refindex = -1;
+        for (int i=0; i < N_active; i++){
+            if (rebx_get_param(rebx, particles[i].ap, reference_name)){
+                com = particles[i];
+                refindex = i;
+                break;
+            }
+        }
+        if (refindex == -1){
+            char str[200];
+            sprintf(str, "Coordinates set to REBX_COORDINATES_PARTICLE, but %s param was not found in any active particle.  Need to set parameter.\n", reference_name);
+            reb_simulation_error(sim, str);
+            return;
+        }
+    }
+    else if (coordinates != REBX_COORDINATES_BARYCENTRIC && coordinates != REBX_COORDINATES_JACOBI){
+        reb_simulation_error(sim, "Coordinates not supported in REBOUNDx.\n");
+        return;
+    }
+
+    for(int i=N_active; i<N; i++){
+        struct reb_particle* p = &particles[i];
+        const struct reb_vec3d a = calculate_force(sim, force, p, &com);
+        p->ax += a.x;
+        p->ay += a.y;
+        p->az += a.z;
+    }
+}
+
 static inline void rebx_subtract_posvel(struct reb_particle* p, struct reb_particle* diff, const double massratio){
     p->x -= massratio*diff->x;
     p->y -= massratio*diff->y;
@@ -272,3 +316,259 @@ void rebx_simulation_irotate(struct rebx_extras* const rebx, const struct reb_ro
         }
     }
 }
+
+/****************************************
+Dense output helpers
+****************************************/
+
+// Cubic Hermite interpolant x(s) = a + b*s + c*s^2 + d*s^3 on s in [0,1] matching positions and velocities of p0 (s=0) and p1 (s=1) separated in time by h
+static inline void rebx_hermite_coefficients(const double x0, const double v0, const double x1, const double v1, const double h, double* const c){
+    c[0] = x0;
+    c[1] = h*v0;
+    c[2] = 3.*(x1-x0) - h*(2.*v0 + v1);
+    c[3] = 2.*(x0-x1) + h*(v0 + v1);
+}
+
+struct reb_particle rebx_hermite_interpolate(const struct reb_particle p0, const struct reb_particle p1, const double h, const double s){
+    struct reb_particle p = p1;
+    double c[3][4];
+    rebx_hermite_coefficients(p0.x, p0.vx, p1.x, p1.vx, h, c[0]);
+    rebx_hermite_coefficients(p0.y, p0.vy, p1.y, p1.vy, h, c[1]);
+    rebx_hermite_coefficients(p0.z, p0.vz, p1.z, p1.vz, h, c[2]);
+    double pos[3];
+    double vel[3];
+    for (int k=0; k<3; k++){
+        pos[k] = c[k][0] + s*(c[k][1] + s*(c[k][2] + s*c[k][3]));
+        vel[k] = (c[k][1] + s*(2.*c[k][2] + s*3.*c[k][3]))/h;
+    }
+    p.x = pos[0]; p.y = pos[1]; p.z = pos[2];
+    p.vx = vel[0]; p.vy = vel[1]; p.vz = vel[2];
+    return p;
+}
+
+double rebx_hermite_min_distance(const struct reb_particle r0, const struct reb_particle r1, const double h, double* const s_min){
+    double c[3][4];
+    rebx_hermite_coefficients(r0.x, r0.vx, r1.x, r1.vx, h, c[0]);
+    rebx_hermite_coefficients(r0.y, r0.vy, r1.y, r1.vy, h, c[1]);
+    rebx_hermite_coefficients(r0.z, r0.vz, r1.z, r1.vz, h, c[2]);
+
+    const double d0 = sqrt(r0.x*r0.x + r0.y*r0.y + r0.z*r0.z);
+    const double d1 = sqrt(r1.x*r1.x + r1.y*r1.y + r1.z*r1.z);
+    double dmin = d0;
+    *s_min = 0.;
+    if (d1 < d0){
+        dmin = d1;
+        *s_min = 1.;
+    }
+
+    // Interior minimum of |r(s)|^2 where f(s) = r.r' changes sign from approaching (<0) to receding (>0)
+    const double f0 = r0.x*r0.vx + r0.y*r0.vy + r0.z*r0.vz;
+    const double f1 = r1.x*r1.vx + r1.y*r1.vy + r1.z*r1.vz;
+    if (!(f0 < 0. && f1 > 0.)){
+        return dmin;
+    }
+
+    // Safeguarded Newton on f(s) in [lo, hi] (f(lo)<0<f(hi)). f and f' are evaluated from the polynomial coefficients.
+    double lo = 0.;
+    double hi = 1.;
+    double s = f0/(f0-f1); // secant guess
+    for (int iter=0; iter<50; iter++){
+        double f = 0.;
+        double fp = 0.;
+        for (int k=0; k<3; k++){
+            const double x = c[k][0] + s*(c[k][1] + s*(c[k][2] + s*c[k][3]));
+            const double xp = c[k][1] + s*(2.*c[k][2] + s*3.*c[k][3]);
+            const double xpp = 2.*c[k][2] + s*6.*c[k][3];
+            f += x*xp;
+            fp += xp*xp + x*xpp;
+        }
+        if (f < 0.){
+            lo = s;
+        }
+        else{
+            hi = s;
+        }
+        double snew = (fp > 0.) ? s - f/fp : 0.5*(lo + hi);
+        if (snew <= lo || snew >= hi){ // Newton left the bracket, bisect instead
+            snew = 0.5*(lo + hi);
+        }
+        if (fabs(snew - s) < 1.e-15 || hi - lo < 1.e-15){
+            s = snew;
+            break;
+        }
+        s = snew;
+    }
+
+    double d2 = 0.;
+    for (int k=0; k<3; k++){
+        const double x = c[k][0] + s*(c[k][1] + s*(c[k][2] + s*c[k][3]));
+        d2 += x*x;
+    }
+    const double d = sqrt(d2);
+    if (d < dmin){
+        dmin = d;
+        *s_min = s;
+    }
+    return dmin;
+}
+
+double rebx_find_root(double (*g)(const double s, void* const args), void* const args, double g0, double g1){
+    // Illinois variant of regula falsi on s in [0,1], assuming g0=g(0) and g1=g(1) bracket a root
+    double lo = 0.;
+    double hi = 1.;
+    double s = 0.;
+    int side = 0;
+    for (int iter=0; iter<60; iter++){
+        s = (lo*g1 - hi*g0)/(g1 - g0);
+        const double gs = g(s, args);
+        if (gs == 0. || hi - lo < 1.e-14){
+            break;
+        }
+        if ((gs < 0.) == (g0 < 0.)){
+            lo = s;
+            g0 = gs;
+            if (side == -1){
+                g1 /= 2.;
+            }
+            side = -1;
+        }
+        else{
+            hi = s;
+            g1 = gs;
+            if (side == 1){
+                g0 /= 2.;
+            }
+            side = 1;
+        }
+    }
+    return s;
+}
+
+/****************************************
+Shared orbital elements
+****************************************/
+
+void rebx_invalidate_orbits(struct rebx_extras* const rebx){
+    rebx->orbits_valid = 0;
+}
+
+const struct reb_orbit* rebx_heliocentric_orbits(struct rebx_extras* const rebx){
+    struct reb_simulation* const sim = rebx->sim;
+    const int N_real = sim->N - sim->N_var;
+    if (rebx->orbits_valid && rebx->orbits_N == N_real){
+        return rebx->orbits;
+    }
+    if (rebx->orbits_N != N_real){
+        struct reb_orbit* orbits = realloc(rebx->orbits, N_real*sizeof(*orbits));
+        if (orbits == NULL && N_real > 0){
+            rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for shared orbital elements.\n");
+            return NULL;
+        }
+        rebx->orbits = orbits;
+        rebx->orbits_N = N_real;
+    }
+    const struct reb_particle* const ps = sim->particles;
+    for (int i=0; i<N_real; i++){       // REBOUND fills elements with NaN on error, e.g., for the primary itself
+        int err;
+        rebx->orbits[i] = reb_orbit_from_particle_err(sim->G, ps[i], ps[0], &err);
+    }
+    rebx->orbits_valid = 1;
+    return rebx->orbits;
+}
+
+/****************************************
+Shared Jacobi coordinates
+****************************************/
+
+void rebx_free_jacobi(struct rebx_extras* const rebx){
+    struct rebx_jacobi_cache* const cache = rebx->jacobi;
+    if (cache == NULL){
+        return;
+    }
+    free(cache->ps_j);
+    free(cache->m_j);
+    free(cache->coms);
+    free(cache);
+    rebx->jacobi = NULL;
+}
+
+void rebx_invalidate_jacobi(struct rebx_extras* const rebx){
+    if (rebx->jacobi){
+        rebx->jacobi->particles = NULL;
+    }
+}
+
+// Returns the cache for particles, resetting it if it was invalidated or last used for a different array.
+static struct rebx_jacobi_cache* rebx_jacobi_cache(struct rebx_extras* const rebx, const struct reb_particle* const particles, const int N){
+    struct rebx_jacobi_cache* cache = rebx->jacobi;
+    if (cache == NULL){
+        cache = calloc(1, sizeof(*cache));
+        if (cache == NULL){
+            rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for shared Jacobi coordinates.\n");
+            return NULL;
+        }
+        rebx->jacobi = cache;
+    }
+    if (cache->particles == particles && cache->N == N){
+        return cache;
+    }
+    if (N > cache->N_allocated){
+        cache->ps_j = realloc(cache->ps_j, N*sizeof(*cache->ps_j));
+        cache->m_j = realloc(cache->m_j, N*sizeof(*cache->m_j));
+        cache->coms = realloc(cache->coms, N*sizeof(*cache->coms));
+        if (cache->ps_j == NULL || cache->m_j == NULL || cache->coms == NULL){
+            rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for shared Jacobi coordinates.\n");
+            rebx_free_jacobi(rebx);
+            return NULL;
+        }
+        cache->N_allocated = N;
+    }
+    cache->particles = particles;
+    cache->N = N;
+    cache->ps_j_valid = 0;
+    cache->m_j_valid = 0;
+    cache->coms_valid = 0;
+    return cache;
+}
+
+const struct reb_particle* rebx_jacobi_particles(struct rebx_extras* const rebx, const struct reb_particle* const particles, const int N){
+    struct rebx_jacobi_cache* const cache = rebx_jacobi_cache(rebx, particles, N);
+    if (cache == NULL){
+        return NULL;
+    }
+    if (!cache->ps_j_valid){
+        reb_particles_transform_inertial_to_jacobi_posvel(particles, cache->ps_j, particles, N, N);
+        cache->ps_j_valid = 1;
+    }
+    return cache->ps_j;
+}
+
+const double* rebx_jacobi_masses(struct rebx_extras* const rebx, const struct reb_particle* const particles, const int N){
+    struct rebx_jacobi_cache* const cache = rebx_jacobi_cache(rebx, particles, N);
+    if (cache == NULL){
+        return NULL;
+    }
+    if (!cache->m_j_valid){
+        rebx_calculate_jacobi_masses(particles, cache->m_j, N);
+        cache->m_j_valid = 1;
+    }
+    return cache->m_j;
+}
+
+const struct reb_particle* rebx_interior_coms(struct rebx_extras* const rebx){
+    struct reb_simulation* const sim = rebx->sim;
+    const int N_real = sim->N - sim->N_var;
+    struct rebx_jacobi_cache* const cache = rebx_jacobi_cache(rebx, sim->particles, N_real);
+    if (cache == NULL){
+        return NULL;
+    }
+    if (!cache->coms_valid){
+        struct reb_particle com = reb_simulation_com(sim);
+        for (int i=N_real-1; i>0; i--){ // Same sequence of operations as removing particles one at a time in rebx_com_force
+            com = rebx_get_com_without_particle(com, sim->particles[i]);
+            cache->coms[i] = com;
+        }
+        cache->coms_valid = 1;
+    }
+    return cache->coms;
+}
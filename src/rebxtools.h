@@ -37,12 +37,73 @@ enum REBX_COORDINATES;
 
 void rebx_com_force(struct reb_simulation* const sim, struct rebx_force* const force, const enum REBX_COORDINATES coordinates, const int back_reactions_inclusive, const char* reference_name, struct reb_vec3d (*calculate_force) (struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* p, struct reb_particle* source), struct reb_particle* const particles, const int N);
 
+// Same as rebx_com_force for the test particles [N_active, N), which feel the particles [0, N_active) without back-reactions
+void rebx_com_force_testparticles(struct reb_simulation* const sim, struct rebx_force* const force, const enum REBX_COORDINATES coordinates, const char* reference_name, struct reb_vec3d (*calculate_force) (struct reb_simulation* const sim, struct rebx_force* const force, struct reb_particle* p, struct reb_particle* source), struct reb_particle* const particles, const int N_active, const int N);
+
 void rebx_tools_com_ptm(struct reb_simulation* const sim, struct rebx_operator* const operator, const enum REBX_COORDINATES coordinates, const int back_reactions_inclusive, const char* reference_name, struct reb_particle (*calculate_step) (struct reb_simulation* const sim, struct rebx_operator* const operator, struct reb_particle* p, struct reb_particle* source, const double dt), const double dt);
 
 double rebx_Edot(struct reb_particle* const ps, const int N);
 
 void rebx_calculate_jacobi_masses(const struct reb_particle* const ps, double* const m_j, const int N);
 
+/****************************************
+Dense output helpers
+****************************************/
+// Cubic Hermite interpolation of position and velocity between states p0 and p1 separated by time h, at fraction s of the interval
+struct reb_particle rebx_hermite_interpolate(const struct reb_particle p0, const struct reb_particle p1, const double h, const double s);
+// Minimum of |r| over the cubic Hermite interpolant of relative states r0 and r1 separated by time h. Stores fraction of interval at minimum in s_min.
+double rebx_hermite_min_distance(const struct reb_particle r0, const struct reb_particle r1, const double h, double* const s_min);
+// Root of g(s, args) on s in [0,1] given g0=g(0) and g1=g(1) of opposite sign
+double rebx_find_root(double (*g)(const double s, void* const args), void* const args, double g0, double g1);
+
+/****************************************
+Shared orbital elements
+****************************************/
+// Heliocentric orbits (relative to particles[0]) of all real particles, computed at most once per particle state and shared between effects.
+const struct reb_orbit* rebx_heliocentric_orbits(struct rebx_extras* const rebx);
+// Marks the shared orbits as stale. Called by REBOUNDx whenever particle states may have changed.
+void rebx_invalidate_orbits(struct rebx_extras* const rebx);
+
+/****************************************
+Shared Jacobi coordinates
+****************************************/
+// Jacobi state of a particle array, shared between the forces of one force evaluation.
+// Each part is computed on first use. Like the shared orbits, the cache is not checked against the particle states: it is invalidated
+// at the start of every force evaluation (rebx_additional_forces and rebx_update_accelerations), and recomputed when requested for a different array.
+struct rebx_jacobi_cache{
+    int N;
+    int N_allocated;
+    const struct reb_particle* particles;   // Array the cache was computed for, NULL if invalidated
+    struct reb_particle* ps_j;      // Jacobi positions and velocities
+    double* m_j;                    // Jacobi masses (see rebx_calculate_jacobi_masses)
+    struct reb_particle* coms;      // coms[i] is the center of mass of particles 0..i-1, i.e. interior to particle i (coms[0] is unused)
+    int ps_j_valid;
+    int m_j_valid;
+    int coms_valid;
+};
+// Jacobi positions and velocities of particles, using particles for the masses.
+const struct reb_particle* rebx_jacobi_particles(struct rebx_extras* const rebx, const struct reb_particle* const particles, const int N);
+// Jacobi masses of particles.
+const double* rebx_jacobi_masses(struct rebx_extras* const rebx, const struct reb_particle* const particles, const int N);
+// Interior centers of mass of the simulation's real particles, as used for Jacobi coordinates in rebx_com_force.
+const struct reb_particle* rebx_interior_coms(struct rebx_extras* const rebx);
+// Marks the shared Jacobi state as stale. Call before using it outside a force evaluation, since particles may have changed.
+void rebx_invalidate_jacobi(struct rebx_extras* const rebx);
+// Frees the shared Jacobi state
+void rebx_free_jacobi(struct rebx_extras* const rebx);
+
+#ifdef MPI
+/****************************************
+MPI helpers (communication_mpi.c). All are collective.
+****************************************/
+// Concatenates n_local doubles from each rank (in rank order) into a new array of n_total doubles on every rank. Caller frees.
+double* rebx_mpi_allgather(struct reb_simulation* const sim, const double* const local, const int n_local, int* const n_total);
+// Sums buf over all ranks in place
+void rebx_mpi_sum(double* const buf, const int n);
+// Stores the position, velocity and mass of the most massive particle across ranks in primary. Returns its index if it is on this rank, -1 otherwise.
+int rebx_mpi_primary(struct reb_simulation* const sim, const struct reb_particle* const particles, const int N, struct reb_particle* const primary);
+#endif // MPI
+
 /****************************************
 Effect helper functions
 ****************************************/
@@ -0,0 +1,340 @@
+/**
+ * @file    record_params.c
+ * @brief   Record time series of particle parameters into a columnar ring buffer.
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
+ *
+ * $Miscellaneous Utilities$     // Effect category (must be the first non-blank line after dollar signs and between dollar signs to be detected by script).
+ *
+ * ======================= ===============================================
+ * Authors                 D. Tamayo
+ * Implementation Paper    `Tamayo, Rein, Shi and Hernandez, 2019 <https://ui.adsabs.harvard.edu/abs/2020MNRAS.491.2885T/abstract>`_.
+ * Based on                None
+ * C Example               :ref:`c_example_record_params`
+ * Python Example          None
+ * ======================= ===============================================
+ *
+ * Samples a list of channels every ``rp_interval`` timesteps into a preallocated in-memory buffer, avoiding the overhead of polling parameters from Python.
+ * Each channel is a (particle index, name) pair added with rebx_record_params_add_channel (Extras.record_params_add_channel in Python). The name can be
+ * a particle parameter of type double or int (e.g., tau_mass, min_distance, stochastic_force_r), a component of a vector parameter
+ * with a .x, .y or .z suffix (e.g., Omega.z), or one of the particle fields m, r, x, y, z, vx, vy, vz. Channels that are missing on a particle
+ * (or particles that no longer exist) are recorded as NaN.
+ *
+ * The buffer is columnar: the first column holds the times, followed by one column per channel, each with ``rp_capacity`` rows. Without a file, the buffer is a
+ * ring that overwrites the oldest rows once full. If a file is set with rebx_record_params_set_file, the buffer is instead written to the file in one block whenever it fills
+ * up (and on rebx_record_params_flush or when the operator is freed), so no samples are lost. In Python, Extras.record_params returns copies of the samples
+ * as numpy arrays, and reboundx.read_record_params reads back a file.
+ *
+ * The file starts with an int32 number of channels, followed by blocks, each made up of an int64 number of rows n and then the time column and
+ * each channel column as n doubles.
+ *
+ * **Effect Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * rp_interval (int)            No          Only sample every rp_interval-th timestep (default 1)
+ * rp_capacity (int)            No          Number of rows in buffer (default 1024). Must be set before adding channels
+ * ============================ =========== ==================================================================
+ *
+ * **Particle Parameters**
+ *
+ * *None*
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+#include "core.h"
+
+#define REBX_RP_DEFAULT_CAPACITY 1024
+
+enum rebx_rp_field{
+    REBX_RP_PARAM,
+    REBX_RP_M,
+    REBX_RP_R,
+    REBX_RP_X,
+    REBX_RP_Y,
+    REBX_RP_Z,
+    REBX_RP_VX,
+    REBX_RP_VY,
+    REBX_RP_VZ,
+    REBX_RP_N_FIELDS,
+};
+
+static const char* const rebx_rp_field_names[REBX_RP_N_FIELDS] = {"", "m", "r", "x", "y", "z", "vx", "vy", "vz"};
+
+struct rebx_rp_channel{
+    int index;                  // Particle index
+    char* name;                 // Parameter name (without component suffix)
+    int field;                  // enum rebx_rp_field
+    int component;              // 0, 1, 2 for x, y, z component of a vector parameter, -1 otherwise
+};
+
+struct rebx_rp_buffer{
+    int N_channels;
+    struct rebx_rp_channel* channels;
+    int capacity;               // Rows per column
+    double* data;               // (N_channels+1)*capacity, column-major. Column 0 holds times
+    int head;                   // Next row to write
+    int N_rows;                 // Number of valid rows
+    long long calls;            // Number of times the operator has been called
+    char* filename;             // File to write full buffers to, or NULL for a ring buffer
+};
+
+static void rebx_rp_write(struct rebx_extras* const rebx, struct rebx_rp_buffer* const buffer){
+    if (buffer->filename == NULL || buffer->N_rows == 0){
+        return;
+    }
+    FILE* of = fopen(buffer->filename, "ab");
+    if (of == NULL){
+        rebx_error(rebx, "REBOUNDx Error: Can not open record_params file.\n");
+        return;
+    }
+    const int64_t N_rows = buffer->N_rows;
+    const int start = (buffer->head - buffer->N_rows + buffer->capacity) % buffer->capacity; // always 0 when writing to file, but keep general
+    fwrite(&N_rows, sizeof(N_rows), 1, of);
+    for (int c=0; c<=buffer->N_channels; c++){
+        const double* const column = &buffer->data[(size_t)c*buffer->capacity];
+        const int N_first = buffer->capacity - start < buffer->N_rows ? buffer->capacity - start : buffer->N_rows;
+        fwrite(&column[start], sizeof(double), N_first, of);
+        fwrite(column, sizeof(double), buffer->N_rows - N_first, of);
+    }
+    fclose(of);
+    buffer->head = 0;
+    buffer->N_rows = 0;
+}
+
+static void rebx_rp_free_arrays(struct rebx_extras* rebx, struct rebx_operator* operator){
+    struct rebx_rp_buffer* buffer = rebx_get_param(rebx, operator->ap, "rp_buffer");
+    if (buffer == NULL){
+        return;
+    }
+    rebx_rp_write(rebx, buffer);
+    for (int c=0; c<buffer->N_channels; c++){
+        free(buffer->channels[c].name);
+    }
+    free(buffer->channels);
+    free(buffer->data);
+    free(buffer->filename);
+    free(buffer);
+}
+
+static struct rebx_rp_buffer* rebx_rp_get_buffer(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_rp_buffer* buffer = rebx_get_param(rebx, operator->ap, "rp_buffer");
+    if (buffer == NULL){
+        buffer = calloc(1, sizeof(*buffer));
+        if (buffer == NULL){
+            rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for record_params buffer.\n");
+            return NULL;
+        }
+        const int* const capacity = rebx_get_param(rebx, operator->ap, "rp_capacity");
+        buffer->capacity = (capacity != NULL && *capacity > 0) ? *capacity : REBX_RP_DEFAULT_CAPACITY;
+        rebx_set_param_pointer(rebx, &operator->ap, "rp_buffer", buffer);
+        rebx_set_param_pointer(rebx, &operator->ap, "free_arrays", rebx_rp_free_arrays);
+    }
+    return buffer;
+}
+
+static inline double rebx_rp_sample(struct rebx_extras* const rebx, const struct rebx_rp_channel* const channel){
+    struct reb_simulation* const sim = rebx->sim;
+    if (channel->index < 0 || channel->index >= sim->N - sim->N_var){
+        return NAN;
+    }
+    const struct reb_particle* const p = &sim->particles[channel->index];
+    switch (channel->field){
+        case REBX_RP_M:     return p->m;
+        case REBX_RP_R:     return p->r;
+        case REBX_RP_X:     return p->x;
+        case REBX_RP_Y:     return p->y;
+        case REBX_RP_Z:     return p->z;
+        case REBX_RP_VX:    return p->vx;
+        case REBX_RP_VY:    return p->vy;
+        case REBX_RP_VZ:    return p->vz;
+        default:            break;
+    }
+    struct rebx_param* const param = rebx_get_param_struct(rebx, p->ap, channel->name);
+    if (param == NULL){
+        return NAN;
+    }
+    switch (param->type){
+        case REBX_TYPE_DOUBLE:
+            return *(double*)param->value;
+        case REBX_TYPE_INT:
+            return *(int*)param->value;
+        case REBX_TYPE_VEC3D:
+        {
+            const struct reb_vec3d v = *(struct reb_vec3d*)param->value;
+            return channel->component == 0 ? v.x : (channel->component == 1 ? v.y : v.z);
+        }
+        default:
+            return NAN;
+    }
+}
+
+void rebx_record_params(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
+    struct rebx_extras* const rebx = sim->extras;
+    struct rebx_rp_buffer* const buffer = rebx_get_param(rebx, operator->ap, "rp_buffer");
+    if (buffer == NULL || buffer->N_channels == 0){
+        reb_simulation_error(sim, "REBOUNDx Error: No channels added to record_params operator. Use rebx_record_params_add_channel.\n");
+        return;
+    }
+    const int* const rp_interval = rebx_get_param(rebx, operator->ap, "rp_interval");
+    const long long call = buffer->calls++;
+    if (rp_interval != NULL && *rp_interval > 1 && call % *rp_interval != 0){
+        return;
+    }
+
+    const int capacity = buffer->capacity;
+    const int row = buffer->head;
+    buffer->data[row] = sim->t;
+    for (int c=0; c<buffer->N_channels; c++){
+        buffer->data[(size_t)(c+1)*capacity + row] = rebx_rp_sample(rebx, &buffer->channels[c]);
+    }
+    buffer->head = (row + 1) % capacity;
+    if (buffer->N_rows < capacity){
+        buffer->N_rows++;
+    }
+    if (buffer->N_rows == capacity){
+        rebx_rp_write(rebx, buffer); // no-op for a ring buffer, which overwrites its oldest rows from now on
+    }
+}
+
+int rebx_record_params_add_channel(struct rebx_extras* const rebx, struct rebx_operator* const operator, const int index, const char* const name){
+    struct rebx_rp_channel channel = {.index=index, .field=REBX_RP_PARAM, .component=-1};
+    for (int f=1; f<REBX_RP_N_FIELDS; f++){
+        if (strcmp(name, rebx_rp_field_names[f]) == 0){
+            channel.field = f;
+        }
+    }
+    size_t len = strlen(name);
+    if (channel.field == REBX_RP_PARAM){
+        enum rebx_param_type type = rebx_get_type(rebx, name);
+        if (type == REBX_TYPE_NONE && len > 2 && name[len-2] == '.' && name[len-1] >= 'x' && name[len-1] <= 'z'){
+            char base[len-1];
+            memcpy(base, name, len-2);
+            base[len-2] = '\0';
+            if (rebx_get_type(rebx, base) == REBX_TYPE_VEC3D){
+                type = REBX_TYPE_VEC3D;
+                channel.component = name[len-1] - 'x';
+                len -= 2;
+            }
+        }
+        if (type != REBX_TYPE_DOUBLE && type != REBX_TYPE_INT && !(type == REBX_TYPE_VEC3D && channel.component >= 0)){
+            char str[300];
+            sprintf(str, "REBOUNDx Error: record_params channel '%.100s' is neither a particle field (m, r, x, y, z, vx, vy, vz), a registered parameter of type double or int, nor a vector parameter with a .x, .y or .z suffix.\n", name);
+            rebx_error(rebx, str);
+            return -1;
+        }
+    }
+    struct rebx_rp_buffer* const buffer = rebx_rp_get_buffer(rebx, operator);
+    if (buffer == NULL){
+        return -1;
+    }
+    if (buffer->filename != NULL){
+        rebx_error(rebx, "REBOUNDx Error: Can not add record_params channels after a file has been set.\n");
+        return -1;
+    }
+    if (buffer->N_rows != 0){
+        reb_simulation_warning(rebx->sim, "REBOUNDx Warning: Channel added to record_params after sampling started. Clearing buffer.\n");
+    }
+    channel.name = rebx_malloc(rebx, len + 1); // +1 for \0 at end
+    if (channel.name == NULL){
+        return -1;
+    }
+    memcpy(channel.name, name, len);
+    channel.name[len] = '\0';
+
+    const int c = buffer->N_channels;
+    double* const data = realloc(buffer->data, (size_t)(c+2)*buffer->capacity*sizeof(*data));
+    if (data == NULL){
+        rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for record_params buffer.\n");
+        free(channel.name);
+        return -1;
+    }
+    buffer->data = data;
+    struct rebx_rp_channel* const channels = realloc(buffer->channels, (c+1)*sizeof(*channels));
+    if (channels == NULL){
+        rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for record_params channels.\n");
+        free(channel.name);
+        return -1;
+    }
+    buffer->channels = channels;
+    buffer->channels[c] = channel;
+    buffer->N_channels++;
+    buffer->head = 0;
+    buffer->N_rows = 0;
+    return c;
+}
+
+void rebx_record_params_set_file(struct rebx_extras* const rebx, struct rebx_operator* const operator, const char* const filename){
+    struct rebx_rp_buffer* const buffer = rebx_rp_get_buffer(rebx, operator);
+    if (buffer == NULL){
+        return;
+    }
+    rebx_rp_write(rebx, buffer);
+    free(buffer->filename);
+    buffer->filename = NULL;
+    FILE* of = fopen(filename, "wb");
+    if (of == NULL){
+        rebx_error(rebx, "REBOUNDx Error: Can not open record_params file.\n");
+        return;
+    }
+    const int32_t N_channels = buffer->N_channels;
+    fwrite(&N_channels, sizeof(N_channels), 1, of);
+    fclose(of);
+    buffer->filename = rebx_malloc(rebx, strlen(filename) + 1); // +1 for \0 at end
+    if (buffer->filename == NULL){
+        return;
+    }
+    strcpy(buffer->filename, filename);
+    rebx_rp_write(rebx, buffer); // rows so far go to the new file
+}
+
+void rebx_record_params_flush(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_rp_buffer* const buffer = rebx_get_param(rebx, operator->ap, "rp_buffer");
+    if (buffer == NULL){
+        return;
+    }
+    rebx_rp_write(rebx, buffer);
+}
+
+double* rebx_record_params_buffer(struct rebx_extras* const rebx, struct rebx_operator* const operator, int* const N_channels, int* const capacity, int* const N_rows, int* const head){
+    struct rebx_rp_buffer* const buffer = rebx_get_param(rebx, operator->ap, "rp_buffer");
+    if (buffer == NULL){
+        *N_channels = 0;
+        *capacity = 0;
+        *N_rows = 0;
+        *head = 0;
+        return NULL;
+    }
+    *N_channels = buffer->N_channels;
+    *capacity = buffer->capacity;
+    *N_rows = buffer->N_rows;
+    *head = buffer->head;
+    return buffer->data;
+}
@@ -0,0 +1,410 @@
+/**
+ * @file    running_stats.c
+ * @brief   Accumulate running statistics of orbital elements and particle parameters during an integration.
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
+ *
+ * $Miscellaneous Utilities$     // Effect category (must be the first non-blank line after dollar signs and between dollar signs to be detected by script).
+ *
+ * ======================= ===============================================
+ * Authors                 D. Tamayo
+ * Implementation Paper    `Tamayo, Rein, Shi and Hernandez, 2019 <https://ui.adsabs.harvard.edu/abs/2020MNRAS.491.2885T/abstract>`_.
+ * Based on                `Welford 1962 <https://doi.org/10.1080/00401706.1962.10490022>`_.
+ * C Example               :ref:`c_example_running_stats`
+ * Python Example          None
+ * ======================= ===============================================
+ *
+ * Keeps a running count, mean, variance, minimum and maximum of chosen quantities for every particle, so that time averages and extrema
+ * can be obtained without writing and post-processing snapshots. Quantities are added by name with rebx_running_stats_add (or
+ * Extras.running_stats_add in Python), and can be heliocentric orbital elements (a, e, inc, Omega, omega, pomega, f, M, l, P) or any
+ * particle parameter of type double (e.g., tau_a or a user-registered parameter). Particles without a given parameter are skipped for that quantity.
+ *
+ * The means and variances are updated with Welford's algorithm, which is numerically stable over long integrations. The variance is the
+ * population variance (divided by the number of samples). Angles are unwrapped between samples before being accumulated, so their
+ * min and max track a continuous angle; for a librating angle, half of (max - min) gives the libration amplitude. This requires sampling
+ * often enough that angles advance by less than pi between samples. The orbital elements are taken from the shared per-step heliocentric orbits,
+ * so they are computed once per particle no matter how many quantities (or other effects) use them.
+ *
+ * Each time a particle is sampled, its statistics for a quantity are written to the particle parameters <name>_mean, <name>_var, <name>_min and <name>_max
+ * (e.g., a_mean or tau_a_max), which rebx_running_stats_add registers as doubles. They can be read like any other particle parameter, and in bulk (along with the
+ * number of samples) with rebx_running_stats_get (or Extras.running_stats in Python). Writing them costs four parameter lookups per particle and quantity,
+ * so use rs_interval to sample less often in large simulations.
+ * If the number of particles changes, or a quantity is added after sampling has started, all statistics are reset and the parameters removed until the next sample.
+ *
+ * **Effect Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * rs_interval (int)            No          Only sample every rs_interval-th timestep (default 1)
+ * ============================ =========== ==================================================================
+ *
+ * **Particle Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * <name>_mean (double)         No          Running mean of quantity <name>, set by the operator
+ * <name>_var (double)          No          Running (population) variance of quantity <name>, set by the operator
+ * <name>_min (double)          No          Minimum of quantity <name>, set by the operator
+ * <name>_max (double)          No          Maximum of quantity <name>, set by the operator
+ * ============================ =========== ==================================================================
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+#include "core.h"
+#include "rebxtools.h"
+
+enum rebx_rs_element{
+    REBX_RS_A,
+    REBX_RS_E,
+    REBX_RS_INC,
+    REBX_RS_OMEGA_NODE,
+    REBX_RS_OMEGA_PERI,
+    REBX_RS_POMEGA,
+    REBX_RS_F,
+    REBX_RS_M,
+    REBX_RS_L,
+    REBX_RS_P,
+    REBX_RS_N_ELEMENTS,
+};
+
+static const char* const rebx_rs_element_names[REBX_RS_N_ELEMENTS] = {"a", "e", "inc", "Omega", "omega", "pomega", "f", "M", "l", "P"};
+static const int rebx_rs_element_is_angle[REBX_RS_N_ELEMENTS] = {0, 0, 0, 1, 1, 1, 1, 1, 1, 0};
+
+enum rebx_rs_stat{
+    REBX_RS_MEAN,
+    REBX_RS_VAR,
+    REBX_RS_MIN,
+    REBX_RS_MAX,
+    REBX_RS_N_STATS,
+};
+
+static const char* const rebx_rs_stat_suffixes[REBX_RS_N_STATS] = {"_mean", "_var", "_min", "_max"};
+
+struct rebx_rs_quantity{
+    char* name;                 // Element or parameter name
+    int element;                // enum rebx_rs_element, or -1 for a particle parameter
+    char* stat_names[REBX_RS_N_STATS];  // Names of the particle parameters the statistics are written to
+};
+
+struct rebx_rs_accumulator{
+    long long n;                // Number of samples
+    double mean;
+    double M2;                  // Sum of squared deviations from the mean
+    double min;
+    double max;
+    double last;                // Last sampled value (unwrapped for angles)
+};
+
+struct rebx_rs_tables{
+    int N_quantities;
+    struct rebx_rs_quantity* quantities;
+    int N;                      // Number of particles (rows)
+    struct rebx_rs_accumulator* acc;    // N*N_quantities accumulators, one row per particle
+    long long calls;            // Number of times the operator has been called
+};
+
+static void rebx_rs_free_arrays(struct rebx_extras* rebx, struct rebx_operator* operator){
+    struct rebx_rs_tables* tables = rebx_get_param(rebx, operator->ap, "rs_tables");
+    if (tables == NULL){
+        return;
+    }
+    for (int q=0; q<tables->N_quantities; q++){
+        free(tables->quantities[q].name);
+        for (int k=0; k<REBX_RS_N_STATS; k++){
+            free(tables->quantities[q].stat_names[k]);
+        }
+    }
+    free(tables->quantities);
+    free(tables->acc);
+    free(tables);
+}
+
+static struct rebx_rs_tables* rebx_rs_get_tables(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_rs_tables* tables = rebx_get_param(rebx, operator->ap, "rs_tables");
+    if (tables == NULL){
+        tables = rebx_malloc(rebx, sizeof(*tables));
+        if (tables == NULL){
+            return NULL;
+        }
+        memset(tables, 0, sizeof(*tables));
+        rebx_set_param_pointer(rebx, &operator->ap, "rs_tables", tables);
+        rebx_set_param_pointer(rebx, &operator->ap, "free_arrays", rebx_rs_free_arrays);
+    }
+    return tables;
+}
+
+// Removes the statistics parameters from the first N particles, so that none are left over from before a reset.
+static void rebx_rs_remove_params(struct rebx_extras* const rebx, const struct rebx_rs_tables* const tables, const int N){
+    struct reb_particle* const ps = rebx->sim->particles;
+    for (int i=0; i<N; i++){
+        for (int q=0; q<tables->N_quantities; q++){
+            for (int k=0; k<REBX_RS_N_STATS; k++){
+                rebx_remove_param(rebx, (struct rebx_node**)&ps[i].ap, tables->quantities[q].stat_names[k]);
+            }
+        }
+    }
+}
+
+// Returns 0 (with an error set) if the accumulators could not be allocated.
+static int rebx_rs_reset(struct rebx_extras* const rebx, struct rebx_rs_tables* const tables, const int N){
+    const size_t Nacc = (size_t)N*tables->N_quantities;
+    free(tables->acc);
+    tables->acc = rebx_malloc(rebx, Nacc*sizeof(*tables->acc));
+    if (tables->acc == NULL && Nacc > 0){
+        tables->N = 0;
+        return 0;
+    }
+    tables->N = N;
+    for (size_t k=0; k<Nacc; k++){
+        tables->acc[k] = (struct rebx_rs_accumulator){.n=0, .mean=0., .M2=0., .min=INFINITY, .max=-INFINITY, .last=0.};
+    }
+    return 1;
+}
+
+static void rebx_rs_write_params(struct rebx_extras* const rebx, struct reb_particle* const p, const struct rebx_rs_quantity* const quantity, const struct rebx_rs_accumulator* const acc){
+    struct rebx_node** const apptr = (struct rebx_node**)&p->ap;
+    rebx_set_param_double(rebx, apptr, quantity->stat_names[REBX_RS_MEAN], acc->mean);
+    rebx_set_param_double(rebx, apptr, quantity->stat_names[REBX_RS_VAR], acc->M2/acc->n);
+    rebx_set_param_double(rebx, apptr, quantity->stat_names[REBX_RS_MIN], acc->min);
+    rebx_set_param_double(rebx, apptr, quantity->stat_names[REBX_RS_MAX], acc->max);
+}
+
+static inline double rebx_rs_element(const struct reb_orbit* const o, const int element){
+    switch (element){
+        case REBX_RS_A:             return o->a;
+        case REBX_RS_E:             return o->e;
+        case REBX_RS_INC:           return o->inc;
+        case REBX_RS_OMEGA_NODE:    return o->Omega;
+        case REBX_RS_OMEGA_PERI:    return o->omega;
+        case REBX_RS_POMEGA:        return o->pomega;
+        case REBX_RS_F:             return o->f;
+        case REBX_RS_M:             return o->M;
+        case REBX_RS_L:             return o->l;
+        case REBX_RS_P:             return o->P;
+        default:                    return NAN;
+    }
+}
+
+static inline void rebx_rs_update(struct rebx_rs_accumulator* const acc, double x, const int is_angle){
+    if (is_angle && acc->n > 0){
+        double dx = x - acc->last;
+        dx -= 2.*M_PI*round(dx/(2.*M_PI));  // shortest angular difference from last sample
+        x = acc->last + dx;
+    }
+    acc->n++;
+    const double delta = x - acc->mean;
+    acc->mean += delta/acc->n;
+    acc->M2 += delta*(x - acc->mean);
+    if (x < acc->min){
+        acc->min = x;
+    }
+    if (x > acc->max){
+        acc->max = x;
+    }
+    acc->last = x;
+}
+
+void rebx_running_stats(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
+    struct rebx_extras* const rebx = sim->extras;
+    struct rebx_rs_tables* const tables = rebx_get_param(rebx, operator->ap, "rs_tables");
+    if (tables == NULL || tables->N_quantities == 0){
+        reb_simulation_error(sim, "REBOUNDx Error: No quantities added to running_stats operator. Use rebx_running_stats_add.\n");
+        return;
+    }
+    const int* const rs_interval = rebx_get_param(rebx, operator->ap, "rs_interval");
+    const long long call = tables->calls++;
+    if (rs_interval != NULL && *rs_interval > 1 && call % *rs_interval != 0){
+        return;
+    }
+
+    const int N_real = sim->N - sim->N_var;
+    if (tables->N != N_real){
+        if (tables->N != 0){
+            reb_simulation_warning(sim, "REBOUNDx Warning: Number of particles changed. Resetting running_stats tables.\n");
+            rebx_rs_remove_params(rebx, tables, N_real);
+        }
+        if (!rebx_rs_reset(rebx, tables, N_real)){
+            return;
+        }
+    }
+
+    const struct reb_orbit* orbits = NULL;
+    for (int q=0; q<tables->N_quantities; q++){
+        if (tables->quantities[q].element >= 0){
+            orbits = rebx_heliocentric_orbits(rebx);
+            if (orbits == NULL){
+                return;
+            }
+            break;
+        }
+    }
+
+    struct reb_particle* const ps = sim->particles;
+    const int N_quantities = tables->N_quantities;
+    for (int i=0; i<N_real; i++){
+        struct rebx_rs_accumulator* const row = &tables->acc[(size_t)i*N_quantities];
+        for (int q=0; q<N_quantities; q++){
+            const struct rebx_rs_quantity* const quantity = &tables->quantities[q];
+            double x;
+            int is_angle = 0;
+            if (quantity->element >= 0){
+                x = rebx_rs_element(&orbits[i], quantity->element);
+                is_angle = rebx_rs_element_is_angle[quantity->element];
+            }
+            else{
+                const double* const param = rebx_get_param(rebx, ps[i].ap, quantity->name);
+                if (param == NULL){
+                    continue;
+                }
+                x = *param;
+            }
+            if (isnan(x)){
+                continue;   // e.g., the primary's elements, or a particle on a radial orbit
+            }
+            rebx_rs_update(&row[q], x, is_angle);
+            rebx_rs_write_params(rebx, &ps[i], quantity, &row[q]);
+        }
+    }
+}
+
+int rebx_running_stats_add(struct rebx_extras* const rebx, struct rebx_operator* const operator, const char* const name){
+    int element = -1;
+    for (int k=0; k<REBX_RS_N_ELEMENTS; k++){
+        if (strcmp(name, rebx_rs_element_names[k]) == 0){
+            element = k;
+            break;
+        }
+    }
+    if (element < 0 && rebx_get_type(rebx, name) != REBX_TYPE_DOUBLE){
+        char str[300];
+        sprintf(str, "REBOUNDx Error: running_stats quantity '%.100s' is neither an orbital element (a, e, inc, Omega, omega, pomega, f, M, l, P) nor a registered parameter of type double.\n", name);
+        rebx_error(rebx, str);
+        return -1;
+    }
+    char stat_names[REBX_RS_N_STATS][128];
+    for (int k=0; k<REBX_RS_N_STATS; k++){
+        snprintf(stat_names[k], sizeof(stat_names[k]), "%.100s%s", name, rebx_rs_stat_suffixes[k]);
+        const enum rebx_param_type type = rebx_get_type(rebx, stat_names[k]);
+        if (type != REBX_TYPE_NONE && type != REBX_TYPE_DOUBLE){
+            char str[300];
+            snprintf(str, sizeof(str), "REBOUNDx Error: running_stats needs parameter '%.120s' for its statistics, but it is already registered with a type other than double.\n", stat_names[k]);
+            rebx_error(rebx, str);
+            return -1;
+        }
+    }
+    struct rebx_rs_tables* const tables = rebx_rs_get_tables(rebx, operator);
+    if (tables == NULL){
+        return -1;
+    }
+    for (int q=0; q<tables->N_quantities; q++){
+        if (strcmp(name, tables->quantities[q].name) == 0){
+            return q;
+        }
+    }
+    const int q = tables->N_quantities;
+    struct rebx_rs_quantity* const quantities = realloc(tables->quantities, (q+1)*sizeof(*tables->quantities));
+    if (quantities == NULL){
+        rebx_error(rebx, "REBOUNDx Error: Could not allocate memory.\n");
+        return -1;
+    }
+    tables->quantities = quantities;
+    struct rebx_rs_quantity* const quantity = &quantities[q];
+    int success = 1;
+    quantity->element = element;
+    quantity->name = rebx_malloc(rebx, strlen(name) + 1); // +1 for \0 at end
+    success &= (quantity->name != NULL);
+    for (int k=0; k<REBX_RS_N_STATS; k++){
+        quantity->stat_names[k] = rebx_malloc(rebx, strlen(stat_names[k]) + 1);
+        success &= (quantity->stat_names[k] != NULL);
+    }
+    if (!success){
+        free(quantity->name);
+        for (int k=0; k<REBX_RS_N_STATS; k++){
+            free(quantity->stat_names[k]);
+        }
+        return -1;
+    }
+    strcpy(quantity->name, name);
+    for (int k=0; k<REBX_RS_N_STATS; k++){
+        strcpy(quantity->stat_names[k], stat_names[k]);
+        if (rebx_get_type(rebx, stat_names[k]) == REBX_TYPE_NONE){
+            rebx_register_param(rebx, stat_names[k], REBX_TYPE_DOUBLE);
+        }
+    }
+    if (tables->N != 0){
+        reb_simulation_warning(rebx->sim, "REBOUNDx Warning: Quantity added to running_stats after sampling started. Resetting running_stats tables.\n");
+        rebx_rs_remove_params(rebx, tables, tables->N);
+    }
+    tables->N_quantities++;
+    rebx_rs_reset(rebx, tables, tables->N);
+    return q;
+}
+
+int rebx_running_stats_N(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_rs_tables* tables = rebx_get_param(rebx, operator->ap, "rs_tables");
+    return tables == NULL ? 0 : tables->N;
+}
+
+void rebx_running_stats_get(struct rebx_extras* const rebx, struct rebx_operator* const operator, const char* const name, long long* const n, double* const mean, double* const var, double* const min, double* const max){
+    struct rebx_rs_tables* tables = rebx_get_param(rebx, operator->ap, "rs_tables");
+    if (tables == NULL){
+        rebx_error(rebx, "REBOUNDx Error: running_stats tables not found. Quantities must be added with rebx_running_stats_add before they can be read.\n");
+        return;
+    }
+    int q = 0;
+    while (q < tables->N_quantities && strcmp(name, tables->quantities[q].name) != 0){
+        q++;
+    }
+    if (q == tables->N_quantities){
+        char str[300];
+        sprintf(str, "REBOUNDx Error: Quantity '%.100s' was not added to the running_stats operator.\n", name);
+        rebx_error(rebx, str);
+        return;
+    }
+    for (int i=0; i<tables->N; i++){
+        const struct rebx_rs_accumulator* const acc = &tables->acc[(size_t)i*tables->N_quantities + q];
+        const int empty = (acc->n == 0);
+        if (n)      n[i] = acc->n;
+        if (mean)   mean[i] = empty ? NAN : acc->mean;
+        if (var)    var[i] = empty ? NAN : acc->M2/acc->n;
+        if (min)    min[i] = empty ? NAN : acc->min;
+        if (max)    max[i] = empty ? NAN : acc->max;
+    }
+}
+
+void rebx_running_stats_reset(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_rs_tables* tables = rebx_get_param(rebx, operator->ap, "rs_tables");
+    if (tables == NULL){
+        return;
+    }
+    tables->calls = 0;
+    rebx_rs_remove_params(rebx, tables, tables->N);
+    rebx_rs_reset(rebx, tables, tables->N);
+}
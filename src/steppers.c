@@ -37,19 +37,44 @@
  *
  * These are wrapper functions to taking steps with several of REBOUND's integrators in order to build custom splitting schemes.
  *
+ * The kick operator recomputes all accelerations (gravity and REBOUNDx forces). When gravity is already handled by other steps (e.g., kepler and interaction),
+ * the kick_forces operator kicks the velocities with only REBOUNDx forces, skipping the N-body gravity calculation. It uses the force set as its force parameter,
+ * or all the forces added to REBOUNDx if not set (add several kick_forces operators to kick with a subset of forces). Positions are not modified.
+ * Velocity-dependent forces are evaluated at the velocities at the start of the kick.
+ *
+ * The ias15_group operator integrates only the particles with the ias15_group parameter set to 1 (e.g., a planet and the particles undergoing close encounters with it)
+ * with IAS15, so each force evaluation costs O(N_group*N) rather than O(N^2). The remaining massive particles act on the group as an external field,
+ * interpolated over the step between their states at the start and their states at the end predicted along unperturbed orbits around particles[0].
+ * Particles outside the group are not moved, and the group does not include REBOUNDx forces (add a kick_forces operator for those).
+ *
  * **Effect Parameters**
  *
- * None
+ * Only used by kick_forces.
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * force (rebx_force)           No          Force to kick with. If not set, uses all forces added with rebx_add_force.
+ * ============================ =========== ==================================================================
  * 
  * **Particle Parameters**
  *
- * None
+ * Only used by ias15_group.
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * ias15_group (int)            No          Set to 1 to include the particle in the group integrated by ias15_group
+ * ============================ =========== ==================================================================
  *
  */
 
 #include <math.h>
+#include <stdlib.h>
 #include "rebound.h"
 #include "reboundx.h"
+#include "core.h"
+#include "rebxtools.h"
 
 // will do IAS with gravity + any additional_forces
 
@@ -73,6 +98,156 @@ void rebx_ias15_step(struct reb_simulation* const sim, struct rebx_operator* con
     sim->dt = old_dt; // reset in case this is part of a chain of steps
 }
 
+// Massive particles outside the group, whose states at the start and (predicted) end of the step are interpolated to get their pull on the group
+struct rebx_ias15_group_field{
+    int N;
+    double h;                       // Length of the step
+    struct reb_particle* ps0;       // States at the start of the step
+    struct reb_particle* ps1;       // Predicted states at the end of the step
+};
+
+// Predicts the state of a field particle after dt, assuming an unperturbed heliocentric orbit around a primary drifting at constant velocity
+static struct reb_particle rebx_ias15_group_predict(const double G, const struct reb_particle p, const struct reb_particle primary, const int is_primary, const double dt){
+    struct reb_particle primary1 = primary;
+    primary1.x += dt*primary.vx;
+    primary1.y += dt*primary.vy;
+    primary1.z += dt*primary.vz;
+    if (is_primary){
+        return primary1;
+    }
+    int err=0;
+    struct reb_orbit o = reb_orbit_from_particle_err(G, p, primary, &err);
+    struct reb_particle p1 = p;
+    if (err || o.e >= 1.){ // drift
+        p1.x += dt*p.vx;
+        p1.y += dt*p.vy;
+        p1.z += dt*p.vz;
+        return p1;
+    }
+    const double f = reb_M_to_f(o.e, o.M + o.n*dt);
+    p1 = reb_particle_from_orbit(G, primary1, p.m, o.a, o.e, o.inc, o.Omega, o.omega, f);
+    p1.r = p.r;
+    p1.hash = p.hash;
+    return p1;
+}
+
+static void rebx_ias15_group_field_forces(struct reb_simulation* const r){
+    const struct rebx_ias15_group_field* const field = r->extras;
+    const double G = r->G;
+    const double softening2 = r->softening*r->softening;
+    const double s = r->t/field->h;
+    struct reb_particle* const particles = r->particles;
+    const int N = r->N;
+    for (int k=0; k<field->N; k++){
+        const struct reb_particle source = rebx_hermite_interpolate(field->ps0[k], field->ps1[k], field->h, s);
+        for (int i=0; i<N; i++){
+            const double dx = particles[i].x - source.x;
+            const double dy = particles[i].y - source.y;
+            const double dz = particles[i].z - source.z;
+            const double r2 = dx*dx + dy*dy + dz*dz + softening2;
+            const double prefac = G*source.m/(r2*sqrt(r2));
+            particles[i].ax -= prefac*dx;
+            particles[i].ay -= prefac*dy;
+            particles[i].az -= prefac*dz;
+        }
+    }
+}
+
+void rebx_ias15_group_step(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
+    struct rebx_extras* const rebx = sim->extras;
+    const int N_real = sim->N - sim->N_var;
+    struct reb_particle* const ps = sim->particles;
+    if (dt == 0. || N_real == 0){
+        return;
+    }
+
+    int* const group = rebx_malloc(rebx, N_real*sizeof(*group));
+    if (group == NULL){
+        return;
+    }
+    int N_group = 0;
+    int N_active_group = 0;
+    for (int i=0; i<N_real; i++){
+        const int* const flag = rebx_get_param(rebx, ps[i].ap, "ias15_group");
+        if (flag != NULL && *flag){
+            group[N_group++] = i;
+            if (sim->N_active == -1 || i < sim->N_active){
+                N_active_group++;
+            }
+        }
+    }
+    if (N_group == 0){
+        free(group);
+        return;
+    }
+
+    struct rebx_ias15_group_field field = {.N = 0, .h = dt};
+    field.ps0 = rebx_malloc(rebx, (N_real - N_group + 1)*sizeof(*field.ps0)); // +1 so that an empty field is not mistaken for a failed allocation
+    field.ps1 = rebx_malloc(rebx, (N_real - N_group + 1)*sizeof(*field.ps1));
+    if (field.ps0 == NULL || field.ps1 == NULL){
+        free(field.ps0);
+        free(field.ps1);
+        free(group);
+        return;
+    }
+    const int N_massive = (sim->N_active == -1 || sim->testparticle_type == 1) ? N_real : sim->N_active; // group doesn't feel test particles in the field
+    for (int i=0, j=0; i<N_massive; i++){
+        if (j < N_group && group[j] == i){
+            j++;
+            continue;
+        }
+        if (ps[i].m == 0.){
+            continue;
+        }
+        field.ps0[field.N] = ps[i];
+        field.ps1[field.N] = rebx_ias15_group_predict(sim->G, ps[i], ps[0], i==0, dt);
+        field.N++;
+    }
+
+    struct reb_simulation* const gsim = reb_simulation_create();
+    gsim->G = sim->G;
+    gsim->softening = sim->softening;
+    gsim->ri_ias15.epsilon = sim->ri_ias15.epsilon;
+    gsim->ri_ias15.min_dt = sim->ri_ias15.min_dt;
+    gsim->ri_ias15.adaptive_mode = sim->ri_ias15.adaptive_mode;
+    gsim->testparticle_type = sim->testparticle_type;
+    for (int j=0; j<N_group; j++){
+        struct reb_particle p = ps[group[j]];
+        p.ap = NULL;
+        p.sim = NULL;
+        p.c = NULL;
+        reb_simulation_add(gsim, p);
+    }
+    gsim->N_active = (sim->N_active == -1) ? -1 : N_active_group;
+    gsim->extras = &field;
+    gsim->additional_forces = rebx_ias15_group_field_forces;
+
+    // same as rebx_ias15_step on the group's simulation, with t running from 0 to dt
+    gsim->t = 0.;
+    gsim->dt = 0.0001*dt;
+    reb_integrator_ias15_reset(gsim);
+    while(fabs(gsim->t) < fabs(dt) && fabs(gsim->dt/dt)>1e-14 ){
+        reb_simulation_update_acceleration(gsim);
+        reb_integrator_ias15_part2(gsim);
+        if (fabs(gsim->t+gsim->dt) > fabs(dt)){
+            gsim->dt = dt-gsim->t;
+        }
+    }
+
+    for (int j=0; j<N_group; j++){
+        const struct reb_particle p = gsim->particles[j];
+        struct reb_particle* const q = &ps[group[j]];
+        q->x = p.x; q->y = p.y; q->z = p.z;
+        q->vx = p.vx; q->vy = p.vy; q->vz = p.vz;
+    }
+
+    gsim->extras = NULL;
+    reb_simulation_free(gsim);
+    free(field.ps0);
+    free(field.ps1);
+    free(group);
+}
+
 void rebx_kepler_step(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
     reb_integrator_whfast_init(sim);
     reb_integrator_whfast_from_inertial(sim);
@@ -96,25 +271,78 @@ void rebx_interaction_step(struct reb_simulation* const sim, struct rebx_operato
     reb_integrator_whfast_to_inertial(sim);
 }
 
+void rebx_tuning_set_defaults(struct rebx_tuning* const tuning){
+    tuning->omp_threshold = 512;
+    tuning->omp_chunk = 1;
+    tuning->simd = 0;
+}
+
+// The loops below run in parallel only above tuning->omp_threshold particles, where the gain outweighs the cost of starting the threads.
+void rebx_drift_particles(const struct rebx_tuning* const tuning, struct reb_particle* restrict const particles, const int N, const double dt){
+    if (tuning->simd){
+#pragma omp parallel for simd schedule(guided, tuning->omp_chunk) if(N >= tuning->omp_threshold)
+        for (int i=0;i<N;i++){
+            particles[i].x  += dt * particles[i].vx;
+            particles[i].y  += dt * particles[i].vy;
+            particles[i].z  += dt * particles[i].vz;
+        }
+    }
+    else{
+#pragma omp parallel for schedule(guided, tuning->omp_chunk) if(N >= tuning->omp_threshold)
+        for (int i=0;i<N;i++){
+            particles[i].x  += dt * particles[i].vx;
+            particles[i].y  += dt * particles[i].vy;
+            particles[i].z  += dt * particles[i].vz;
+        }
+    }
+}
+
+void rebx_kick_particles(const struct rebx_tuning* const tuning, struct reb_particle* restrict const particles, const int N, const double dt){
+    if (tuning->simd){
+#pragma omp parallel for simd schedule(guided, tuning->omp_chunk) if(N >= tuning->omp_threshold)
+        for (int i=0;i<N;i++){
+            particles[i].vx += dt * particles[i].ax;
+            particles[i].vy += dt * particles[i].ay;
+            particles[i].vz += dt * particles[i].az;
+        }
+    }
+    else{
+#pragma omp parallel for schedule(guided, tuning->omp_chunk) if(N >= tuning->omp_threshold)
+        for (int i=0;i<N;i++){
+            particles[i].vx += dt * particles[i].ax;
+            particles[i].vy += dt * particles[i].ay;
+            particles[i].vz += dt * particles[i].az;
+        }
+    }
+}
+
 void rebx_drift_step(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
-	const int N = sim->N;
-	struct reb_particle* restrict const particles = sim->particles;
-#pragma omp parallel for schedule(guided)
-	for (int i=0;i<N;i++){
-		particles[i].x  += dt * particles[i].vx;
-		particles[i].y  += dt * particles[i].vy;
-		particles[i].z  += dt * particles[i].vz;
-	}
+    struct rebx_extras* const rebx = sim->extras;
+    rebx_drift_particles(&rebx->tuning, sim->particles, sim->N, dt);
 }
 
 void rebx_kick_step(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
+    struct rebx_extras* const rebx = sim->extras;
     reb_simulation_update_acceleration(sim);
-	const int N = sim->N;
+    rebx_kick_particles(&rebx->tuning, sim->particles, sim->N, dt);
+}
+
+void rebx_kick_forces_step(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
+    struct rebx_extras* const rebx = sim->extras;
+    const int N = sim->N - sim->N_var;
 	struct reb_particle* restrict const particles = sim->particles;
-#pragma omp parallel for schedule(guided)
-	for (int i=0;i<N;i++){
-		particles[i].vx += dt * particles[i].ax;
-		particles[i].vy += dt * particles[i].ay;
-		particles[i].vz += dt * particles[i].az;
-	}
+    rebx_reset_accelerations(particles, N);
+
+    struct rebx_force* const force = operator ? rebx_get_param(rebx, operator->ap, "force") : NULL;
+    if (force){
+        rebx_update_accelerations(sim, force, particles, N);
+    }
+    else{
+        for (struct rebx_node* current = rebx->additional_forces; current != NULL; current = current->next){
+            struct rebx_force* const f = current->object;
+            rebx_update_accelerations(sim, f, particles, N);
+        }
+    }
+
+    rebx_kick_particles(&rebx->tuning, particles, N, dt);
 }
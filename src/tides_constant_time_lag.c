@@ -169,6 +169,10 @@ void rebx_tides_constant_time_lag(struct reb_simulation* const sim, struct rebx_
     }
 }
 
+// Tidal forces on a body scale with the mass of the body raising the tide, so test particles neither raise tides nor feel them
+void rebx_tides_constant_time_lag_testparticles(struct reb_simulation* const sim, struct rebx_force* const tides, struct reb_particle* const particles, const int N_active, const int N){
+}
+
 // Calculate potential of conservative piece of tidal interaction
 static double rebx_calculate_tides_potential(struct reb_particle* source, struct reb_particle* target, const double G, const double k2){
     const double ms = source->m;
@@ -0,0 +1,206 @@
+/**
+ * @file    tides_constant_time_lag_averaged.c
+ * @brief   Orbit-averaged constant time lag tides, applied by directly changing orbital elements and spins between timesteps.
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * The section after the dollar signs gets built into the documentation by a script.  All lines must start with space * space like below.
+ * Tables always must be preceded and followed by a blank line.  See http://docutils.sourceforge.net/docs/user/rst/quickstart.html for a primer on rst.
+ * $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
+ *
+ * $Tides$       // Effect category (must be the first non-blank line after dollar signs and between dollar signs to be detected by script).
+ *
+ * ======================= ===============================================
+ * Authors                 D. Tamayo
+ * Implementation Paper    None
+ * Based on                `Hut 1981 <https://ui.adsabs.harvard.edu/#abs/1981A&A....99..126H/abstract>`_.
+ * C Example               :ref:`c_example_tides_constant_time_lag_averaged`.
+ * Python Example          None
+ * ======================= ===============================================
+ *
+ * This is the orbit-averaged counterpart of tides_constant_time_lag, for following tidal circularization, orbital decay and spin evolution over many tidal timescales.
+ * Rather than adding the instantaneous tidal force at every substep, it changes each body's osculating semimajor axis and eccentricity (relative to the primary, particles[0]),
+ * and the spin rates OmegaMag, according to Hut's (1981) secular equations (his Eqs. 9-11), integrated across each operator step with a 4th order Runge-Kutta step.
+ * It therefore works with WHFast at timesteps spanning many orbits, as long as the timestep is short compared to the tidal evolution timescales.
+ *
+ * It uses the same particle parameters as tides_constant_time_lag: tides raised on the primary (from each body) and on each body (from the primary) are included
+ * whenever the respective body has tctl_k2, tctl_tau and a physical radius set. As in tides_constant_time_lag, spins are assumed aligned with the orbit normal and no
+ * planet-planet tides are included. Spins only evolve for bodies that also have their moment of inertia I set; otherwise OmegaMag is held fixed.
+ * Without I, the secular changes in a and e agree with the orbit-average of tides_constant_time_lag.
+ *
+ * **Effect Parameters**
+ *
+ * If coordinates not set, defaults to using Jacobi coordinates.
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * coordinates (enum)           No          Type of elements to use for modification (Jacobi, barycentric or particle).
+ *                                          See the examples for usage.
+ * ============================ =========== ==================================================================
+ *
+ * **Particle Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * particles[i].r (float)       Yes         Physical radius (required for contribution from tides raised on the body).
+ * tctl_k2 (float)              Yes         Potential Love number of degree 2.
+ * tctl_tau (float)             Yes         Constant time lag. Bodies without it have no dissipation and no secular tidal evolution.
+ * OmegaMag (float)             No          Angular rotation frequency. If not set will default to 0.
+ * I (float)                    No          Moment of inertia. If set, OmegaMag evolves due to tidal torques.
+ * ============================ =========== ==================================================================
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+#include "rebxtools.h"
+
+// Tidal properties of a body being deformed. active is 0 if the body has no dissipative tides.
+struct rebx_tctl_body{
+    int active;
+    double m;
+    double R;
+    double k_over_T;            // Hut's k/T = (k2/2)*G*m*tau/R^3
+    double I;                   // Moment of inertia (0 if spin is held fixed)
+    double* Omega;              // Pointer to OmegaMag param (NULL if not set)
+};
+
+static struct rebx_tctl_body rebx_tctl_load_body(struct rebx_extras* const rebx, const struct reb_particle* const p, const double G){
+    struct rebx_tctl_body body = {0};
+    const double* const k2 = rebx_get_param(rebx, p->ap, "tctl_k2");
+    const double* const tau = rebx_get_param(rebx, p->ap, "tctl_tau");
+    if (k2 == NULL || tau == NULL || p->r == 0. || p->m == 0.){
+        return body;
+    }
+    body.active = 1;
+    body.m = p->m;
+    body.R = p->r;
+    body.k_over_T = 0.5*(*k2)*G*p->m*(*tau)/(p->r*p->r*p->r);
+    body.Omega = rebx_get_param(rebx, p->ap, "OmegaMag");
+    const double* const I = rebx_get_param(rebx, p->ap, "I");
+    if (I != NULL && body.Omega != NULL){
+        body.I = *I;
+    }
+    return body;
+}
+
+// Hut 1981 Eqs. 9-11 for tides raised on body by a companion of mass m_c. Adds to dadt and dedt, and returns dOmega/dt of body.
+static double rebx_tctl_hut(const struct rebx_tctl_body* const body, const double m_c, const double a, const double e, const double n, const double Omega, double* const dadt, double* const dedt){
+    const double e2 = e*e;
+    const double e4 = e2*e2;
+    const double e6 = e4*e2;
+    const double f1 = 1. + 31./2.*e2 + 255./8.*e4 + 185./16.*e6 + 25./64.*e6*e2;
+    const double f2 = 1. + 15./2.*e2 + 45./8.*e4 + 5./16.*e6;
+    const double f3 = 1. + 15./4.*e2 + 15./8.*e4 + 5./64.*e6;
+    const double f4 = 1. + 3./2.*e2 + 1./8.*e4;
+    const double f5 = 1. + 3.*e2 + 3./8.*e4;
+
+    const double q = m_c/body->m;
+    const double Ra = body->R/a;
+    const double Ra2 = Ra*Ra;
+    const double Ra6 = Ra2*Ra2*Ra2;
+    const double Ra8 = Ra6*Ra2;
+    const double ome2 = 1. - e2;
+    const double sqrt_ome2 = sqrt(ome2);
+    const double ome2_32 = ome2*sqrt_ome2;
+    const double ome2_6 = ome2*ome2*ome2*ome2*ome2*ome2;
+    const double ome2_132 = ome2_6*sqrt_ome2;
+    const double ome2_152 = ome2_132*ome2;
+    const double spin = Omega/n;
+
+    *dadt += -6.*body->k_over_T*q*(1.+q)*Ra8*a/ome2_152*(f1 - ome2_32*f2*spin);
+    *dedt += -27.*body->k_over_T*q*(1.+q)*Ra8*e/ome2_132*(f3 - 11./18.*ome2_32*f4*spin);
+    if (body->I == 0.){
+        return 0.;
+    }
+    return 3.*body->k_over_T*q*q*body->m*body->R*body->R/body->I*Ra6*n/ome2_6*(f2 - ome2_32*f5*spin);
+}
+
+// State y = (a, e, Omega_primary, Omega_body)
+static void rebx_tctl_derivatives(const struct rebx_tctl_body* const primary, const struct rebx_tctl_body* const body, const double GM, const double* const y, double* const dydt){
+    const double a = y[0];
+    const double e = y[1] > 0. ? y[1] : 0.;
+    const double n = sqrt(GM/(a*a*a));
+    dydt[0] = 0.;
+    dydt[1] = 0.;
+    dydt[2] = primary->active ? rebx_tctl_hut(primary, body->m, a, e, n, y[2], &dydt[0], &dydt[1]) : 0.;
+    dydt[3] = body->active ? rebx_tctl_hut(body, primary->m, a, e, n, y[3], &dydt[0], &dydt[1]) : 0.;
+}
+
+static struct reb_particle rebx_calculate_tides_constant_time_lag_averaged(struct reb_simulation* const sim, struct rebx_operator* const operator, struct reb_particle* p, struct reb_particle* source, const double dt){
+    struct rebx_extras* const rebx = sim->extras;
+    struct reb_particle* const star = &sim->particles[0]; // assumes nearly Keplerian motion around a single primary (particles[0]), like tides_constant_time_lag
+    if (p == star || p->m == 0. || star->m == 0.){
+        return *p;
+    }
+    struct rebx_tctl_body primary = rebx_tctl_load_body(rebx, star, sim->G);
+    struct rebx_tctl_body body = rebx_tctl_load_body(rebx, p, sim->G);
+    primary.m = star->m;    // masses are needed for q even if the body itself has no tides raised on it
+    body.m = p->m;
+    if (!primary.active && !body.active){
+        return *p;
+    }
+
+    int err=0;
+    struct reb_orbit o = reb_orbit_from_particle_err(sim->G, *p, *source, &err);
+    if(err || o.a <= 0. || o.e >= 1.){  // tidal equations only apply to bound orbits
+        return *p;
+    }
+
+    const double GM = sim->G*(source->m + p->m);
+    double y[4] = {o.a, o.e, primary.Omega ? *primary.Omega : 0., body.Omega ? *body.Omega : 0.};
+    double k[4][4];
+    double ytmp[4];
+    rebx_tctl_derivatives(&primary, &body, GM, y, k[0]);
+    for (int j=0; j<4; j++) ytmp[j] = y[j] + 0.5*dt*k[0][j];
+    rebx_tctl_derivatives(&primary, &body, GM, ytmp, k[1]);
+    for (int j=0; j<4; j++) ytmp[j] = y[j] + 0.5*dt*k[1][j];
+    rebx_tctl_derivatives(&primary, &body, GM, ytmp, k[2]);
+    for (int j=0; j<4; j++) ytmp[j] = y[j] + dt*k[2][j];
+    rebx_tctl_derivatives(&primary, &body, GM, ytmp, k[3]);
+    for (int j=0; j<4; j++){
+        y[j] += dt/6.*(k[0][j] + 2.*k[1][j] + 2.*k[2][j] + k[3][j]);
+    }
+
+    if (primary.I != 0.){
+        *primary.Omega = y[2];
+    }
+    if (body.I != 0.){
+        *body.Omega = y[3];
+    }
+    const double e = y[1] > 0. ? y[1] : 0.;
+    return reb_particle_from_orbit(sim->G, *source, p->m, y[0], e, o.inc, o.Omega, o.omega, o.f);
+}
+
+void rebx_tides_constant_time_lag_averaged(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
+    const int* const ptr = rebx_get_param(sim->extras, operator->ap, "coordinates");
+    enum REBX_COORDINATES coordinates = REBX_COORDINATES_JACOBI;
+    if (ptr != NULL){
+        coordinates = *ptr;
+    }
+    const int back_reactions_inclusive = 1;
+    const char* reference_name = "primary";
+    rebx_tools_com_ptm(sim, operator, coordinates, back_reactions_inclusive, reference_name, rebx_calculate_tides_constant_time_lag_averaged, dt);
+}
@@ -69,6 +69,7 @@
 #include <stdlib.h>
 #include <float.h>
 #include "reboundx.h"
+#include "core.h"
 
 struct reb_vec3d rebx_calculate_spin_orbit_accelerations(struct reb_particle* source, struct reb_particle* target, const double G, const double k2, const double sigma, const struct reb_vec3d Omega){
   // All quantities associated with SOURCE
@@ -309,7 +310,7 @@ void rebx_tides_spin(struct reb_simulation* const sim, struct rebx_force* const
     // check if ODE is initialized
     struct reb_ode** ode = sim->odes;
     if (ode == NULL){
-      reb_simulation_warning(sim, "Spin axes are not being evolved. Call rebx_spin_initialize_ode to evolve\n");
+      rebx_diagnostic(rebx, REBX_DIAGNOSTIC_SPIN_ODE_MISSING);
     }
 
     for (int i=0; i<N; i++){
@@ -342,6 +343,10 @@ void rebx_tides_spin(struct reb_simulation* const sim, struct rebx_force* const
     }
 }
 
+// Pairs with a massless body are skipped (see above), so test particles feel no spin or tidal forces
+void rebx_tides_spin_testparticles(struct reb_simulation* const sim, struct rebx_force* const effect, struct reb_particle* const particles, const int N_active, const int N){
+}
+
 // Calculate potential of conservative piece of interaction between a point mass target and a source with a tidally and rotationally induced quadrupole
 // Equation 31 in Eggleton et. al (1998)
 static double rebx_calculate_spin_potential(struct reb_particle* source, struct reb_particle* target, const double G, const double k2, const struct reb_vec3d Omega){
@@ -0,0 +1,378 @@
+/**
+ * @file    track_encounters.c
+ * @brief   Track minimum separations and encounter counts for all pairs between two groups of particles.
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
+ *
+ * $Miscellaneous Utilities$     // Effect category (must be the first non-blank line after dollar signs and between dollar signs to be detected by script).
+ *
+ * ======================= ===============================================
+ * Authors                 D. Tamayo
+ * Implementation Paper    `Tamayo, Rein, Shi and Hernandez, 2019 <https://ui.adsabs.harvard.edu/abs/2020MNRAS.491.2885T/abstract>`_.
+ * Based on                None
+ * C Example               :ref:`c_example_track_encounters`
+ * Python Example          None
+ * ======================= ===============================================
+ *
+ * This generalizes track_min_distance to many pairs at once. Particles are split into two groups, targets (e.g., planets) and tracked particles
+ * (e.g., asteroids), and every tracked particle is tracked against every target. The groups are set with the te_group particle parameter
+ * (1 for targets, 2 for tracked particles; particles without it are ignored). If no particle has te_group set, the massive bodies other than the primary
+ * (indices 1 to sim->N_active-1) are the targets and all test particles (indices sim->N_active to sim->N-1) are tracked.
+ * Pairs within the same group are not tracked. The groups are re-read when te_group is set or removed on any particle, or when the number of particles changes.
+ * For every (tracked, target) pair the operator stores the minimum separation reached while the pair was closer than ``te_radius``, and the number of
+ * distinct encounters (times the pair entered a sphere of radius ``te_radius``).
+ *
+ * Each step the tracked particles are binned into a uniform spatial hash with cell size ``te_radius``, so each target only checks the particles in its
+ * own and neighboring cells. The cost is therefore O(N) rather than O(N x N_targets) and does not involve any parameter lookups on individual particles.
+ * Separations are only sampled at the end of each timestep.
+ *
+ * The results are stored in tables with one row per tracked particle and one column per target, each in order of particle index. Use rebx_track_encounters_min_distances and
+ * rebx_track_encounters_counts (or the corresponding Extras methods in Python) to copy them out, and rebx_track_encounters_indices for the particle indices of
+ * the rows and columns. Pairs that never came within ``te_radius`` have a minimum distance of INFINITY. If the groups change (e.g., particles are removed), the tables are reset.
+ *
+ * **Effect Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * te_radius (double)           Yes         Separation (positive) below which a pair counts as an encounter and its distance is recorded
+ * ============================ =========== ==================================================================
+ *
+ * **Particle Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * te_group (int)               No          1 for targets, 2 for tracked particles. If no particle has it set, groups are split at sim->N_active
+ * ============================ =========== ==================================================================
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+#include "core.h"
+
+struct rebx_te_tables{
+    int N_real;                 // Number of particles when the groups were last read
+    int stale;                  // Set to 1 by the observer on te_group
+    struct rebx_param_observer* observer;
+    int N_targets;              // Number of target columns
+    int N_tracked;              // Number of tracked rows
+    int* targets;               // Particle indices of the targets
+    int* tracked;               // Particle indices of the tracked particles
+    double* min_distance;       // N_tracked*N_targets minimum separations
+    int* count;                 // N_tracked*N_targets encounter counts
+    long long* last_step;       // Step stamp at which the pair was last inside te_radius
+    long long step;             // Number of times the operator has been called
+    int N_buckets;              // Size of spatial hash (power of 2)
+    int* bucket_start;          // N_buckets+1 offsets into sorted
+    int* sorted;                // Tracked particle indices sorted by bucket
+    int* bucket_of;             // Bucket of each tracked particle
+};
+
+static void rebx_te_free_table_arrays(struct rebx_te_tables* const tables){
+    free(tables->targets);
+    free(tables->tracked);
+    free(tables->min_distance);
+    free(tables->count);
+    free(tables->last_step);
+    free(tables->bucket_start);
+    free(tables->sorted);
+    free(tables->bucket_of);
+    tables->targets = NULL;
+    tables->tracked = NULL;
+    tables->min_distance = NULL;
+    tables->count = NULL;
+    tables->last_step = NULL;
+    tables->bucket_start = NULL;
+    tables->sorted = NULL;
+    tables->bucket_of = NULL;
+    tables->N_targets = 0;
+    tables->N_tracked = 0;
+}
+
+static void rebx_te_free_arrays(struct rebx_extras* rebx, struct rebx_operator* operator){
+    struct rebx_te_tables* tables = rebx_get_param(rebx, operator->ap, "te_tables");
+    if (tables == NULL){
+        return;
+    }
+    if (tables->observer){
+        rebx_remove_param_observer(rebx, tables->observer);
+    }
+    rebx_te_free_table_arrays(tables);
+    free(tables);
+}
+
+// Fills newly allocated arrays with the particle indices of the targets and tracked particles. Returns 0 (with an error set) on failure.
+static int rebx_te_read_groups(struct reb_simulation* const sim, const int N_real, int** const targets, int* const N_targets, int** const tracked, int* const N_tracked){
+    struct rebx_extras* const rebx = sim->extras;
+    struct reb_particle* const ps = sim->particles;
+    *targets = rebx_malloc(rebx, (N_real+1)*sizeof(**targets));  // +1 so that N_real=0 is not mistaken for a failed allocation
+    *tracked = rebx_malloc(rebx, (N_real+1)*sizeof(**tracked));
+    if (*targets == NULL || *tracked == NULL){
+        free(*targets);
+        free(*tracked);
+        return 0;
+    }
+    *N_targets = 0;
+    *N_tracked = 0;
+    int grouped = 0;
+    for (int i=0; i<N_real; i++){
+        const int* const group = rebx_get_param(rebx, ps[i].ap, "te_group");
+        if (group == NULL){
+            continue;
+        }
+        grouped = 1;
+        if (*group == 1){
+            (*targets)[(*N_targets)++] = i;
+        }
+        else if (*group == 2){
+            (*tracked)[(*N_tracked)++] = i;
+        }
+    }
+    if (!grouped){
+        if (sim->N_active < 0){
+            reb_simulation_error(sim, "REBOUNDx Error: track_encounters needs te_group set on particles, or sim->N_active set to separate targets (massive bodies) from tracked test particles.\n");
+            free(*targets);
+            free(*tracked);
+            return 0;
+        }
+        const int N_active = sim->N_active < N_real ? sim->N_active : N_real;
+        for (int i=1; i<N_active; i++){
+            (*targets)[(*N_targets)++] = i;
+        }
+        for (int i=N_active; i<N_real; i++){
+            (*tracked)[(*N_tracked)++] = i;
+        }
+    }
+    return 1;
+}
+
+static struct rebx_te_tables* rebx_te_get_tables(struct reb_simulation* const sim, struct rebx_operator* const operator, const int N_real){
+    struct rebx_extras* const rebx = sim->extras;
+    struct rebx_te_tables* tables = rebx_get_param(rebx, operator->ap, "te_tables");
+    if (tables == NULL){
+        tables = rebx_malloc(rebx, sizeof(*tables));
+        if (tables == NULL){
+            return NULL;
+        }
+        memset(tables, 0, sizeof(*tables));
+        tables->N_real = -1;
+        tables->observer = rebx_add_param_observer(rebx, "te_group", NULL, NULL, &tables->stale);
+        rebx_set_param_pointer(rebx, &operator->ap, "te_tables", tables);
+        rebx_set_param_pointer(rebx, &operator->ap, "free_arrays", rebx_te_free_arrays);
+    }
+    if (!tables->stale && tables->N_real == N_real){
+        return tables;
+    }
+
+    int* targets;
+    int* tracked;
+    int N_targets, N_tracked;
+    if (!rebx_te_read_groups(sim, N_real, &targets, &N_targets, &tracked, &N_tracked)){
+        return NULL;
+    }
+    tables->stale = 0;
+    tables->N_real = N_real;
+    if (tables->targets != NULL && N_targets == tables->N_targets && N_tracked == tables->N_tracked
+            && memcmp(targets, tables->targets, N_targets*sizeof(*targets)) == 0 && memcmp(tracked, tables->tracked, N_tracked*sizeof(*tracked)) == 0){
+        free(targets);
+        free(tracked);
+        return tables;
+    }
+    if (tables->step > 0){
+        reb_simulation_warning(sim, "REBOUNDx Warning: Particles in track_encounters groups changed. Resetting track_encounters tables.\n");
+    }
+
+    rebx_te_free_table_arrays(tables);
+    const size_t Npairs = (size_t)N_targets*N_tracked;
+    int N_buckets = 1;
+    while (N_buckets < 2*N_tracked){
+        N_buckets *= 2;
+    }
+    tables->targets = targets;
+    tables->tracked = tracked;
+    tables->step = 0;
+    tables->N_buckets = N_buckets;
+    tables->min_distance = rebx_malloc(rebx, Npairs*sizeof(*tables->min_distance));
+    tables->count = rebx_malloc(rebx, Npairs*sizeof(*tables->count));
+    tables->last_step = rebx_malloc(rebx, Npairs*sizeof(*tables->last_step));
+    tables->bucket_start = rebx_malloc(rebx, (N_buckets+1)*sizeof(*tables->bucket_start));
+    tables->sorted = rebx_malloc(rebx, N_tracked*sizeof(*tables->sorted));
+    tables->bucket_of = rebx_malloc(rebx, N_tracked*sizeof(*tables->bucket_of));
+    if ((Npairs > 0 && (tables->min_distance == NULL || tables->count == NULL || tables->last_step == NULL))
+            || tables->bucket_start == NULL || (N_tracked > 0 && (tables->sorted == NULL || tables->bucket_of == NULL))){
+        rebx_te_free_table_arrays(tables);
+        tables->N_real = -1; // try again next step
+        return NULL;
+    }
+    tables->N_targets = N_targets;
+    tables->N_tracked = N_tracked;
+    for (size_t k=0; k<Npairs; k++){
+        tables->min_distance[k] = INFINITY;
+        tables->count[k] = 0;
+        tables->last_step[k] = -2;
+    }
+    return tables;
+}
+
+static inline int rebx_te_bucket(const int64_t ix, const int64_t iy, const int64_t iz, const int N_buckets){
+    const uint64_t h = ((uint64_t)ix*73856093ULL) ^ ((uint64_t)iy*19349663ULL) ^ ((uint64_t)iz*83492791ULL);
+    return (int)(h & (uint64_t)(N_buckets-1));
+}
+
+static inline int64_t rebx_te_cell(const double x, const double inv_h){
+    return (int64_t)floor(x*inv_h);
+}
+
+void rebx_track_encounters(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
+    struct rebx_extras* const rebx = sim->extras;
+    const double* const te_radius = rebx_get_param(rebx, operator->ap, "te_radius");
+    if (te_radius == NULL){
+        reb_simulation_error(sim, "REBOUNDx Error: Need to set te_radius parameter on track_encounters operator.\n");
+        return;
+    }
+    if (!(*te_radius > 0.)){ // also rejects NaN
+        reb_simulation_error(sim, "REBOUNDx Error: te_radius must be positive for track_encounters operator.\n");
+        return;
+    }
+    const int N_real = sim->N - sim->N_var;
+    struct rebx_te_tables* const tables = rebx_te_get_tables(sim, operator, N_real);
+    if (tables == NULL || tables->N_targets == 0 || tables->N_tracked == 0){
+        return;
+    }
+    const int N_targets = tables->N_targets;
+    const int N_tracked = tables->N_tracked;
+    const int* const targets = tables->targets;
+    const int* const tracked = tables->tracked;
+    struct reb_particle* const ps = sim->particles;
+    const double h = *te_radius;
+    const double inv_h = 1./h;
+    const double h2 = h*h;
+    const int N_buckets = tables->N_buckets;
+    int* const bucket_start = tables->bucket_start;
+    int* const bucket_of = tables->bucket_of;
+    int* const sorted = tables->sorted;
+
+    // Rebuild the spatial hash of tracked particles with a counting sort
+    memset(bucket_start, 0, (N_buckets+1)*sizeof(*bucket_start));
+    for (int j=0; j<N_tracked; j++){
+        const struct reb_particle* const p = &ps[tracked[j]];
+        const int b = rebx_te_bucket(rebx_te_cell(p->x, inv_h), rebx_te_cell(p->y, inv_h), rebx_te_cell(p->z, inv_h), N_buckets);
+        bucket_of[j] = b;
+        bucket_start[b+1]++;
+    }
+    for (int b=0; b<N_buckets; b++){
+        bucket_start[b+1] += bucket_start[b];
+    }
+    for (int j=0; j<N_tracked; j++){
+        sorted[bucket_start[bucket_of[j]]++] = j;
+    }
+    for (int b=N_buckets; b>0; b--){ // filling advanced each start to the end of its bucket. Shift back.
+        bucket_start[b] = bucket_start[b-1];
+    }
+    bucket_start[0] = 0;
+
+    const long long step = tables->step;
+    for (int t=0; t<N_targets; t++){
+        const struct reb_particle* const target = &ps[targets[t]];
+        const int64_t cx = rebx_te_cell(target->x, inv_h);
+        const int64_t cy = rebx_te_cell(target->y, inv_h);
+        const int64_t cz = rebx_te_cell(target->z, inv_h);
+        for (int ix=-1; ix<=1; ix++){
+        for (int iy=-1; iy<=1; iy++){
+        for (int iz=-1; iz<=1; iz++){
+            const int b = rebx_te_bucket(cx+ix, cy+iy, cz+iz, N_buckets);
+            for (int k=bucket_start[b]; k<bucket_start[b+1]; k++){
+                const int j = sorted[k];
+                const struct reb_particle* const p = &ps[tracked[j]];
+                const double dx = p->x - target->x;
+                const double dy = p->y - target->y;
+                const double dz = p->z - target->z;
+                const double r2 = dx*dx + dy*dy + dz*dz;
+                if (r2 >= h2){
+                    continue;   // different cell hashed to the same bucket, or just outside te_radius
+                }
+                const size_t pair = (size_t)j*N_targets + t;
+                if (tables->last_step[pair] < step - 1){ // wasn't inside te_radius last step, so this is a new encounter
+                    tables->count[pair]++;
+                }
+                tables->last_step[pair] = step; // also guards against double counting if two neighbor cells share a bucket
+                const double r = sqrt(r2);
+                if (r < tables->min_distance[pair]){
+                    tables->min_distance[pair] = r;
+                }
+            }
+        }
+        }
+        }
+    }
+    tables->step++;
+}
+
+static struct rebx_te_tables* rebx_te_check_tables(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_te_tables* tables = rebx_get_param(rebx, operator->ap, "te_tables");
+    if (tables == NULL){
+        rebx_error(rebx, "REBOUNDx Error: track_encounters tables not found. Operator must be added and the simulation integrated before tables can be read.\n");
+    }
+    return tables;
+}
+
+int rebx_track_encounters_N_targets(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_te_tables* tables = rebx_get_param(rebx, operator->ap, "te_tables");
+    return tables == NULL ? 0 : tables->N_targets;
+}
+
+int rebx_track_encounters_N_tracked(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_te_tables* tables = rebx_get_param(rebx, operator->ap, "te_tables");
+    return tables == NULL ? 0 : tables->N_tracked;
+}
+
+void rebx_track_encounters_min_distances(struct rebx_extras* const rebx, struct rebx_operator* const operator, double* const min_distances){
+    struct rebx_te_tables* tables = rebx_te_check_tables(rebx, operator);
+    if (tables == NULL){
+        return;
+    }
+    memcpy(min_distances, tables->min_distance, (size_t)tables->N_targets*tables->N_tracked*sizeof(*min_distances));
+}
+
+void rebx_track_encounters_counts(struct rebx_extras* const rebx, struct rebx_operator* const operator, int* const counts){
+    struct rebx_te_tables* tables = rebx_te_check_tables(rebx, operator);
+    if (tables == NULL){
+        return;
+    }
+    memcpy(counts, tables->count, (size_t)tables->N_targets*tables->N_tracked*sizeof(*counts));
+}
+
+void rebx_track_encounters_indices(struct rebx_extras* const rebx, struct rebx_operator* const operator, int* const tracked, int* const targets){
+    struct rebx_te_tables* tables = rebx_te_check_tables(rebx, operator);
+    if (tables == NULL){
+        return;
+    }
+    memcpy(tracked, tables->tracked, tables->N_tracked*sizeof(*tracked));
+    memcpy(targets, tables->targets, tables->N_targets*sizeof(*targets));
+}
@@ -0,0 +1,360 @@
+/**
+ * @file    track_events.c
+ * @brief   Log interpolated particle states at events (pericenter passages, node crossings, resonant angle crossings).
+ * @author  Dan Tamayo <tamayo.daniel@gmail.com>
+ *
+ * @section     LICENSE
+ * Copyright (c) 2015 Dan Tamayo, Hanno Rein
+ *
+ * This file is part of reboundx.
+ *
+ * reboundx is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * reboundx is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with rebound.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * $$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$
+ *
+ * $Miscellaneous Utilities$     // Effect category (must be the first non-blank line after dollar signs and between dollar signs to be detected by script).
+ *
+ * ======================= ===============================================
+ * Authors                 D. Tamayo
+ * Implementation Paper    `Tamayo, Rein, Shi and Hernandez, 2019 <https://ui.adsabs.harvard.edu/abs/2020MNRAS.491.2885T/abstract>`_.
+ * Based on                None
+ * C Example               :ref:`c_example_track_events`
+ * Python Example          None
+ * ======================= ===============================================
+ *
+ * Records particle states at events rather than at fixed output intervals. ``ev_events`` is a bitmask of the built-in events to detect
+ * for every particle relative to the primary (particles[0]):
+ *
+ * =============================== ===== =======================================================================
+ * Event (C enum)                  Value Condition
+ * =============================== ===== =======================================================================
+ * REBX_EVENT_PERICENTER           1     r.v changes sign from negative to positive
+ * REBX_EVENT_APOCENTER            2     r.v changes sign from positive to negative
+ * REBX_EVENT_ASCENDING_NODE       4     z changes sign from negative to positive
+ * REBX_EVENT_DESCENDING_NODE      8     z changes sign from positive to negative
+ * REBX_EVENT_RESONANCE            16    Resonant angle (see below) crosses zero (in either direction)
+ * =============================== ===== =======================================================================
+ *
+ * In Python the values are available in the ``reboundx.events`` dictionary. For resonance events, set ``ev_res_partner`` on a particle to the index
+ * of the other body in the resonance. The resonant angle is (p+q)*l_outer - p*l_inner - q*pomega, where the particle with the lower index
+ * is taken as the inner one and pomega is the longitude of pericenter of the particle holding the parameters.
+ *
+ * Each step, the event functions are compared to their values at the end of the previous step. When one changes sign, the particle trajectories
+ * are interpolated across the step with cubic Hermite polynomials (from positions and velocities at both ends), the crossing time is found by root finding
+ * on the interpolant, and the interpolated state of the particle is logged. At most one event of each type per particle is detected per step, so
+ * the timestep should be shorter than half an orbit. The first step after the operator is added (or after the number of particles changes) only stores states.
+ *
+ * Each event is a record with the time, particle index, event type, and the particle's (x, y, z, vx, vy, vz) in the simulation frame
+ * (struct rebx_event, 64 bytes). Records are kept in memory and can be copied out with rebx_track_events_get (Extras.track_events in Python,
+ * which returns a numpy structured array). If a file is set with rebx_track_events_set_file, records are instead appended to that file in large blocks
+ * as raw struct rebx_event records, which can be loaded with numpy.fromfile(filename, dtype=reboundx.event_dtype). Call rebx_track_events_flush
+ * (also called when the operator is freed) to write out any remaining records.
+ *
+ * **Effect Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * ev_events (int)              Yes         Bitmask of events to detect (see above)
+ * ============================ =========== ==================================================================
+ *
+ * **Particle Parameters**
+ *
+ * ============================ =========== ==================================================================
+ * Field (C type)               Required    Description
+ * ============================ =========== ==================================================================
+ * ev_res_partner (int)         No          Index of other particle in resonance for REBX_EVENT_RESONANCE
+ * ev_res_p (int)               No          p in resonant angle (default 1)
+ * ev_res_q (int)               No          q in resonant angle (default 1)
+ * ============================ =========== ==================================================================
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "rebound.h"
+#include "reboundx.h"
+#include "core.h"
+#include "rebxtools.h"
+
+#define REBX_EV_BLOCK 4096      // Number of records buffered before writing to file
+
+struct rebx_ev_state{
+    int N;                      // Number of particles in prev
+    double t;                   // Time of prev
+    struct reb_particle* prev;  // Particle states at end of previous step
+    double* phi_prev;           // Resonant angles at end of previous step (NAN if not tracked)
+    int N_events;               // Number of records in buffer
+    int N_allocated;
+    struct rebx_event* events;  // Records not yet written to file
+    char* filename;             // File to append records to, or NULL to keep them in memory
+};
+
+static void rebx_ev_write(struct rebx_extras* const rebx, struct rebx_ev_state* const state){
+    if (state->filename == NULL || state->N_events == 0){
+        return;
+    }
+    FILE* of = fopen(state->filename, "ab");
+    if (of == NULL){
+        rebx_error(rebx, "REBOUNDx Error: Can not open track_events file.\n");
+        return;
+    }
+    fwrite(state->events, sizeof(*state->events), state->N_events, of);
+    fclose(of);
+    state->N_events = 0;
+}
+
+static void rebx_ev_free_arrays(struct rebx_extras* rebx, struct rebx_operator* operator){
+    struct rebx_ev_state* state = rebx_get_param(rebx, operator->ap, "ev_state");
+    if (state == NULL){
+        return;
+    }
+    rebx_ev_write(rebx, state);
+    free(state->prev);
+    free(state->phi_prev);
+    free(state->events);
+    free(state->filename);
+    free(state);
+}
+
+static struct rebx_ev_state* rebx_ev_get_state(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_ev_state* state = rebx_get_param(rebx, operator->ap, "ev_state");
+    if (state == NULL){
+        state = calloc(1, sizeof(*state));
+        if (state == NULL){
+            rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for track_events.\n");
+            return NULL;
+        }
+        rebx_set_param_pointer(rebx, &operator->ap, "ev_state", state);
+        rebx_set_param_pointer(rebx, &operator->ap, "free_arrays", rebx_ev_free_arrays);
+    }
+    return state;
+}
+
+static void rebx_ev_log(struct rebx_extras* const rebx, struct rebx_ev_state* const state, const double t, const int index, const int type, const struct reb_particle p){
+    if (state->N_events == state->N_allocated){
+        if (state->filename != NULL){
+            rebx_ev_write(rebx, state);
+        }
+        if (state->N_events == state->N_allocated){ // in memory (or write failed). Grow buffer
+            const int N_allocated = state->N_allocated ? 2*state->N_allocated : REBX_EV_BLOCK;
+            struct rebx_event* const events = realloc(state->events, N_allocated*sizeof(*events));
+            if (events == NULL){
+                rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for track_events. Event dropped.\n");
+                return;
+            }
+            state->events = events;
+            state->N_allocated = N_allocated;
+        }
+    }
+    state->events[state->N_events++] = (struct rebx_event){.t=t, .index=index, .type=type, .x=p.x, .y=p.y, .z=p.z, .vx=p.vx, .vy=p.vy, .vz=p.vz};
+}
+
+// Interpolation context shared by the event functions
+struct rebx_ev_args{
+    double G;
+    double h;
+    struct reb_particle p0, p1;             // Particle at start and end of step
+    struct reb_particle primary0, primary1; // Primary at start and end of step
+    struct reb_particle partner0, partner1; // Resonant partner at start and end of step
+    int inner;                              // 1 if particle is the inner body in the resonance
+    int p, q;
+};
+
+static inline struct reb_particle rebx_ev_relative(const struct reb_particle p, const struct reb_particle primary){
+    struct reb_particle rel = p;
+    rel.x -= primary.x; rel.y -= primary.y; rel.z -= primary.z;
+    rel.vx -= primary.vx; rel.vy -= primary.vy; rel.vz -= primary.vz;
+    return rel;
+}
+
+static double rebx_ev_rdotv(const double s, void* const args){
+    const struct rebx_ev_args* const a = args;
+    const struct reb_particle rel = rebx_ev_relative(rebx_hermite_interpolate(a->p0, a->p1, a->h, s), rebx_hermite_interpolate(a->primary0, a->primary1, a->h, s));
+    return rel.x*rel.vx + rel.y*rel.vy + rel.z*rel.vz;
+}
+
+static double rebx_ev_z(const double s, void* const args){
+    const struct rebx_ev_args* const a = args;
+    return rebx_hermite_interpolate(a->p0, a->p1, a->h, s).z - rebx_hermite_interpolate(a->primary0, a->primary1, a->h, s).z;
+}
+
+static inline double rebx_ev_wrap(const double phi){
+    return phi - 2.*M_PI*round(phi/(2.*M_PI)); // to [-pi, pi]
+}
+
+static inline double rebx_ev_resonant_angle(const struct reb_orbit* const o, const struct reb_orbit* const partner, const int inner, const int p, const int q){
+    const double l_inner = inner ? o->l : partner->l;
+    const double l_outer = inner ? partner->l : o->l;
+    return rebx_ev_wrap((p+q)*l_outer - p*l_inner - q*o->pomega);
+}
+
+static double rebx_ev_phi(const double s, void* const args){
+    const struct rebx_ev_args* const a = args;
+    const struct reb_particle primary = rebx_hermite_interpolate(a->primary0, a->primary1, a->h, s);
+    const struct reb_orbit o = reb_orbit_from_particle(a->G, rebx_hermite_interpolate(a->p0, a->p1, a->h, s), primary);
+    const struct reb_orbit partner = reb_orbit_from_particle(a->G, rebx_hermite_interpolate(a->partner0, a->partner1, a->h, s), primary);
+    return rebx_ev_resonant_angle(&o, &partner, a->inner, a->p, a->q);
+}
+
+static void rebx_ev_locate(struct rebx_extras* const rebx, struct rebx_ev_state* const state, struct rebx_ev_args* const args, double (*g)(const double s, void* const args), const double g0, const double g1, const int index, const int type){
+    const double s = rebx_find_root(g, args, g0, g1);
+    rebx_ev_log(rebx, state, state->t + s*args->h, index, type, rebx_hermite_interpolate(args->p0, args->p1, args->h, s));
+}
+
+void rebx_track_events(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
+    struct rebx_extras* const rebx = sim->extras;
+    const int* const ev_events = rebx_get_param(rebx, operator->ap, "ev_events");
+    if (ev_events == NULL){
+        reb_simulation_error(sim, "REBOUNDx Error: Need to set ev_events parameter on track_events operator.\n");
+        return;
+    }
+    struct rebx_ev_state* const state = rebx_ev_get_state(rebx, operator);
+    if (state == NULL){
+        return;
+    }
+    const int N_real = sim->N - sim->N_var;
+    struct reb_particle* const ps = sim->particles;
+    const int events = *ev_events;
+
+    const struct reb_orbit* orbits = NULL;
+    if (events & REBX_EVENT_RESONANCE){
+        orbits = rebx_heliocentric_orbits(rebx);
+        if (orbits == NULL){
+            return;
+        }
+    }
+
+    const double h = sim->t - state->t;
+    const int have_prev = (state->N == N_real && state->prev != NULL && h != 0.);
+    if (state->N != N_real){
+        struct reb_particle* const prev = realloc(state->prev, N_real*sizeof(*prev));
+        if (prev != NULL){
+            state->prev = prev;
+        }
+        double* const phi_prev = realloc(state->phi_prev, N_real*sizeof(*phi_prev));
+        if (phi_prev != NULL){
+            state->phi_prev = phi_prev;
+        }
+        if (N_real > 0 && (prev == NULL || phi_prev == NULL)){
+            rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for track_events.\n");
+            state->N = -1; // stored states no longer match the particles
+            return;
+        }
+        state->N = N_real;
+    }
+
+    struct rebx_ev_args args = {.G=sim->G, .h=h};
+    if (have_prev){
+        args.primary0 = state->prev[0];
+        args.primary1 = ps[0];
+    }
+    for (int i=1; i<N_real; i++){
+        double phi = NAN;
+        int res_partner = -1;
+        int res_p = 1;
+        int res_q = 1;
+        if (events & REBX_EVENT_RESONANCE){
+            const int* const partner = rebx_get_param(rebx, ps[i].ap, "ev_res_partner");
+            if (partner != NULL && *partner > 0 && *partner < N_real && *partner != i){
+                const int* const p = rebx_get_param(rebx, ps[i].ap, "ev_res_p");
+                const int* const q = rebx_get_param(rebx, ps[i].ap, "ev_res_q");
+                res_partner = *partner;
+                res_p = p ? *p : 1;
+                res_q = q ? *q : 1;
+                phi = rebx_ev_resonant_angle(&orbits[i], &orbits[res_partner], i < res_partner, res_p, res_q);
+            }
+        }
+        if (have_prev){
+            args.p0 = state->prev[i];
+            args.p1 = ps[i];
+            const struct reb_particle rel0 = rebx_ev_relative(state->prev[i], state->prev[0]);
+            const struct reb_particle rel1 = rebx_ev_relative(ps[i], ps[0]);
+            if (events & (REBX_EVENT_PERICENTER | REBX_EVENT_APOCENTER)){
+                const double g0 = rel0.x*rel0.vx + rel0.y*rel0.vy + rel0.z*rel0.vz;
+                const double g1 = rel1.x*rel1.vx + rel1.y*rel1.vy + rel1.z*rel1.vz;
+                if ((events & REBX_EVENT_PERICENTER) && g0 < 0. && g1 >= 0.){
+                    rebx_ev_locate(rebx, state, &args, rebx_ev_rdotv, g0, g1, i, REBX_EVENT_PERICENTER);
+                }
+                if ((events & REBX_EVENT_APOCENTER) && g0 > 0. && g1 <= 0.){
+                    rebx_ev_locate(rebx, state, &args, rebx_ev_rdotv, g0, g1, i, REBX_EVENT_APOCENTER);
+                }
+            }
+            if ((events & REBX_EVENT_ASCENDING_NODE) && rel0.z < 0. && rel1.z >= 0.){
+                rebx_ev_locate(rebx, state, &args, rebx_ev_z, rel0.z, rel1.z, i, REBX_EVENT_ASCENDING_NODE);
+            }
+            if ((events & REBX_EVENT_DESCENDING_NODE) && rel0.z > 0. && rel1.z <= 0.){
+                rebx_ev_locate(rebx, state, &args, rebx_ev_z, rel0.z, rel1.z, i, REBX_EVENT_DESCENDING_NODE);
+            }
+            const double phi0 = state->phi_prev[i];
+            // Crossings of zero, not jumps across +-pi when the angle circulates
+            if (!isnan(phi) && !isnan(phi0) && ((phi0 < 0. && phi >= 0.) || (phi0 > 0. && phi <= 0.)) && fabs(phi - phi0) < M_PI){
+                args.partner0 = state->prev[res_partner];
+                args.partner1 = ps[res_partner];
+                args.inner = i < res_partner;
+                args.p = res_p;
+                args.q = res_q;
+                rebx_ev_locate(rebx, state, &args, rebx_ev_phi, phi0, phi, i, REBX_EVENT_RESONANCE);
+            }
+        }
+        state->phi_prev[i] = phi;
+    }
+    memcpy(state->prev, ps, N_real*sizeof(*ps));
+    state->t = sim->t;
+}
+
+void rebx_track_events_set_file(struct rebx_extras* const rebx, struct rebx_operator* const operator, const char* const filename){
+    struct rebx_ev_state* const state = rebx_ev_get_state(rebx, operator);
+    if (state == NULL){
+        return;
+    }
+    rebx_ev_write(rebx, state);
+    free(state->filename);
+    state->filename = NULL;
+    FILE* of = fopen(filename, "wb");
+    if (of == NULL){
+        rebx_error(rebx, "REBOUNDx Error: Can not open track_events file.\n");
+        return;
+    }
+    fclose(of);
+    state->filename = rebx_malloc(rebx, strlen(filename) + 1); // +1 for \0 at end
+    if (state->filename == NULL){
+        return;
+    }
+    strcpy(state->filename, filename);
+    rebx_ev_write(rebx, state); // records so far go to the new file
+}
+
+void rebx_track_events_flush(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_ev_state* const state = rebx_get_param(rebx, operator->ap, "ev_state");
+    if (state == NULL){
+        return;
+    }
+    rebx_ev_write(rebx, state);
+}
+
+int rebx_track_events_N(struct rebx_extras* const rebx, struct rebx_operator* const operator){
+    struct rebx_ev_state* const state = rebx_get_param(rebx, operator->ap, "ev_state");
+    return state == NULL ? 0 : state->N_events;
+}
+
+void rebx_track_events_get(struct rebx_extras* const rebx, struct rebx_operator* const operator, struct rebx_event* const events){
+    struct rebx_ev_state* const state = rebx_get_param(rebx, operator->ap, "ev_state");
+    if (state == NULL){
+        return;
+    }
+    memcpy(events, state->events, state->N_events*sizeof(*events));
+}
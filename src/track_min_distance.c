@@ -36,9 +36,20 @@
  * For a given particle, this keeps track of that particle's minimum distance from another body in the simulation.  User
  * should add parameters to the particular particle whose distance should be tracked.
  *
+ * By default distances are only sampled at the end of each timestep, so with timesteps comparable to the duration of a flyby the true
+ * minimum can be missed. Setting the ``min_distance_dense_output`` parameter on the operator reconstructs the relative motion of each
+ * tracked pair across the step with a cubic Hermite interpolant (matching relative positions and velocities at both ends of the step),
+ * and finds the minimum separation within the step. ``min_distance_orbit`` is then evaluated from the interpolated state at that minimum.
+ * The interpolation error scales as dt^4, so close approaches are captured accurately as long as the relative trajectory is smooth over a step
+ * (e.g., fast flybys), without having to shrink the timestep.
+ *
  * **Effect Parameters**
  * 
- * *None*
+ * ================================ =========== =======================================================
+ * Name (C type)                    Required    Description
+ * ================================ =========== =======================================================
+ * min_distance_dense_output (int)  No          If set to 1, find minima within each step by interpolation
+ * ================================ =========== =======================================================
  * 
  * **Particle Parameters**
  * 
@@ -62,10 +73,65 @@
 #include <math.h>
 #include "rebound.h"
 #include "reboundx.h"
+#include "core.h"
+
+// Relative states of each tracked pair at the end of the previous call, for dense output
+struct rebx_tmd_dense{
+    int N;                      // Number of particles when states were stored
+    double t;                   // Time at which states were stored
+    struct reb_particle* rel;   // Relative state (particle - source) for each particle index. m<0 flags no stored state
+};
+
+static void rebx_tmd_free_arrays(struct rebx_extras* rebx, struct rebx_operator* operator){
+    struct rebx_tmd_dense* dense = rebx_get_param(rebx, operator->ap, "min_distance_dense");
+    if (dense != NULL){
+        free(dense->rel);
+        free(dense);
+    }
+}
+
+static struct rebx_tmd_dense* rebx_tmd_get_dense(struct rebx_extras* const rebx, struct rebx_operator* const operator, const int N){
+    struct rebx_tmd_dense* dense = rebx_get_param(rebx, operator->ap, "min_distance_dense");
+    if (dense == NULL){
+        dense = rebx_malloc(rebx, sizeof(*dense));
+        if (dense == NULL){
+            return NULL;
+        }
+        dense->N = -1;
+        dense->t = 0.;
+        dense->rel = NULL;
+        rebx_set_param_pointer(rebx, &operator->ap, "min_distance_dense", dense);
+        rebx_set_param_pointer(rebx, &operator->ap, "free_arrays", rebx_tmd_free_arrays);
+    }
+    if (dense->N != N){ // first call or particles added/removed. Can't match previous states to particles, so start over.
+        struct reb_particle* const rel = realloc(dense->rel, N*sizeof(*rel));
+        if (rel == NULL && N > 0){
+            rebx_error(rebx, "REBOUNDx Error: Could not allocate memory for track_min_distance dense output.\n");
+            return NULL;
+        }
+        dense->rel = rel;
+        for (int i=0; i<N; i++){
+            dense->rel[i].m = -1.;
+        }
+        dense->N = N;
+    }
+    return dense;
+}
 
 void rebx_track_min_distance(struct reb_simulation* const sim, struct rebx_operator* const operator, const double dt){
     struct rebx_extras* const rebx = sim->extras;
     const int N = sim->N - sim->N_var;
+    const int* const dense_output = rebx_get_param(rebx, operator->ap, "min_distance_dense_output");
+    struct rebx_tmd_dense* dense = NULL;
+    double h = 0.;
+    if (dense_output != NULL && *dense_output){
+        dense = rebx_tmd_get_dense(rebx, operator, N);
+        if (dense == NULL){
+            return;
+        }
+        h = sim->t - dense->t;
+        dense->t = sim->t;
+    }
     for(int i=0; i<N; i++){
         struct reb_particle* const p = &sim->particles[i];
         double* min_distance = rebx_get_param(rebx, p->ap, "min_distance");
@@ -81,6 +147,32 @@ void rebx_track_min_distance(struct reb_simulation* const sim, struct rebx_opera
             const double dx = p->x-source->x;
             const double dy = p->y-source->y;
             const double dz = p->z-source->z;
+            if (dense != NULL){
+                struct reb_particle rel = {0};
+                rel.x = dx;
+                rel.y = dy;
+                rel.z = dz;
+                rel.vx = p->vx-source->vx;
+                rel.vy = p->vy-source->vy;
+                rel.vz = p->vz-source->vz;
+                rel.m = p->m;
+                const struct reb_particle rel0 = dense->rel[i];
+                dense->rel[i] = rel;
+                if (rel0.m >= 0. && h != 0.){
+                    double s;
+                    const double d = rebx_hermite_min_distance(rel0, rel, h, &s);
+                    if (d < *min_distance){
+                        *min_distance = d;
+                        struct reb_orbit* const orbit = rebx_get_param(rebx, p->ap, "min_distance_orbit");
+                        if (orbit != NULL){
+                            struct reb_particle primary = {0}; // orbit only depends on relative state and masses
+                            primary.m = source->m;
+                            *orbit = reb_orbit_from_particle(sim->G, rebx_hermite_interpolate(rel0, rel, h, s), primary);
+                        }
+                    }
+                    continue;
+                }
+            }
             const double r2 = dx*dx + dy*dy + dz*dz;
             if (r2 < *min_distance*(*min_distance)){
                 *min_distance = sqrt(r2);
@@ -92,4 +184,3 @@ void rebx_track_min_distance(struct reb_simulation* const sim, struct rebx_opera
         }
     }
 }
-